@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/*** q[vmۂ̉񐔂𐔂 ***/
+// O[o operator new uāAXbhƂɊmۂ̉񐔂𐔂(t[̏ŊmۂĂȂ̊mFɎg)B
+// u̓vOŜ 1 ɂȂ̂ŁAALLOCATION_COUNTER_IMPLEMENTATION `Ă
+// CN[h|P(main.cpp)ł`BENABLE_ALLOCATION_COUNTER  0 ɂƒuȂB
+//   uint64_t before = AllocationCounter::count();
+//   ...
+//   uint64_t allocations = AllocationCounter::count() - before;
+//   { AllocationCounter::Exempt exempt; ... }  // Ȃ(1 bƂ̏oȂ)
+
+#ifndef ENABLE_ALLOCATION_COUNTER
+#define ENABLE_ALLOCATION_COUNTER 1
+#endif
+
+class AllocationCounter
+{
+private:
+	struct ThreadState
+	{
+		uint64_t count = 0;
+		uint32_t exemptDepth = 0;
+	};
+
+	static ThreadState& state()
+	{
+		thread_local ThreadState threadState;
+		return threadState;
+	}
+
+public:
+	static constexpr bool enabled() { return ENABLE_ALLOCATION_COUNTER != 0; }
+
+	// ĂяoXbhł́A܂ł̊mۂ̉
+	static uint64_t count() { return state().count; }
+
+	static void recordAllocation()
+	{
+		ThreadState& threadState = state();
+		if (threadState.exemptDepth == 0) threadState.count++;
+	}
+
+	// Ă󂷂܂ł̊mۂ͐Ȃ
+	class Exempt
+	{
+	public:
+		Exempt() { state().exemptDepth++; }
+		~Exempt() { state().exemptDepth--; }
+
+		Exempt(const Exempt&) = delete;
+		Exempt& operator=(const Exempt&) = delete;
+	};
+};
+
+#if ENABLE_ALLOCATION_COUNTER && defined(ALLOCATION_COUNTER_IMPLEMENTATION)
+
+namespace allocation_counter_detail
+{
+	inline void* allocate(std::size_t size)
+	{
+		AllocationCounter::recordAllocation();
+		void* pointer = std::malloc(size == 0 ? 1 : size);
+		if (pointer == nullptr) throw std::bad_alloc();
+		return pointer;
+	}
+
+	inline void* allocateAligned(std::size_t size, std::size_t alignment)
+	{
+		AllocationCounter::recordAllocation();
+		if (size == 0) size = 1;
+#ifdef _MSC_VER
+		void* pointer = _aligned_malloc(size, alignment);
+#else
+		void* pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+		if (pointer == nullptr) throw std::bad_alloc();
+		return pointer;
+	}
+
+	inline void freeAligned(void* pointer)
+	{
+#ifdef _MSC_VER
+		_aligned_free(pointer);
+#else
+		std::free(pointer);
+#endif
+	}
+}
+
+void* operator new(std::size_t size) { return allocation_counter_detail::allocate(size); }
+void* operator new[](std::size_t size) { return allocation_counter_detail::allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try { return allocation_counter_detail::allocate(size); }
+	catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	try { return allocation_counter_detail::allocate(size); }
+	catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return allocation_counter_detail::allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return allocation_counter_detail::allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	try { return allocation_counter_detail::allocateAligned(size, static_cast<std::size_t>(alignment)); }
+	catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	try { return allocation_counter_detail::allocateAligned(size, static_cast<std::size_t>(alignment)); }
+	catch (...) { return nullptr; }
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { allocation_counter_detail::freeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { allocation_counter_detail::freeAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { allocation_counter_detail::freeAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { allocation_counter_detail::freeAligned(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { allocation_counter_detail::freeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { allocation_counter_detail::freeAligned(pointer); }
+
+#endif // ENABLE_ALLOCATION_COUNTER && ALLOCATION_COUNTER_IMPLEMENTATION
@@ -0,0 +1,584 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "FrameCapture.h"
+#include "FramePacket.h"
+#include "GpuTimeline.h"
+#include "GpuUploader.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
+#include "PipelineLayoutCache.h"
+#include "PipelinePermutation.h"
+#include "ShaderLibrary.h"
+#include "SpirvReflection.h"
+#include "VulkanHandle.h"
+#include "DebugLabels.h"
+
+/*** NX^[CeBO ***/
+// ʂ̃^CƉs̃XCXŕNX^[ƂɁAdȂ郉Cg̈ꗗRs[gVF[_[
+// (shaders/cluster_lights.comp)Ŗt[BtOgVF[_[͎̃NX^[̈ꗗ΂悢̂ŁA
+// CgĂ 1 sNZŒׂ̂͐`\ɂȂ( shaders/include/clustered_lighting.glsl)B
+// U蕪̓Rs[g̃L[ɑAOtBbNX̃t[͂̊tOgVF[_[̑Oő҂B
+// Lv`̃t[ł́ACg̓]ƐU蕪̃fBXpb` FrameCaptureWriter ɂL^B
+//   TimelinePoint lighting = clusterer.bin<Path::TIMELINE_SEMAPHORE>(frameSlot, packet.camera, packet.lights, packet.lightCount);
+//   graphicsTimeline.submit(commandBuffers, { lighting }, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+// r[Ԃ̓_(VF[_[ ClusterLight Ɠ)
+struct ClusterLight
+{
+	float position[3];
+	float radius;
+	float color[3];
+	float intensity;
+};
+
+// cluster_lights.comp ̃vbV萔
+struct ClusterParameters
+{
+	float tanHalfFovX;
+	float tanHalfFovY;
+	float nearZ;
+	float farZ;
+	uint32_t lightCount;
+};
+
+// NX^[̕ƁACPU ł̐U蕪(QƎBx`}[N GPU ̌ʂƔׂ)
+namespace LightClusterGrid
+{
+	// shaders/include/clustered_lighting.glsl Ɠlɂ邱
+	constexpr uint32_t TILES_X = 16;
+	constexpr uint32_t TILES_Y = 9;
+	constexpr uint32_t SLICES = 24;
+	constexpr uint32_t CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+	constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+	constexpr uint32_t WORKGROUP_SIZE = 64;// cluster_lights.comp  local_size_x_id(ꉻ萔 0)ɓn
+
+	inline ClusterParameters parameters(const Camera& camera, uint32_t lightCount)
+	{
+		float tanHalfFovY = std::tan(camera.fovY * 0.5f);
+		return { tanHalfFovY * camera.aspect, tanHalfFovY, camera.nearZ, camera.farZ, lightCount };
+	}
+
+	// [hWr[(J_A+z OA+y )ւ̕ϊ
+	// Simulation ̃J yaw  Y ܂ɉ񂵂ĂApitch ŉ(pitch Ȃ牺)
+	class ViewTransform
+	{
+	private:
+		Float3 eye_;
+		float sinYaw_, cosYaw_, sinPitch_, cosPitch_;
+
+	public:
+		explicit ViewTransform(const Camera& camera)
+			: eye_(camera.position), sinYaw_(std::sin(camera.yaw)), cosYaw_(std::cos(camera.yaw)),
+			sinPitch_(std::sin(camera.pitch)), cosPitch_(std::cos(camera.pitch)) {}
+
+		ClusterLight apply(const PointLight& light) const
+		{
+			float dx = light.position.x - eye_.x;
+			float dy = light.position.y - eye_.y;
+			float dz = light.position.z - eye_.z;
+			float x = dx * cosYaw_ - dz * sinYaw_;
+			float z = dx * sinYaw_ + dz * cosYaw_;
+			return { { x, dy * cosPitch_ + z * sinPitch_, -dy * sinPitch_ + z * cosPitch_ }, light.radius,
+				{ light.color.x, light.color.y, light.color.z }, light.intensity };
+		}
+	};
+
+	inline float sliceDepth(uint32_t slice, const ClusterParameters& p)
+	{
+		return p.nearZ * std::pow(p.farZ / p.nearZ, static_cast<float>(slice) / SLICES);
+	}
+
+	// cluster ̃r[Ԃ AABB(VF[_[ƓvZ)
+	inline void bounds(uint32_t cluster, const ClusterParameters& p, float boundsMin[3], float boundsMax[3])
+	{
+		uint32_t tileX = cluster % TILES_X;
+		uint32_t tileY = (cluster / TILES_X) % TILES_Y;
+		uint32_t slice = std::min(cluster / (TILES_X * TILES_Y), SLICES - 1);
+		float sliceNear = sliceDepth(slice, p);
+		float sliceFar = sliceDepth(slice + 1, p);
+		float scaleMin[2] = { (-1.0f + 2.0f * tileX / TILES_X) * p.tanHalfFovX, (1.0f - 2.0f * (tileY + 1) / TILES_Y) * p.tanHalfFovY };
+		float scaleMax[2] = { (-1.0f + 2.0f * (tileX + 1) / TILES_X) * p.tanHalfFovX, (1.0f - 2.0f * tileY / TILES_Y) * p.tanHalfFovY };
+		for (int i = 0; i < 2; i++) {
+			boundsMin[i] = std::min(scaleMin[i] * sliceNear, scaleMin[i] * sliceFar);
+			boundsMax[i] = std::max(scaleMax[i] * sliceNear, scaleMax[i] * sliceFar);
+		}
+		boundsMin[2] = sliceNear;
+		boundsMax[2] = sliceFar;
+	}
+
+	// (a radiusScale {) AABB dȂ邩
+	inline bool intersects(const ClusterLight& light, const float boundsMin[3], const float boundsMax[3], float radiusScale = 1.0f)
+	{
+		float distanceSquared = 0.0f;
+		for (int i = 0; i < 3; i++) {
+			float offset = light.position[i] - std::clamp(light.position[i], boundsMin[i], boundsMax[i]);
+			distanceSquared += offset * offset;
+		}
+		float radius = light.radius * radiusScale;
+		return distanceSquared <= radius * radius;
+	}
+
+	// GPU Ɠ`ŐU蕪(counts  CLUSTER_COUNT Aindices  CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER )
+	// NX^[ AABB ͍ŏɂ܂Ƃ߂ċ߂ĂACgƂɉsŏdȂ肤XCX̒ŁA
+	// (x)ƍs(y)͈̔͂ƏdȂNX^[𒲂ׂ
+	inline void bin(const ClusterLight* lights, const ClusterParameters& p, uint32_t* counts, uint32_t* indices, float radiusScale = 1.0f)
+	{
+		std::vector<float> clusterBounds(CLUSTER_COUNT * 6);// NX^[Ƃɍŏ xyzAő xyz
+		for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+			bounds(cluster, p, &clusterBounds[cluster * 6], &clusterBounds[cluster * 6 + 3]);
+		}
+		std::fill(counts, counts + CLUSTER_COUNT, 0u);
+
+		float logDepthRange = std::log(p.farZ / p.nearZ);
+		auto sliceOf = [&](float z) {
+			float slice = std::log(std::max(z, p.nearZ) / p.nearZ) / logDepthRange * SLICES;
+			return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(SLICES - 1)));
+		};
+
+		for (uint32_t light = 0; light < p.lightCount; light++) {
+			const ClusterLight& l = lights[light];
+			float radius = l.radius * radiusScale;
+			if (l.position[2] + radius < p.nearZ || p.farZ < l.position[2] - radius) continue;
+
+			// ۂߌ덷ŋẼXCX𗎂ƂȂ悤ɁAO 1 L
+			uint32_t firstSlice = sliceOf(l.position[2] - radius);
+			uint32_t lastSlice = std::min(sliceOf(l.position[2] + radius) + 1, SLICES - 1);
+			firstSlice = 0 < firstSlice ? firstSlice - 1 : 0;
+			for (uint32_t slice = firstSlice; slice <= lastSlice; slice++) {
+				//  x ͈͍̔͂sɂ炸As y ͈̔͂͗ɂȂ(ǂցE֐iނقǏ)
+				const float* sliceBounds = &clusterBounds[slice * TILES_X * TILES_Y * 6];
+				uint32_t firstColumn = 0;
+				uint32_t lastColumn = TILES_X;
+				while (firstColumn < TILES_X && sliceBounds[firstColumn * 6 + 3] < l.position[0] - radius) firstColumn++;
+				while (firstColumn < lastColumn && l.position[0] + radius < sliceBounds[(lastColumn - 1) * 6]) lastColumn--;
+				uint32_t firstRow = 0;
+				uint32_t lastRow = TILES_Y;
+				while (firstRow < TILES_Y && l.position[1] + radius < sliceBounds[firstRow * TILES_X * 6 + 1]) firstRow++;
+				while (firstRow < lastRow && sliceBounds[(lastRow - 1) * TILES_X * 6 + 4] < l.position[1] - radius) lastRow--;
+
+				for (uint32_t row = firstRow; row < lastRow; row++) {
+					for (uint32_t column = firstColumn; column < lastColumn; column++) {
+						uint32_t cluster = (slice * TILES_Y + row) * TILES_X + column;
+						if (!intersects(l, &clusterBounds[cluster * 6], &clusterBounds[cluster * 6 + 3], radiusScale)) continue;
+						if (counts[cluster] < MAX_LIGHTS_PER_CLUSTER) indices[cluster * MAX_LIGHTS_PER_CLUSTER + counts[cluster]] = light;
+						counts[cluster]++;
+					}
+				}
+			}
+		}
+	}
+}
+
+class LightClusterer
+{
+private:
+	struct Buffer
+	{
+		UniqueBuffer buffer;
+		UniqueDeviceMemory memory;
+		uint32_t memoryType = 0;
+		VkDeviceSize allocationSize = 0;
+	};
+
+	struct Slot
+	{
+		Buffer staging;	// CPU r[Ԃ̃Cg(ƃ}bvĂ)
+		Buffer lights;	// ȉ̓Rs[gVF[_[AtOgVF[_[ǂ
+		Buffer counts;
+		Buffer indices;
+		ClusterLight* mapped = nullptr;
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		uint64_t submittedValue = 0;// ̃XbgōŌɑU蕪
+	};
+
+	VkDevice device_ = VK_NULL_HANDLE;
+	MemoryBudgetMonitor* memoryBudget_ = nullptr;
+	QueueTimeline* timeline_ = nullptr;
+	FrameCaptureWriter* capture_ = nullptr;
+	std::vector<uint32_t> queueFamilies_;// 2 ΃obt@𗼕̃L[ŋL
+	uint32_t maxLights_ = 0;
+	std::vector<Slot> slots_;
+	UniqueCommandPool commandPool_;
+	UniqueDescriptorPool descriptorPool_;
+	// cluster_lights.comp ̓ꉻ萔
+	using WorkgroupSizeConstant = SpecConstant<0, uint32_t>;
+	using PipelineKey = PermutationKey<WorkgroupSizeConstant>;
+	static constexpr size_t MAX_PIPELINES = 2;
+
+	const PipelineLayoutCache::Layout* layout_ = nullptr;
+	PipelineKey pipelineKey_;
+	PipelinePermutationCache<PipelineKey> pipelines_{ MAX_PIPELINES };
+	std::vector<VkCommandBuffer> submit_ = std::vector<VkCommandBuffer>(1);// MƂɊmۂȂ悤Ɏg
+
+	MetricsRegistry::Gauge lightCountMetric_ = MetricsRegistry::instance().gauge(
+		"app_clustered_lights", "Lights binned into clusters for the last frame.");
+
+public:
+	LightClusterer() = default;
+	~LightClusterer() { finalize(); }
+
+	LightClusterer(const LightClusterer&) = delete;
+	LightClusterer& operator=(const LightClusterer&) = delete;
+
+	// timeline  computeFamily ̃L[̂́BgraphicsFamily Ⴆ΁Aʂ̃obt@͗̃L[g悤ɍ
+	// frameCount ̓t[̃Xbg̐( GPU Ŏgꂤt[̐)
+	void initialize(VkDevice device, MemoryBudgetMonitor* memoryBudget, FrameCaptureWriter* capture, QueueTimeline* timeline,
+		uint32_t computeFamily, uint32_t graphicsFamily, uint32_t frameCount, uint32_t maxLights,
+		VkPipelineCache pipelineCache, const ShaderLibrary& shaders, PipelineLayoutCache& pipelineLayouts)
+	{
+		device_ = device;
+		memoryBudget_ = memoryBudget;
+		capture_ = capture;
+		timeline_ = timeline;
+		maxLights_ = maxLights;
+		queueFamilies_ = { computeFamily };
+		if (graphicsFamily != computeFamily) queueFamilies_.push_back(graphicsFamily);
+
+		createPipeline(pipelineCache, shaders, pipelineLayouts);
+		createCommandBuffers(computeFamily, frameCount);
+		createDescriptorSets(frameCount);
+
+		VkDeviceSize lightSize = static_cast<VkDeviceSize>(maxLights) * sizeof(ClusterLight);
+		VkDeviceSize countSize = LightClusterGrid::CLUSTER_COUNT * sizeof(uint32_t);
+		VkDeviceSize indexSize = countSize * LightClusterGrid::MAX_LIGHTS_PER_CLUSTER;
+		VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		for (Slot& slot : slots_) {
+			slot.staging = createBuffer(lightSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, false);
+			slot.lights = createBuffer(lightSize, storage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+			slot.counts = createBuffer(countSize, storage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+			slot.indices = createBuffer(indexSize, storage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+			void* mapped;
+			if (vkMapMemory(device_, slot.staging.memory.get(), 0, lightSize, 0, &mapped) != VK_SUCCESS) {
+				throw std::runtime_error("failed to map light staging buffer!");
+			}
+			slot.mapped = static_cast<ClusterLight*>(mapped);
+			capture_->createBuffer(slot.staging.buffer.get(), lightSize);
+			capture_->createBuffer(slot.lights.buffer.get(), lightSize);
+			capture_->createBuffer(slot.counts.buffer.get(), countSize);
+			capture_->createBuffer(slot.indices.buffer.get(), indexSize);
+			DEBUG_NAME(device_, slot.staging.buffer.get(), "light staging");
+			DEBUG_NAME(device_, slot.lights.buffer.get(), "cluster lights");
+			DEBUG_NAME(device_, slot.counts.buffer.get(), "cluster light counts");
+			DEBUG_NAME(device_, slot.indices.buffer.get(), "cluster light indices");
+
+			// obt@͍蒼Ȃ̂ŁAfXNv^͍ŏ 1 x
+			VkDescriptorBufferInfo bufferInfos[3] = {
+				{ slot.lights.buffer.get(), 0, VK_WHOLE_SIZE },
+				{ slot.counts.buffer.get(), 0, VK_WHOLE_SIZE },
+				{ slot.indices.buffer.get(), 0, VK_WHOLE_SIZE },
+			};
+			VkWriteDescriptorSet writes[3] = {};
+			for (uint32_t binding = 0; binding < 3; binding++) {
+				writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writes[binding].dstSet = slot.descriptorSet;
+				writes[binding].dstBinding = binding;
+				writes[binding].descriptorCount = 1;
+				writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writes[binding].pBufferInfo = &bufferInfos[binding];
+			}
+			vkUpdateDescriptorSets(device_, 3, writes, 0, nullptr);
+		}
+	}
+
+	// Xbg̃obt@gAS GPU ŏIĂĂԂ
+	void finalize()
+	{
+		for (Slot& slot : slots_) {
+			for (Buffer* buffer : { &slot.staging, &slot.lights, &slot.counts, &slot.indices }) {
+				if (buffer->memory) memoryBudget_->trackFree(buffer->memoryType, buffer->allocationSize);
+				if (buffer->buffer) capture_->destroyBuffer(buffer->buffer.get());
+			}
+		}
+		slots_.clear();// }bv͉ƈꏏɊO
+		pipelines_.clear();
+		descriptorPool_.reset();
+		commandPool_.reset();// R}hobt@܂Ƃ߂ĉ
+		layout_ = nullptr;// CAEg PipelineLayoutCache j
+	}
+
+	uint32_t maxLights() const { return maxLights_; }
+
+	// tOgVF[_[ǂރobt@(clustered_lighting.glsl  lightsEclusterCountsEclusterIndices)
+	// VF[_[RpCƂɃpCvC蒼
+	// ÂpCvC deletionQueue ɗa retireValue ܂Őiłj(U蕪̌ʂ҂^CC̒ln)
+	// oCfBOςĂƊmۍς݂̃fXNv^ZbggȂ̂ŁA蒼ɗO𓊂
+	void reloadPipeline(const ShaderLibrary& shaders, PipelineLayoutCache& pipelineLayouts, DeletionQueue& deletionQueue, uint64_t retireValue)
+	{
+		std::vector<uint32_t> code = shaders.loadSpirv("cluster_lights.comp");
+		if (&pipelineLayouts.get(SpirvReflector::reflect(code)) != layout_) {
+			throw std::runtime_error("cluster_lights.comp changed its bindings!");
+		}
+		pipelines_.reload(pipelineFactory(std::move(code)), pipelineKey_, deletionQueue, retireValue);
+	}
+
+	VkBuffer lightBuffer(uint32_t slot) const { return slots_[slot].lights.buffer.get(); }
+	VkBuffer clusterCountBuffer(uint32_t slot) const { return slots_[slot].counts.buffer.get(); }
+	VkBuffer clusterIndexBuffer(uint32_t slot) const { return slots_[slot].indices.buffer.get(); }
+
+	// camera 猩Cg slot ̃obt@ɐU蕪鏈𑗂ÅԂ(maxLights() 𒴂Cg͎gȂ)
+	// Xbg̑O̐U蕪Î҂Ă珑(ʂ̓OtBbNX̃t[҂_ŏIĂ)
+	template <bool UseTimelineSemaphore>
+	TimelinePoint bin(uint32_t slot, const Camera& camera, const PointLight* lights, uint32_t lightCount)
+	{
+		Slot& s = slots_[slot];
+		timeline_->wait<UseTimelineSemaphore>(s.submittedValue);
+
+		lightCount = std::min(lightCount, maxLights_);
+		LightClusterGrid::ViewTransform view(camera);
+		for (uint32_t i = 0; i < lightCount; i++) s.mapped[i] = view.apply(lights[i]);
+		ClusterParameters parameters = LightClusterGrid::parameters(camera, lightCount);
+
+		VkCommandBuffer commandBuffer = s.commandBuffer;
+		vkResetCommandBuffer(commandBuffer, 0);
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+		{
+			DEBUG_CMD_LABEL(commandBuffer, "light binning");
+			if (0 < lightCount) {
+				VkBufferCopy region = {};
+				region.size = static_cast<VkDeviceSize>(lightCount) * sizeof(ClusterLight);
+				vkCmdCopyBuffer(commandBuffer, s.staging.buffer.get(), s.lights.buffer.get(), 1, &region);
+				if (capture_->isCapturing()) {
+					capture_->uploadBuffer(s.staging.buffer.get(), 0, s.mapped, static_cast<size_t>(region.size));
+					capture_->copyBuffer(s.staging.buffer.get(), s.lights.buffer.get(), region);
+				}
+
+				VkMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					0, 1, &barrier, 0, nullptr, 0, nullptr);
+			}
+
+			// NX^[̐̓[NO[v̑傫Ŋ؂
+			static_assert(LightClusterGrid::CLUSTER_COUNT % LightClusterGrid::WORKGROUP_SIZE == 0);
+			VkPipeline pipeline = pipelines_.get(pipelineKey_);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout_->pipelineLayout, 0, 1, &s.descriptorSet, 0, nullptr);
+			vkCmdPushConstants(commandBuffer, layout_->pipelineLayout, layout_->pushConstantRange.stageFlags,
+				0, sizeof(ClusterParameters), &parameters);
+			vkCmdDispatch(commandBuffer, LightClusterGrid::CLUSTER_COUNT / LightClusterGrid::WORKGROUP_SIZE, 1, 1);
+			if (capture_->isCapturing()) {
+				capture_->dispatch(pipeline, { s.lights.buffer.get(), s.counts.buffer.get(), s.indices.buffer.get() },
+					&parameters, sizeof(ClusterParameters), LightClusterGrid::CLUSTER_COUNT / LightClusterGrid::WORKGROUP_SIZE, 1, 1);
+			}
+		}
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record light binning command buffer!");
+		}
+		submit_[0] = commandBuffer;
+		s.submittedValue = timeline_->submit<UseTimelineSemaphore>(submit_);
+		lightCountMetric_.set(static_cast<double>(lightCount));
+		return { timeline_, s.submittedValue };
+	}
+
+	TimelinePoint bin(uint32_t slot, const Camera& camera, const PointLight* lights, uint32_t lightCount)
+	{
+		return timeline_->usesTimelineSemaphore() ? bin<true>(slot, camera, lights, lightCount) : bin<false>(slot, camera, lights, lightCount);
+	}
+
+	// slot ̐U蕪̌ʂǂݏo(I܂ő҂Bm߂邽߂̂̂ŁAt[̒ł͎gȂ)
+	void readBack(uint32_t slot, std::vector<uint32_t>& counts, std::vector<uint32_t>& indices)
+	{
+		Slot& s = slots_[slot];
+		VkDeviceSize countSize = LightClusterGrid::CLUSTER_COUNT * sizeof(uint32_t);
+		VkDeviceSize indexSize = countSize * LightClusterGrid::MAX_LIGHTS_PER_CLUSTER;
+		Buffer readback = createBuffer(countSize + indexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, false);
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = commandPool_.get();
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate light readback command buffer!");
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+		VkBufferCopy countRegion = { 0, 0, countSize };
+		VkBufferCopy indexRegion = { 0, countSize, indexSize };
+		vkCmdCopyBuffer(commandBuffer, s.counts.buffer.get(), readback.buffer.get(), 1, &countRegion);
+		vkCmdCopyBuffer(commandBuffer, s.indices.buffer.get(), readback.buffer.get(), 1, &indexRegion);
+		vkEndCommandBuffer(commandBuffer);
+
+		std::vector<VkCommandBuffer> commandBuffers = { commandBuffer };
+		uint64_t value = timeline_->submit(commandBuffers);
+		timeline_->wait(value);
+		vkFreeCommandBuffers(device_, commandPool_.get(), 1, &commandBuffer);
+
+		void* mapped;
+		if (vkMapMemory(device_, readback.memory.get(), 0, countSize + indexSize, 0, &mapped) != VK_SUCCESS) {
+			throw std::runtime_error("failed to map light readback buffer!");
+		}
+		const uint32_t* data = static_cast<const uint32_t*>(mapped);
+		counts.assign(data, data + LightClusterGrid::CLUSTER_COUNT);
+		indices.assign(data + LightClusterGrid::CLUSTER_COUNT, data + LightClusterGrid::CLUSTER_COUNT * (1 + LightClusterGrid::MAX_LIGHTS_PER_CLUSTER));
+		vkUnmapMemory(device_, readback.memory.get());
+		memoryBudget_->trackFree(readback.memoryType, readback.allocationSize);
+	}
+
+private:
+	// ꉻƂ̃pCvC悤ɂApipelineKey_ ̂̂Ă
+	void createPipeline(VkPipelineCache pipelineCache, const ShaderLibrary& shaders, PipelineLayoutCache& pipelineLayouts)
+	{
+		std::vector<uint32_t> code = shaders.loadSpirv("cluster_lights.comp");
+		layout_ = &pipelineLayouts.get(SpirvReflector::reflect(code));
+		pipelineKey_.set<WorkgroupSizeConstant>(LightClusterGrid::WORKGROUP_SIZE);
+
+		pipelines_.initialize(device_, pipelineCache, timeline_, pipelineFactory(std::move(code)));
+		pipelines_.get(pipelineKey_);
+	}
+
+	PipelinePermutationCache<PipelineKey>::Factory pipelineFactory(std::vector<uint32_t> code)
+	{
+		return [this, code = std::move(code)](VkDevice device, VkPipelineCache cache, const VkSpecializationInfo& specialization) {
+			UniqueShaderModule module = ShaderLibrary::createModule(device, code);
+			VkComputePipelineCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			createInfo.stage.module = module.get();
+			createInfo.stage.pName = "main";
+			createInfo.stage.pSpecializationInfo = &specialization;
+			createInfo.layout = layout_->pipelineLayout;
+
+			VkPipeline handle;
+			if (vkCreateComputePipelines(device, cache, 1, &createInfo, nullptr, &handle) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create light binning pipeline!");
+			}
+			capture_->createComputePipeline(handle, code, &specialization, 3, sizeof(ClusterParameters));
+			DEBUG_NAME(device, handle, "cluster_lights.comp");
+			return handle;
+		};
+	}
+
+	void createCommandBuffers(uint32_t computeFamily, uint32_t frameCount)
+	{
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;// XbgƂɋL^
+		poolInfo.queueFamilyIndex = computeFamily;
+		VkCommandPool pool;
+		if (vkCreateCommandPool(device_, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create light binning command pool!");
+		}
+		commandPool_ = UniqueCommandPool(device_, pool, vkDestroyCommandPool);
+		DEBUG_NAME(device_, pool, "light binning command pool");
+
+		slots_.resize(frameCount);
+		std::vector<VkCommandBuffer> commandBuffers(frameCount);
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = pool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = frameCount;
+		if (vkAllocateCommandBuffers(device_, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate light binning command buffers!");
+		}
+		for (uint32_t i = 0; i < frameCount; i++) {
+			slots_[i].commandBuffer = commandBuffers[i];
+			DEBUG_NAME(device_, commandBuffers[i], "light binning");
+		}
+	}
+
+	void createDescriptorSets(uint32_t frameCount)
+	{
+		VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * frameCount };
+		VkDescriptorPoolCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		createInfo.maxSets = frameCount;
+		createInfo.poolSizeCount = 1;
+		createInfo.pPoolSizes = &poolSize;
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(device_, &createInfo, nullptr, &pool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create light binning descriptor pool!");
+		}
+		descriptorPool_ = UniqueDescriptorPool(device_, pool, vkDestroyDescriptorPool);
+
+		std::vector<VkDescriptorSetLayout> setLayouts(frameCount, layout_->setLayouts[0]);
+		std::vector<VkDescriptorSet> sets(frameCount);
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = pool;
+		allocInfo.descriptorSetCount = frameCount;
+		allocInfo.pSetLayouts = setLayouts.data();
+		if (vkAllocateDescriptorSets(device_, &allocInfo, sets.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate light binning descriptor sets!");
+		}
+		for (uint32_t i = 0; i < frameCount; i++) slots_[i].descriptorSet = sets[i];
+	}
+
+	// shared ȂRs[gƃOtBbNX̗̃L[g(L[t@~[̏L̈ړȂčς)
+	Buffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, bool shared)
+	{
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		if (shared && 1 < queueFamilies_.size()) {
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies_.size());
+			bufferInfo.pQueueFamilyIndices = queueFamilies_.data();
+		}
+		else {
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		}
+
+		VkBuffer buffer;
+		if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create light buffer!");
+		}
+		Buffer result;
+		result.buffer = UniqueBuffer(device_, buffer, vkDestroyBuffer);
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device_, buffer, &requirements);
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = GpuUploader::findMemoryType(memoryBudget_->memoryProperties(), requirements.memoryTypeBits, properties);
+		// U蕪ɕKvȕȂ̂Ō点Ȃ(MyApplication ł̓bṼXg[~OɊmۂA炪cɍ킹)
+		if (!memoryBudget_->fitsInBudget(allocInfo.memoryTypeIndex, allocInfo.allocationSize)) {
+			throw std::runtime_error("light buffers do not fit in the memory budget!");
+		}
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(device_, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate light buffer memory!");
+		}
+		result.memory = UniqueDeviceMemory(device_, memory, vkFreeMemory);
+		result.memoryType = allocInfo.memoryTypeIndex;
+		result.allocationSize = requirements.size;
+		memoryBudget_->trackAllocation(result.memoryType, result.allocationSize);
+		vkBindBufferMemory(device_, buffer, memory, 0);
+		return result;
+	}
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*** vZv~eBűʂ̃C^[tF[X ***/
+// GPU(GpuCompute.h) CPU(CpuCompute.h)œ𓯂ĂѕŎsł悤ɂB
+// vf͑S uint32_tB͌Ă񂾏ɎsAʂ read()  finish() ̌Ŋm肷
+// (GPU ͋L^Ă܂Ƃ߂đACPU ͂̏Ŏs)B
+// obt@͍obNGhłgȂB
+//   std::unique_ptr<ComputeBuffer> keys = backend.createBuffer(count);
+//   backend.write(*keys, data);
+//   backend.radixSort(*keys, *temporary, count);
+//   std::vector<uint32_t> sorted = backend.read(*keys, count);
+
+class ComputeBuffer
+{
+public:
+	virtual ~ComputeBuffer() = default;
+	virtual size_t size() const = 0;// vf
+};
+
+class ComputeBackend
+{
+public:
+	static constexpr uint32_t MAX_HISTOGRAM_BINS = 256;
+
+	virtual ~ComputeBackend() = default;
+
+	virtual const char* name() const = 0;
+	// x`}[NȂǂŕ\ݒ̐
+	virtual std::string description() const { return name(); }
+
+	virtual std::unique_ptr<ComputeBuffer> createBuffer(size_t count) = 0;
+	// data  buffer ̐擪֏
+	virtual void write(ComputeBuffer& buffer, const std::vector<uint32_t>& data) = 0;
+	// buffer ̐擪 count ǂݏo(܂ł̏Î҂)
+	virtual std::vector<uint32_t> read(const ComputeBuffer& buffer, size_t count) = 0;
+	// ܂ł̏SďÎ҂
+	virtual void finish() = 0;
+
+	virtual void copy(const ComputeBuffer& source, ComputeBuffer& destination, size_t count) = 0;
+	// input ̐擪 count ̘a result[0] ɏ
+	virtual void reduce(const ComputeBuffer& input, size_t count, ComputeBuffer& result) = 0;
+	// rIvtBbNXXL(input  output ͓obt@ł悢)
+	virtual void exclusiveScan(const ComputeBuffer& input, ComputeBuffer& output, size_t count) = 0;
+	// (l >> shift) & (binCount - 1) Ƃ̐ bins ɏ(binCount  MAX_HISTOGRAM_BINS ȉ 2 ׂ̂)
+	virtual void histogram(const ComputeBuffer& input, size_t count, ComputeBuffer& bins, uint32_t binCount, uint32_t shift = 0) = 0;
+	// flags  0 łȂvf values Ԃۂ output ɋl߁A̐ outputCount[0] ɏ
+	virtual void compact(const ComputeBuffer& values, const ComputeBuffer& flags, size_t count, ComputeBuffer& output, ComputeBuffer& outputCount) = 0;
+	// keys ̐擪 count A keyBits rbgL[ɂĈɃ\[g(temporary ͓傫̍Ɨp)
+	virtual void radixSort(ComputeBuffer& keys, ComputeBuffer& temporary, size_t count, uint32_t keyBits = 32) = 0;
+
+protected:
+	// ̊mF(ǂ̃obNGhłɂ)
+	static void checkSize(const ComputeBuffer& buffer, size_t count)
+	{
+		if (buffer.size() < count) throw std::runtime_error("compute buffer is too small!");
+		if (UINT32_MAX < count) throw std::runtime_error("too many elements for compute primitives!");
+	}
+
+	static void checkHistogram(uint32_t binCount, uint32_t shift)
+	{
+		if (binCount == 0 || MAX_HISTOGRAM_BINS < binCount || (binCount & (binCount - 1)) != 0) {
+			throw std::runtime_error("histogram bin count must be a power of two up to 256!");
+		}
+		if (32 <= shift) throw std::runtime_error("histogram shift is out of range!");
+	}
+
+	static void checkKeyBits(uint32_t keyBits)
+	{
+		if (keyBits == 0 || 32 < keyBits) throw std::runtime_error("radix sort key bits must be 1 to 32!");
+	}
+
+	// ʂ̃obNGhōobt@nꂽOɂ
+	template <typename Buffer>
+	static Buffer& cast(ComputeBuffer& buffer)
+	{
+		Buffer* result = dynamic_cast<Buffer*>(&buffer);
+		if (result == nullptr) throw std::runtime_error("compute buffer belongs to another backend!");
+		return *result;
+	}
+
+	template <typename Buffer>
+	static const Buffer& cast(const ComputeBuffer& buffer)
+	{
+		const Buffer* result = dynamic_cast<const Buffer*>(&buffer);
+		if (result == nullptr) throw std::runtime_error("compute buffer belongs to another backend!");
+		return *result;
+	}
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ComputeBackend.h"
+#include "ComputeReference.h"
+
+/*** vZv~eBũx`}[N ***/
+// ̃f[^Ŋev~eBuobNGh(GpuCompute  CpuCompute)ƎQƎ(ComputeReference.h)ŎsA
+// ԂׂāAʂv邩m߂BԂ iterations ̂ł́B
+// obNGh̎Ԃ͋L^EME҂܂ CPU 猩(^CX^vgȂ̂ lavapipe ł)B
+
+class ComputeBenchmark
+{
+private:
+	struct Result
+	{
+		std::string name;
+		double referenceSeconds = 0.0;
+		double backendSeconds = 0.0;
+		bool matched = false;
+	};
+
+	size_t count_;
+	uint32_t iterations_;
+	std::vector<Result> results_;
+
+public:
+	ComputeBenchmark(size_t count, uint32_t iterations) : count_(count), iterations_(std::max(iterations, 1u)) {}
+
+	// SẴv~eBusĕ\(SĎQƎƈv true)
+	bool run(ComputeBackend& compute, std::ostream& out)
+	{
+		std::mt19937 random(12345);// 񓯂f[^ɂ
+		std::vector<uint32_t> values(count_);
+		std::vector<uint32_t> flags(count_);
+		for (uint32_t& value : values) value = random();
+		for (uint32_t& flag : flags) flag = random() & 1;
+
+		std::unique_ptr<ComputeBuffer> input = compute.createBuffer(count_);
+		std::unique_ptr<ComputeBuffer> flagBuffer = compute.createBuffer(count_);
+		std::unique_ptr<ComputeBuffer> output = compute.createBuffer(count_);
+		std::unique_ptr<ComputeBuffer> temporary = compute.createBuffer(count_);
+		std::unique_ptr<ComputeBuffer> single = compute.createBuffer(1);
+		std::unique_ptr<ComputeBuffer> bins = compute.createBuffer(256);
+		compute.write(*input, values);
+		compute.write(*flagBuffer, flags);
+
+		{
+			uint32_t expected = 0;
+			double reference = measure([&]() { expected = compute_reference::reduce(values); });
+			double backend = measureBackend(compute, []() {}, [&]() { compute.reduce(*input, count_, *single); });
+			add("reduce", reference, backend, compute.read(*single, 1) == std::vector<uint32_t>{ expected });
+		}
+		{
+			std::vector<uint32_t> expected;
+			double reference = measure([&]() { expected = compute_reference::exclusiveScan(values); });
+			double backend = measureBackend(compute, []() {}, [&]() { compute.exclusiveScan(*input, *output, count_); });
+			add("exclusive scan", reference, backend, compute.read(*output, count_) == expected);
+		}
+		{
+			std::vector<uint32_t> expected;
+			double reference = measure([&]() { expected = compute_reference::histogram(values, 256, 0); });
+			double backend = measureBackend(compute, []() {}, [&]() { compute.histogram(*input, count_, *bins, 256); });
+			add("histogram (256 bins)", reference, backend, compute.read(*bins, 256) == expected);
+		}
+		{
+			std::vector<uint32_t> expected;
+			double reference = measure([&]() { expected = compute_reference::compact(values, flags); });
+			double backend = measureBackend(compute, []() {}, [&]() { compute.compact(*input, *flagBuffer, count_, *output, *single); });
+			std::vector<uint32_t> kept = compute.read(*single, 1);
+			std::vector<uint32_t> result = compute.read(*output, count_);
+			result.resize(std::min<size_t>(kept[0], count_));
+			add("stream compaction", reference, backend, kept[0] == expected.size() && result == expected);
+		}
+		{
+			std::vector<uint32_t> expected;
+			double reference = measure([&]() { expected = compute_reference::radixSort(values); });
+			// \[g͂̏ŕבւ̂ŁA񌳂̃f[^Rs[Ă瑪
+			double backend = measureBackend(compute,
+				[&]() { compute.copy(*input, *output, count_); },
+				[&]() { compute.radixSort(*output, *temporary, count_); });
+			add("radix sort (32 bit)", reference, backend, compute.read(*output, count_) == expected);
+		}
+
+		printReport(compute, out);
+		return std::all_of(results_.begin(), results_.end(), [](const Result& result) { return result.matched; });
+	}
+
+private:
+	template <typename Function>
+	double measure(Function function) const
+	{
+		double best = std::numeric_limits<double>::max();
+		for (uint32_t i = 0; i < iterations_; i++) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	// prepare ŋL^͑OɑďI点Ă
+	template <typename Prepare, typename Record>
+	double measureBackend(ComputeBackend& compute, Prepare prepare, Record record) const
+	{
+		return measure([&]() {
+			prepare();
+			compute.finish();
+			record();
+			compute.finish();
+		});
+	}
+
+	void add(const std::string& name, double referenceSeconds, double backendSeconds, bool matched)
+	{
+		results_.push_back({ name, referenceSeconds, backendSeconds, matched });
+	}
+
+	void printReport(const ComputeBackend& compute, std::ostream& out) const
+	{
+		out << "backend: " << compute.description() << ", elements: " << count_ << std::endl;
+
+		out << std::fixed << std::setprecision(3);
+		out << std::left << std::setw(22) << "primitive" << std::right << std::setw(14) << "reference(ms)"
+			<< std::setw(14) << "backend(ms)" << std::setw(14) << "Melem/s" << "  result" << std::endl;
+		for (const Result& result : results_) {
+			out << std::left << std::setw(22) << result.name << std::right
+				<< std::setw(14) << result.referenceSeconds * 1000.0
+				<< std::setw(14) << result.backendSeconds * 1000.0
+				<< std::setw(14) << static_cast<double>(count_) / result.backendSeconds / 1.0e6
+				<< "  " << (result.matched ? "ok" : "MISMATCH") << std::endl;
+		}
+	}
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/*** vZv~eBu CPU ł̎QƎ ***/
+// GpuCompute ̌ʂ̊mFƁAx`}[N̔rΏۂɎgB₷D悵ĂB
+// l͑S uint32_t ŁAa 2^32 Ő܂Ԃ(GPU Ɠ)B
+
+namespace compute_reference
+{
+	// Svf̘a
+	inline uint32_t reduce(const std::vector<uint32_t>& values)
+	{
+		uint32_t sum = 0;
+		for (uint32_t value : values) sum += value;
+		return sum;
+	}
+
+	// rIvtBbNXXL(results[i]  values[0]  values[i - 1] ܂ł̘a)
+	inline std::vector<uint32_t> exclusiveScan(const std::vector<uint32_t>& values)
+	{
+		std::vector<uint32_t> results(values.size());
+		uint32_t sum = 0;
+		for (size_t i = 0; i < values.size(); i++) {
+			results[i] = sum;
+			sum += values[i];
+		}
+		return results;
+	}
+
+	// (l >> shift) & (binCount - 1) Ƃ̐(binCount  2 ׂ̂)
+	inline std::vector<uint32_t> histogram(const std::vector<uint32_t>& values, uint32_t binCount, uint32_t shift)
+	{
+		if (binCount == 0 || (binCount & (binCount - 1)) != 0) throw std::runtime_error("histogram bin count must be a power of two!");
+		std::vector<uint32_t> bins(binCount);
+		for (uint32_t value : values) bins[(value >> shift) & (binCount - 1)]++;
+		return bins;
+	}
+
+	// flags  0 łȂvf values Ԃۂċl߂
+	inline std::vector<uint32_t> compact(const std::vector<uint32_t>& values, const std::vector<uint32_t>& flags)
+	{
+		std::vector<uint32_t> results;
+		for (size_t i = 0; i < values.size() && i < flags.size(); i++) {
+			if (flags[i] != 0) results.push_back(values[i]);
+		}
+		return results;
+	}
+
+	//  keyBits rbgL[ɂȊ\[g(GPU Ɠ 4 rbg)
+	inline std::vector<uint32_t> radixSort(std::vector<uint32_t> keys, uint32_t keyBits = 32)
+	{
+		const uint32_t RADIX_BITS = 4;
+		const uint32_t RADIX = 1u << RADIX_BITS;
+		std::vector<uint32_t> sorted(keys.size());
+		for (uint32_t shift = 0; shift < keyBits; shift += RADIX_BITS) {
+			uint32_t offsets[RADIX] = {};
+			for (uint32_t key : keys) offsets[(key >> shift) & (RADIX - 1)]++;
+			uint32_t sum = 0;
+			for (uint32_t& offset : offsets) {
+				uint32_t count = offset;
+				offset = sum;
+				sum += count;
+			}
+			for (uint32_t key : keys) sorted[offsets[(key >> shift) & (RADIX - 1)]++] = key;
+			keys.swap(sorted);
+		}
+		return keys;
+	}
+}
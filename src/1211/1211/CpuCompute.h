@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPU_COMPUTE_SSE2
+#endif
+
+#include "ComputeBackend.h"
+#include "WorkerPool.h"
+
+/*** vZv~eBu CPU ł̎ ***/
+// Vulkan ̃foCXƂɁAGpuCompute Ɠ CPU ŎsB
+// f[^`Nɕ WorkerPool ̃XbhŕÃ[v SSE2  4 vf
+// (SSE2 Ƃ͕ʂ̃[v)B͌Ă񂾂̏ŎŝŁAfinish() ł͉ȂB
+
+class CpuBuffer : public ComputeBuffer
+{
+private:
+	std::vector<uint32_t> data_;
+
+public:
+	explicit CpuBuffer(size_t count) : data_(count) {}
+
+	size_t size() const override { return data_.size(); }
+	uint32_t* data() { return data_.data(); }
+	const uint32_t* data() const { return data_.data(); }
+};
+
+class CpuCompute : public ComputeBackend
+{
+private:
+	// 1 `N̍ŏ̗vf(ƃXbhɔzԂ̕傫Ȃ)
+	static constexpr size_t MIN_CHUNK_SIZE = 16384;
+	static constexpr uint32_t RADIX_BITS = 8;
+	static constexpr uint32_t RADIX = 1u << RADIX_BITS;
+
+	WorkerPool pool_;
+
+public:
+	explicit CpuCompute(size_t threadCount = 0) : pool_(threadCount) {}
+
+	const char* name() const override { return "cpu"; }
+	size_t threadCount() const { return pool_.threadCount(); }
+
+	std::string description() const override
+	{
+#ifdef CPU_COMPUTE_SSE2
+		const char* simd = "sse2";
+#else
+		const char* simd = "none";
+#endif
+		return "cpu (threads: " + std::to_string(threadCount()) + ", simd: " + simd + ")";
+	}
+
+	std::unique_ptr<ComputeBuffer> createBuffer(size_t count) override
+	{
+		return std::make_unique<CpuBuffer>(count);
+	}
+
+	void write(ComputeBuffer& buffer, const std::vector<uint32_t>& data) override
+	{
+		checkSize(buffer, data.size());
+		std::copy(data.begin(), data.end(), cast<CpuBuffer>(buffer).data());
+	}
+
+	std::vector<uint32_t> read(const ComputeBuffer& buffer, size_t count) override
+	{
+		checkSize(buffer, count);
+		const uint32_t* data = cast<CpuBuffer>(buffer).data();
+		return std::vector<uint32_t>(data, data + count);
+	}
+
+	void finish() override {}
+
+	/*** vZv~eBu ***/
+	void copy(const ComputeBuffer& source, ComputeBuffer& destination, size_t count) override
+	{
+		checkSize(source, count);
+		checkSize(destination, count);
+		const uint32_t* input = cast<CpuBuffer>(source).data();
+		uint32_t* output = cast<CpuBuffer>(destination).data();
+		if (input == output) return;
+		forEachChunk(count, [&](size_t, size_t begin, size_t end) {
+			std::memcpy(output + begin, input + begin, (end - begin) * sizeof(uint32_t));
+		});
+	}
+
+	void reduce(const ComputeBuffer& input, size_t count, ComputeBuffer& result) override
+	{
+		checkSize(input, count);
+		checkSize(result, 1);
+		const uint32_t* values = cast<CpuBuffer>(input).data();
+		std::vector<uint32_t> sums(chunkCount(count));
+		forEachChunk(count, [&](size_t chunk, size_t begin, size_t end) {
+			sums[chunk] = sum(values + begin, end - begin);
+		});
+		cast<CpuBuffer>(result).data()[0] = sum(sums.data(), sums.size());
+	}
+
+	void exclusiveScan(const ComputeBuffer& input, ComputeBuffer& output, size_t count) override
+	{
+		checkSize(input, count);
+		checkSize(output, count);
+		const uint32_t* values = cast<CpuBuffer>(input).data();
+		uint32_t* results = cast<CpuBuffer>(output).data();
+
+		// `NƂ̘a߂ĂAe`N̑O܂ł̘an߂ăXL
+		size_t chunks = chunkCount(count);
+		std::vector<uint32_t> offsets(chunks);
+		forEachChunk(count, [&](size_t chunk, size_t begin, size_t end) {
+			offsets[chunk] = sum(values + begin, end - begin);
+		});
+		uint32_t total = 0;
+		for (uint32_t& offset : offsets) {
+			uint32_t chunkSum = offset;
+			offset = total;
+			total += chunkSum;
+		}
+		forEachChunk(count, [&](size_t chunk, size_t begin, size_t end) {
+			scan(values + begin, results + begin, end - begin, offsets[chunk]);
+		});
+	}
+
+	void histogram(const ComputeBuffer& input, size_t count, ComputeBuffer& bins, uint32_t binCount, uint32_t shift = 0) override
+	{
+		checkHistogram(binCount, shift);
+		checkSize(input, count);
+		checkSize(bins, binCount);
+		const uint32_t* values = cast<CpuBuffer>(input).data();
+
+		// `NƂɐĂ瑫킹(ɏ܂Ȃ̂œvȂ)
+		size_t chunks = chunkCount(count);
+		std::vector<uint32_t> local(chunks * binCount);
+		forEachChunk(count, [&](size_t chunk, size_t begin, size_t end) {
+			// 鏊̓[J̔zɂ(͂Ɠ^̃|C^ƁAʖ̉\ĖǂݒɂȂ)
+			uint32_t counts[MAX_HISTOGRAM_BINS] = {};
+			for (size_t i = begin; i < end; i++) counts[(values[i] >> shift) & (binCount - 1)]++;
+			std::copy(counts, counts + binCount, local.data() + chunk * binCount);
+		});
+		uint32_t* results = cast<CpuBuffer>(bins).data();
+		std::fill(results, results + binCount, 0u);
+		for (size_t chunk = 0; chunk < chunks; chunk++) {
+			for (uint32_t bin = 0; bin < binCount; bin++) results[bin] += local[chunk * binCount + bin];
+		}
+	}
+
+	void compact(const ComputeBuffer& values, const ComputeBuffer& flags, size_t count, ComputeBuffer& output, ComputeBuffer& outputCount) override
+	{
+		checkSize(values, count);
+		checkSize(flags, count);
+		checkSize(output, count);
+		checkSize(outputCount, 1);
+		const uint32_t* input = cast<CpuBuffer>(values).data();
+		const uint32_t* keep = cast<CpuBuffer>(flags).data();
+		uint32_t* results = cast<CpuBuffer>(output).data();
+
+		// c`NƂɐȂO܂ł̐珑n߂
+		size_t chunks = chunkCount(count);
+		std::vector<uint32_t> offsets(chunks);
+		forEachChunk(count, [&](size_t chunk, size_t begin, size_t end) {
+			offsets[chunk] = countNonZero(keep + begin, end - begin);
+		});
+		uint32_t total = 0;
+		for (uint32_t& offset : offsets) {
+			uint32_t kept = offset;
+			offset = total;
+			total += kept;
+		}
+		forEachChunk(count, [&](size_t chunk, size_t begin, size_t end) {
+			uint32_t* destination = results + offsets[chunk];
+			for (size_t i = begin; i < end; i++) {
+				if (keep[i] != 0) *destination++ = input[i];
+			}
+		});
+		cast<CpuBuffer>(outputCount).data()[0] = total;
+	}
+
+	void radixSort(ComputeBuffer& keys, ComputeBuffer& temporary, size_t count, uint32_t keyBits = 32) override
+	{
+		checkKeyBits(keyBits);
+		checkSize(keys, count);
+		checkSize(temporary, count);
+		if (&keys == &temporary) throw std::runtime_error("radix sort needs a separate temporary buffer!");
+		uint32_t* source = cast<CpuBuffer>(keys).data();
+		uint32_t* destination = cast<CpuBuffer>(temporary).data();
+
+		// 8 rbgA`NƂ̌̐  ƁE`NƂ݈̏ʒu  ȕבւ
+		size_t chunks = chunkCount(count);
+		std::vector<uint32_t> offsets(chunks * RADIX);
+		for (uint32_t shift = 0; shift < keyBits; shift += RADIX_BITS) {
+			// Ō̌ keyBits 𒴂̃rbgȂ悤ɂ
+			const uint32_t mask = (1u << std::min(RADIX_BITS, keyBits - shift)) - 1;
+			forEachChunk(count, [&](size_t chunk, size_t begin, size_t end) {
+				uint32_t counts[RADIX] = {};
+				for (size_t i = begin; i < end; i++) counts[(source[i] >> shift) & mask]++;
+				std::copy(counts, counts + RADIX, offsets.data() + chunk * RADIX);
+			});
+			uint32_t total = 0;
+			for (uint32_t digit = 0; digit < RADIX; digit++) {
+				for (size_t chunk = 0; chunk < chunks; chunk++) {
+					uint32_t& offset = offsets[chunk * RADIX + digit];
+					uint32_t digitCount = offset;
+					offset = total;
+					total += digitCount;
+				}
+			}
+			forEachChunk(count, [&](size_t chunk, size_t begin, size_t end) {
+				uint32_t positions[RADIX];
+				std::copy(offsets.data() + chunk * RADIX, offsets.data() + (chunk + 1) * RADIX, positions);
+				for (size_t i = begin; i < end; i++) destination[positions[(source[i] >> shift) & mask]++] = source[i];
+			});
+			std::swap(source, destination);
+		}
+		// בւƂ͌ʂ temporary ɂ̂Ŗ߂
+		if (source != cast<CpuBuffer>(keys).data()) copy(temporary, keys, count);
+	}
+
+private:
+	size_t chunkCount(size_t count) const
+	{
+		return std::max<size_t>(1, std::min(count / MIN_CHUNK_SIZE, pool_.threadCount()));
+	}
+
+	// [0, count) `NɕāAfunction(chunk, begin, end) XbhŕČĂ
+	template <typename Function>
+	void forEachChunk(size_t count, Function function)
+	{
+		size_t chunks = chunkCount(count);
+		pool_.run(chunks, [&](size_t chunk) {
+			function(chunk, count * chunk / chunks, count * (chunk + 1) / chunks);
+		});
+	}
+
+	static uint32_t sum(const uint32_t* values, size_t count)
+	{
+		uint32_t result = 0;
+		size_t i = 0;
+#ifdef CPU_COMPUTE_SSE2
+		// Z̈ˑ؂邽߁A4 {̃WX^ɕđ
+		__m128i sums[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+		for (; i + 16 <= count; i += 16) {
+			for (int j = 0; j < 4; j++) {
+				sums[j] = _mm_add_epi32(sums[j], _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + j * 4)));
+			}
+		}
+		__m128i total = _mm_add_epi32(_mm_add_epi32(sums[0], sums[1]), _mm_add_epi32(sums[2], sums[3]));
+		total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(1, 0, 3, 2)));
+		total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(2, 3, 0, 1)));
+		result = static_cast<uint32_t>(_mm_cvtsi128_si32(total));
+#endif
+		for (; i < count; i++) result += values[i];
+		return result;
+	}
+
+	// results[i] = carry + values[0] + ... + values[i - 1](values  results ͓ł悢)
+	static void scan(const uint32_t* values, uint32_t* results, size_t count, uint32_t carry)
+	{
+		size_t i = 0;
+#ifdef CPU_COMPUTE_SSE2
+		// WX^ŕܓIXLĂ 1 炵AO 4 vf܂ł̘a𑫂
+		__m128i running = _mm_set1_epi32(static_cast<int>(carry));
+		for (; i + 4 <= count; i += 4) {
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+			__m128i inclusive = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+			inclusive = _mm_add_epi32(inclusive, _mm_slli_si128(inclusive, 8));
+			__m128i exclusive = _mm_add_epi32(running, _mm_slli_si128(inclusive, 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(results + i), exclusive);
+			running = _mm_add_epi32(running, _mm_shuffle_epi32(inclusive, _MM_SHUFFLE(3, 3, 3, 3)));
+		}
+		carry = static_cast<uint32_t>(_mm_cvtsi128_si32(running));
+#endif
+		for (; i < count; i++) {
+			uint32_t value = values[i];
+			results[i] = carry;
+			carry += value;
+		}
+	}
+
+	static uint32_t countNonZero(const uint32_t* values, size_t count)
+	{
+		uint32_t result = 0;
+		size_t i = 0;
+#ifdef CPU_COMPUTE_SSE2
+		// r 0 ̏ -1 ɂȂ̂ŁA 0 ̐𐔂AŌɑŜ̐
+		__m128i zero = _mm_setzero_si128();
+		__m128i zeros = _mm_setzero_si128();
+		for (; i + 4 <= count; i += 4) {
+			zeros = _mm_sub_epi32(zeros, _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), zero));
+		}
+		zeros = _mm_add_epi32(zeros, _mm_shuffle_epi32(zeros, _MM_SHUFFLE(1, 0, 3, 2)));
+		zeros = _mm_add_epi32(zeros, _mm_shuffle_epi32(zeros, _MM_SHUFFLE(2, 3, 0, 1)));
+		result = static_cast<uint32_t>(i) - static_cast<uint32_t>(_mm_cvtsi128_si32(zeros));
+#endif
+		for (; i < count; i++) result += values[i] != 0 ? 1 : 0;
+		return result;
+	}
+};
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+/*** IuWFNg̖OtƃR}hobt@̃x ***/
+// VK_EXT_debug_utils ō쐬nhɖOtAR}hobt@̋ԂɃxtB
+// Õvt@C(RenderDoc, Nsight Ȃ)̃g[XŁAǂ̃pX̏킩悤ɂȂB
+// x̋Ԃ CPU ̃vt@C̃][ƂĂL^̂ŁACPU  GPU œOɂȂB
+//
+// ENABLE_DEBUG_LABELS  0 ̂Ƃ́A}N͉Ȃ(ftHg NDEBUG łȂΗL)B
+//   DEBUG_NAME(device, handle, "name")   nhɖOt(쐬ƂŁAɕt)
+//   DEBUG_CMD_LABEL(cmd, "name")         XR[v̏I܂łx̋Ԃɂ
+//   PROFILE_ZONE("name")                 XR[v̏I܂ł CPU ̃][ƂċL^
+//   DEBUG_UTILS_INITIALIZE(instance)     g̊֐擾
+//   PROFILE_WRITE_TRACE("path")          CPU ̃][g[Xt@Cɏo
+
+#ifndef ENABLE_DEBUG_LABELS
+#ifdef NDEBUG
+#define ENABLE_DEBUG_LABELS 0
+#else
+#define ENABLE_DEBUG_LABELS 1
+#endif
+#endif
+
+#if ENABLE_DEBUG_LABELS
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*** CPU ̊ȈՃvt@C ***/
+// ][(Ot̋)̊JnEIXbhƂɋL^A
+// Chrome ̃g[X`(chrome://tracing, Perfetto ŊJ)ŏoB
+class CpuProfiler
+{
+private:
+	struct Event
+	{
+		const char* name;	// 񃊃eȂǁAo܂ŐĂ镶
+		int64_t beginMicroseconds;
+		int64_t endMicroseconds;
+	};
+
+	static constexpr size_t MAX_EVENTS_PER_THREAD = 1 << 20;// 𒴂͎̂Ă(Ԃ̎sŃg؂Ȃ悤)
+	static constexpr size_t INITIAL_EVENTS_PER_THREAD = 1 << 16;// L^邽тɔzLȂ悤Aŏɂꂾmۂ
+
+	struct ThreadEvents
+	{
+		uint32_t threadId;
+		std::vector<Event> events;
+	};
+
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<ThreadEvents>> threads_;
+	std::chrono::steady_clock::time_point origin_ = std::chrono::steady_clock::now();
+
+	ThreadEvents& localEvents()
+	{
+		thread_local ThreadEvents* events = nullptr;
+		if (events == nullptr) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			threads_.push_back(std::make_unique<ThreadEvents>());
+			events = threads_.back().get();
+			events->threadId = static_cast<uint32_t>(threads_.size());
+			events->events.reserve(INITIAL_EVENTS_PER_THREAD);
+		}
+		return *events;
+	}
+
+public:
+	static CpuProfiler& instance()
+	{
+		static CpuProfiler profiler;
+		return profiler;
+	}
+
+	int64_t now() const
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin_).count();
+	}
+
+	void record(const char* name, int64_t beginMicroseconds, int64_t endMicroseconds)
+	{
+		std::vector<Event>& events = localEvents().events;
+		if (events.size() < MAX_EVENTS_PER_THREAD) events.push_back({ name, beginMicroseconds, endMicroseconds });
+	}
+
+	// SXbh̋L^o(L^̃XbhƂɌĂԂ)
+	bool writeTrace(const std::string& path)
+	{
+		std::ofstream out(path, std::ios::trunc);
+		if (!out) return false;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		out << "{\"traceEvents\":[";
+		bool first = true;
+		for (const auto& thread : threads_) {
+			for (const Event& event : thread->events) {
+				out << (first ? "\n" : ",\n");
+				first = false;
+				out << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->threadId
+					<< ",\"ts\":" << event.beginMicroseconds << ",\"dur\":" << (event.endMicroseconds - event.beginMicroseconds) << "}";
+			}
+		}
+		out << "\n]}\n";
+		return true;
+	}
+
+	// XR[v̊Ԃ 1 ̃][ƂċL^
+	class Zone
+	{
+	private:
+		const char* name_;
+		int64_t begin_;
+
+	public:
+		explicit Zone(const char* name) : name_(name), begin_(instance().now()) {}
+		~Zone() { instance().record(name_, begin_, instance().now()); }
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+	};
+};
+
+/*** VK_EXT_debug_utils ̊֐ ***/
+class DebugUtils
+{
+private:
+	static inline PFN_vkSetDebugUtilsObjectNameEXT setObjectName_ = nullptr;
+	static inline PFN_vkCmdBeginDebugUtilsLabelEXT cmdBeginLabel_ = nullptr;
+	static inline PFN_vkCmdEndDebugUtilsLabelEXT cmdEndLabel_ = nullptr;
+
+public:
+	// gLȃCX^X֐擾(Ȃ牽Ȃ֐ɂȂ)
+	static void initialize(VkInstance instance)
+	{
+		setObjectName_ = (PFN_vkSetDebugUtilsObjectNameEXT)vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT");
+		cmdBeginLabel_ = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT");
+		cmdEndLabel_ = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT");
+	}
+
+	static void setName(VkDevice device, VkObjectType type, uint64_t handle, const char* name)
+	{
+		if (setObjectName_ == nullptr || handle == 0 || type == VK_OBJECT_TYPE_UNKNOWN) return;
+
+		VkDebugUtilsObjectNameInfoEXT nameInfo = {};
+		nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+		nameInfo.objectType = type;
+		nameInfo.objectHandle = handle;
+		nameInfo.pObjectName = name;
+		setObjectName_(device, &nameInfo);
+	}
+
+	// nȟ^ VkObjectType ߂
+	// (32bit ł͔fBXpb`unhS uint64_t ɂȂʂłȂ̂ŁA64bit ̂)
+	template <typename Handle>
+	static void setName(VkDevice device, Handle handle, const char* name)
+	{
+		setName(device, objectType(handle), (uint64_t)(handle), name);
+	}
+
+	static void beginLabel(VkCommandBuffer commandBuffer, const char* name)
+	{
+		if (cmdBeginLabel_ == nullptr) return;
+
+		VkDebugUtilsLabelEXT label = {};
+		label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+		label.pLabelName = name;
+		cmdBeginLabel_(commandBuffer, &label);
+	}
+
+	static void endLabel(VkCommandBuffer commandBuffer)
+	{
+		if (cmdEndLabel_ != nullptr) cmdEndLabel_(commandBuffer);
+	}
+
+	// R}hobt@̃x CPU ̃][𓯂OœɋL^
+	class ScopedCmdLabel
+	{
+	private:
+		VkCommandBuffer commandBuffer_;
+		CpuProfiler::Zone zone_;
+
+	public:
+		ScopedCmdLabel(VkCommandBuffer commandBuffer, const char* name) : commandBuffer_(commandBuffer), zone_(name)
+		{
+			beginLabel(commandBuffer_, name);
+		}
+		~ScopedCmdLabel() { endLabel(commandBuffer_); }
+
+		ScopedCmdLabel(const ScopedCmdLabel&) = delete;
+		ScopedCmdLabel& operator=(const ScopedCmdLabel&) = delete;
+	};
+
+private:
+	static VkObjectType objectType(VkInstance) { return VK_OBJECT_TYPE_INSTANCE; }
+	static VkObjectType objectType(VkPhysicalDevice) { return VK_OBJECT_TYPE_PHYSICAL_DEVICE; }
+	static VkObjectType objectType(VkDevice) { return VK_OBJECT_TYPE_DEVICE; }
+	static VkObjectType objectType(VkQueue) { return VK_OBJECT_TYPE_QUEUE; }
+	static VkObjectType objectType(VkCommandBuffer) { return VK_OBJECT_TYPE_COMMAND_BUFFER; }
+#if defined(__LP64__) || defined(_WIN64) || (defined(__x86_64__) && !defined(__ILP32__)) || defined(_M_X64) || defined(__ia64) || defined(_M_IA64) || defined(__aarch64__) || defined(__powerpc64__)
+	static VkObjectType objectType(VkSemaphore) { return VK_OBJECT_TYPE_SEMAPHORE; }
+	static VkObjectType objectType(VkFence) { return VK_OBJECT_TYPE_FENCE; }
+	static VkObjectType objectType(VkDeviceMemory) { return VK_OBJECT_TYPE_DEVICE_MEMORY; }
+	static VkObjectType objectType(VkBuffer) { return VK_OBJECT_TYPE_BUFFER; }
+	static VkObjectType objectType(VkImage) { return VK_OBJECT_TYPE_IMAGE; }
+	static VkObjectType objectType(VkImageView) { return VK_OBJECT_TYPE_IMAGE_VIEW; }
+	static VkObjectType objectType(VkShaderModule) { return VK_OBJECT_TYPE_SHADER_MODULE; }
+	static VkObjectType objectType(VkPipelineCache) { return VK_OBJECT_TYPE_PIPELINE_CACHE; }
+	static VkObjectType objectType(VkPipelineLayout) { return VK_OBJECT_TYPE_PIPELINE_LAYOUT; }
+	static VkObjectType objectType(VkPipeline) { return VK_OBJECT_TYPE_PIPELINE; }
+	static VkObjectType objectType(VkDescriptorSetLayout) { return VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT; }
+	static VkObjectType objectType(VkDescriptorPool) { return VK_OBJECT_TYPE_DESCRIPTOR_POOL; }
+	static VkObjectType objectType(VkDescriptorSet) { return VK_OBJECT_TYPE_DESCRIPTOR_SET; }
+	static VkObjectType objectType(VkCommandPool) { return VK_OBJECT_TYPE_COMMAND_POOL; }
+	static VkObjectType objectType(VkSwapchainKHR) { return VK_OBJECT_TYPE_SWAPCHAIN_KHR; }
+#else
+	static VkObjectType objectType(uint64_t) { return VK_OBJECT_TYPE_UNKNOWN; }// ^킩Ȃ̂ŖO͕tȂ
+#endif
+};
+
+#define DEBUG_LABEL_CONCAT_(a, b) a##b
+#define DEBUG_LABEL_CONCAT(a, b) DEBUG_LABEL_CONCAT_(a, b)
+#define DEBUG_NAME(device, handle, name) DebugUtils::setName((device), (handle), (name))
+#define DEBUG_CMD_LABEL(commandBuffer, name) DebugUtils::ScopedCmdLabel DEBUG_LABEL_CONCAT(debugCmdLabel_, __LINE__)((commandBuffer), (name))
+#define PROFILE_ZONE(name) CpuProfiler::Zone DEBUG_LABEL_CONCAT(profileZone_, __LINE__)((name))
+#define DEBUG_UTILS_INITIALIZE(instance) DebugUtils::initialize((instance))
+#define PROFILE_WRITE_TRACE(path) CpuProfiler::instance().writeTrace((path))
+
+#else // ENABLE_DEBUG_LABELS
+
+#define DEBUG_NAME(device, handle, name) ((void)0)
+#define DEBUG_CMD_LABEL(commandBuffer, name) ((void)0)
+#define PROFILE_ZONE(name) ((void)0)
+#define DEBUG_UTILS_INITIALIZE(instance) ((void)0)
+#define PROFILE_WRITE_TRACE(path) ((void)0)
+
+#endif // ENABLE_DEBUG_LABELS
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+
+/*** I񂾃foCX̔\ ***/
+// foCX̑I(rateDeviceSuitability / findQueueFamilies)ƃfoCX̍쐬ŕƂ 1 xL^B
+// t[ʂ鏈́A\͂ƂɃev[gŎ̉̂ dispatchCapabilities()  1 xIсA
+// [v̒ł͋@\̗Lŕ򂵂ȂB
+//   dispatchCapabilities(capabilities, [&](auto path) { runFrames<decltype(path)>(); });
+//   // runFrames ̒: graphicsTimeline_.wait<Path::TIMELINE_SEMAPHORE>(value);
+
+struct DeviceCapabilities
+{
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties properties = {};
+	VkPhysicalDeviceFeatures features = {};
+
+	// L[t@~[
+	std::optional<uint32_t> graphicsFamily;
+	std::optional<uint32_t> asyncComputeFamily;// OtBbNXȂRs[g̃L[(񓯊Rs[gp)
+
+	// foCX̍쐬ɗLɂAۂɎgĂ
+	bool timelineSemaphore = false;	// QueueTimeline ^CCZ}tHg(łȂ΃tFX)
+	bool memoryBudget = false;		// MemoryBudgetMonitor  VK_EXT_memory_budget ̒lg
+
+	bool isDiscrete() const { return properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU; }
+	bool hasAsyncCompute() const { return asyncComputeFamily.has_value(); }
+};
+
+// \͂̑gݍ킹 1 Ԃ(zbgpX̃ev[gɂ)
+template <bool TimelineSemaphore, bool MemoryBudget>
+struct CapabilityPath
+{
+	static constexpr bool TIMELINE_SEMAPHORE = TimelineSemaphore;
+	static constexpr bool MEMORY_BUDGET = MemoryBudget;
+
+	// ̔\͂̑gݍ킹(foCX蒼ɁAIђKvm߂)
+	static bool matches(const DeviceCapabilities& capabilities)
+	{
+		return capabilities.timelineSemaphore == TIMELINE_SEMAPHORE && capabilities.memoryBudget == MEMORY_BUDGET;
+	}
+};
+
+// capabilities ɍ CapabilityPath ɂ function Ă(򂷂̂͂)
+template <typename Function>
+decltype(auto) dispatchCapabilities(const DeviceCapabilities& capabilities, Function&& function)
+{
+	if (capabilities.timelineSemaphore) {
+		if (capabilities.memoryBudget) return function(CapabilityPath<true, true>());
+		return function(CapabilityPath<true, false>());
+	}
+	if (capabilities.memoryBudget) return function(CapabilityPath<false, true>());
+	return function(CapabilityPath<false, false>());
+}
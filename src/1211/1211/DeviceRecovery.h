@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+#include "GpuTimeline.h"
+#include "Metrics.h"
+
+/*** foCXXg̕A ***/
+// DeviceLostError(GpuTimeline.h)󂯂ACX^XƕfoCX͂̂܂܂Ř_foCX牺蒼B
+// foCXɒuĂ̂ rebuild ̒Ŋei initialize() 蒼(bV LOD ͎ɎgꂽƂɓǂݍݒ)B
+// pCvCLbVƃRpCς݂̃VF[_[͋NƓ̂ĝŁA蒼̓RpCōςށB
+// ZԂɉxƂ͒Ȃ̂ƂāADeviceLostError ̂܂ܓB
+//   recovery.recover(error, [&]() { finalizeDevice(); }, [&]() { initializeDevice(); });
+
+class DeviceRecovery
+{
+private:
+	static constexpr size_t MAX_RECOVERIES = 3;// RECOVERY_WINDOW ̊Ԃɂ葽ꂽ߂
+	static constexpr std::chrono::seconds RECOVERY_WINDOW{ 60 };
+	static constexpr std::chrono::milliseconds RECOVERY_BUDGET{ 500 };// 莞Ԃx
+
+	std::deque<std::chrono::steady_clock::time_point> recoveries_;
+
+	MetricsRegistry::Counter deviceLostMetric_ = MetricsRegistry::instance().counter(
+		"gpu_device_lost_total", "Number of VK_ERROR_DEVICE_LOST events.");
+	MetricsRegistry::Histogram recoveryTimeMetric_ = MetricsRegistry::instance().histogram(
+		"gpu_device_recovery_seconds", "Time to rebuild the device after a device loss.",
+		{ 0.05, 0.1, 0.25, 0.5, 1.0, 2.5 });
+
+public:
+	// error 󂯂ɌĂԁBteardown ŌÂfoCXЕtArebuild ō蒼
+	void recover(const DeviceLostError& error, const std::function<void()>& teardown, const std::function<void()>& rebuild)
+	{
+		deviceLostMetric_.add();
+		auto start = std::chrono::steady_clock::now();
+
+		while (!recoveries_.empty() && RECOVERY_WINDOW < start - recoveries_.front()) recoveries_.pop_front();
+		if (MAX_RECOVERIES <= recoveries_.size()) throw error;// 蒼ĂꑱĂ
+		recoveries_.push_back(start);
+		std::cerr << error.what() << " rebuilding the device." << std::endl;
+
+		teardown();
+		rebuild();
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		recoveryTimeMetric_.observe(seconds);
+		if (std::chrono::duration<double>(RECOVERY_BUDGET).count() < seconds) {
+			std::cerr << "device recovery took " << seconds * 1000.0 << " ms (budget: " << RECOVERY_BUDGET.count() << " ms)" << std::endl;
+		}
+	}
+};
@@ -0,0 +1,449 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Json.h"
+
+/*** foCX̃XibvVbg ***/
+// foCX̑I(rateDeviceSuitability / findQueueFamilies)ƁAvZ̐ݒ̌Ō܂Ƃ߂ JSON ɏoB
+// 茳ɖq GPU łAoĂt@Cǂ߂΁AIݒ̌ItCŎB
+//   std::vector<DeviceSnapshot> snapshots = { DeviceSnapshot::capture(physicalDevice) };
+//   DeviceSnapshot::save("devices.json", snapshots);
+//   PhysicalDeviceView view(DeviceSnapshot::load("devices.json")[0]);  // {̃foCXƓ悤ɖ₢킹
+
+// o(ỐAɂ)
+#define DEVICE_SNAPSHOT_LIMITS(X) \
+	X(maxImageDimension1D) X(maxImageDimension2D) X(maxImageDimension3D) X(maxImageDimensionCube) X(maxImageArrayLayers) \
+	X(maxTexelBufferElements) X(maxUniformBufferRange) X(maxStorageBufferRange) X(maxPushConstantsSize) X(maxMemoryAllocationCount) \
+	X(maxSamplerAllocationCount) X(bufferImageGranularity) X(sparseAddressSpaceSize) X(maxBoundDescriptorSets) \
+	X(maxPerStageDescriptorSamplers) X(maxPerStageDescriptorUniformBuffers) X(maxPerStageDescriptorStorageBuffers) \
+	X(maxPerStageDescriptorSampledImages) X(maxPerStageDescriptorStorageImages) X(maxPerStageDescriptorInputAttachments) \
+	X(maxPerStageResources) X(maxDescriptorSetSamplers) X(maxDescriptorSetUniformBuffers) X(maxDescriptorSetUniformBuffersDynamic) \
+	X(maxDescriptorSetStorageBuffers) X(maxDescriptorSetStorageBuffersDynamic) X(maxDescriptorSetSampledImages) \
+	X(maxDescriptorSetStorageImages) X(maxDescriptorSetInputAttachments) X(maxVertexInputAttributes) X(maxVertexInputBindings) \
+	X(maxVertexInputAttributeOffset) X(maxVertexInputBindingStride) X(maxVertexOutputComponents) X(maxTessellationGenerationLevel) \
+	X(maxTessellationPatchSize) X(maxTessellationControlPerVertexInputComponents) X(maxTessellationControlPerVertexOutputComponents) \
+	X(maxTessellationControlPerPatchOutputComponents) X(maxTessellationControlTotalOutputComponents) \
+	X(maxTessellationEvaluationInputComponents) X(maxTessellationEvaluationOutputComponents) X(maxGeometryShaderInvocations) \
+	X(maxGeometryInputComponents) X(maxGeometryOutputComponents) X(maxGeometryOutputVertices) X(maxGeometryTotalOutputComponents) \
+	X(maxFragmentInputComponents) X(maxFragmentOutputAttachments) X(maxFragmentDualSrcAttachments) X(maxFragmentCombinedOutputResources) \
+	X(maxComputeSharedMemorySize) X(maxComputeWorkGroupCount) X(maxComputeWorkGroupInvocations) X(maxComputeWorkGroupSize) \
+	X(subPixelPrecisionBits) X(subTexelPrecisionBits) X(mipmapPrecisionBits) X(maxDrawIndexedIndexValue) X(maxDrawIndirectCount) \
+	X(maxSamplerLodBias) X(maxSamplerAnisotropy) X(maxViewports) X(maxViewportDimensions) X(viewportBoundsRange) X(viewportSubPixelBits) \
+	X(minMemoryMapAlignment) X(minTexelBufferOffsetAlignment) X(minUniformBufferOffsetAlignment) X(minStorageBufferOffsetAlignment) \
+	X(minTexelOffset) X(maxTexelOffset) X(minTexelGatherOffset) X(maxTexelGatherOffset) X(minInterpolationOffset) X(maxInterpolationOffset) \
+	X(subPixelInterpolationOffsetBits) X(maxFramebufferWidth) X(maxFramebufferHeight) X(maxFramebufferLayers) \
+	X(framebufferColorSampleCounts) X(framebufferDepthSampleCounts) X(framebufferStencilSampleCounts) \
+	X(framebufferNoAttachmentsSampleCounts) X(maxColorAttachments) X(sampledImageColorSampleCounts) X(sampledImageIntegerSampleCounts) \
+	X(sampledImageDepthSampleCounts) X(sampledImageStencilSampleCounts) X(storageImageSampleCounts) X(maxSampleMaskWords) \
+	X(timestampComputeAndGraphics) X(timestampPeriod) X(maxClipDistances) X(maxCullDistances) X(maxCombinedClipAndCullDistances) \
+	X(discreteQueuePriorities) X(pointSizeRange) X(lineWidthRange) X(pointSizeGranularity) X(lineWidthGranularity) X(strictLines) \
+	X(standardSampleLocations) X(optimalBufferCopyOffsetAlignment) X(optimalBufferCopyRowPitchAlignment) X(nonCoherentAtomSize)
+
+#define DEVICE_SNAPSHOT_SPARSE_PROPERTIES(X) \
+	X(residencyStandard2DBlockShape) X(residencyStandard2DMultisampleBlockShape) X(residencyStandard3DBlockShape) \
+	X(residencyAlignedMipSize) X(residencyNonResidentStrict)
+
+#define DEVICE_SNAPSHOT_FEATURES(X) \
+	X(robustBufferAccess) X(fullDrawIndexUint32) X(imageCubeArray) X(independentBlend) X(geometryShader) X(tessellationShader) \
+	X(sampleRateShading) X(dualSrcBlend) X(logicOp) X(multiDrawIndirect) X(drawIndirectFirstInstance) X(depthClamp) X(depthBiasClamp) \
+	X(fillModeNonSolid) X(depthBounds) X(wideLines) X(largePoints) X(alphaToOne) X(multiViewport) X(samplerAnisotropy) \
+	X(textureCompressionETC2) X(textureCompressionASTC_LDR) X(textureCompressionBC) X(occlusionQueryPrecise) X(pipelineStatisticsQuery) \
+	X(vertexPipelineStoresAndAtomics) X(fragmentStoresAndAtomics) X(shaderTessellationAndGeometryPointSize) X(shaderImageGatherExtended) \
+	X(shaderStorageImageExtendedFormats) X(shaderStorageImageMultisample) X(shaderStorageImageReadWithoutFormat) \
+	X(shaderStorageImageWriteWithoutFormat) X(shaderUniformBufferArrayDynamicIndexing) X(shaderSampledImageArrayDynamicIndexing) \
+	X(shaderStorageBufferArrayDynamicIndexing) X(shaderStorageImageArrayDynamicIndexing) X(shaderClipDistance) X(shaderCullDistance) \
+	X(shaderFloat64) X(shaderInt64) X(shaderInt16) X(shaderResourceResidency) X(shaderResourceMinLod) X(sparseBinding) \
+	X(sparseResidencyBuffer) X(sparseResidencyImage2D) X(sparseResidencyImage3D) X(sparseResidency2Samples) X(sparseResidency4Samples) \
+	X(sparseResidency8Samples) X(sparseResidency16Samples) X(sparseResidencyAliased) X(variableMultisampleRate) X(inheritedQueries)
+
+struct DeviceSnapshot
+{
+	static constexpr uint32_t FORMAT_VERSION = 1;
+
+	VkPhysicalDeviceProperties properties = {};
+	VkPhysicalDeviceFeatures features = {};
+	VkPhysicalDeviceSubgroupProperties subgroup = {};// sType  pNext ͎gȂ
+	VkBool32 timelineSemaphore = VK_FALSE;// VK_KHR_timeline_semaphore  timelineSemaphore
+	VkPhysicalDeviceMemoryProperties memoryProperties = {};
+	std::vector<VkQueueFamilyProperties> queueFamilies;
+	std::vector<VkExtensionProperties> extensions;
+
+	bool hasExtension(const char* name) const
+	{
+		for (const VkExtensionProperties& extension : extensions) {
+			if (strcmp(extension.extensionName, name) == 0) return true;
+		}
+		return false;
+	}
+
+	static DeviceSnapshot capture(VkPhysicalDevice physicalDevice)
+	{
+		DeviceSnapshot snapshot;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &snapshot.features);
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &snapshot.memoryProperties);
+
+		VkPhysicalDeviceProperties2 properties2 = {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &snapshot.subgroup;
+		snapshot.subgroup.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+		snapshot.properties = properties2.properties;
+		snapshot.subgroup.pNext = nullptr;
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		snapshot.queueFamilies.resize(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, snapshot.queueFamilies.data());
+
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		snapshot.extensions.resize(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, snapshot.extensions.data());
+
+		if (snapshot.hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) {
+			VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+			timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+			VkPhysicalDeviceFeatures2 features2 = {};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &timelineFeatures;
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+			snapshot.timelineSemaphore = timelineFeatures.timelineSemaphore;
+		}
+		return snapshot;
+	}
+
+	static void save(const std::string& path, const std::vector<DeviceSnapshot>& snapshots)
+	{
+		std::ofstream out(path, std::ios::trunc);
+		if (!out) throw std::runtime_error("failed to open device snapshot file for writing!");
+
+		JsonWriter writer(out);
+		writer.beginObject();
+		writer.field("version", FORMAT_VERSION);
+		writer.key("devices");
+		writer.beginArray();
+		for (const DeviceSnapshot& snapshot : snapshots) snapshot.write(writer);
+		writer.endArray();
+		writer.endObject();
+		if (!out) throw std::runtime_error("failed to write device snapshot file!");
+	}
+
+	static std::vector<DeviceSnapshot> load(const std::string& path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in) throw std::runtime_error("failed to open device snapshot file!");
+		std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+		JsonValue root = JsonValue::parse(text);
+		if (FORMAT_VERSION < root["version"].asUint()) throw std::runtime_error("device snapshot file is from a newer version!");
+
+		std::vector<DeviceSnapshot> snapshots;
+		for (const JsonValue& device : root["devices"].elements) snapshots.push_back(read(device));
+		return snapshots;
+	}
+
+private:
+	void write(JsonWriter& writer) const
+	{
+		writer.beginObject();
+
+		writer.key("properties");
+		writer.beginObject();
+		writer.field("deviceName", properties.deviceName);
+		writer.field("apiVersion", properties.apiVersion);
+		writer.field("driverVersion", properties.driverVersion);
+		writer.field("vendorID", properties.vendorID);
+		writer.field("deviceID", properties.deviceID);
+		writer.field("deviceType", static_cast<uint32_t>(properties.deviceType));
+		writer.field("pipelineCacheUUID", toHex(properties.pipelineCacheUUID, VK_UUID_SIZE));
+		writer.key("limits");
+		writer.beginObject();
+#define X(name) writeField(writer, #name, properties.limits.name);
+		DEVICE_SNAPSHOT_LIMITS(X)
+#undef X
+		writer.endObject();
+		writer.key("sparseProperties");
+		writer.beginObject();
+#define X(name) writeField(writer, #name, properties.sparseProperties.name);
+		DEVICE_SNAPSHOT_SPARSE_PROPERTIES(X)
+#undef X
+		writer.endObject();
+		writer.endObject();
+
+		writer.key("features");
+		writer.beginObject();
+#define X(name) writeField(writer, #name, features.name);
+		DEVICE_SNAPSHOT_FEATURES(X)
+#undef X
+		writer.field("timelineSemaphore", timelineSemaphore);
+		writer.endObject();
+
+		writer.key("subgroup");
+		writer.beginObject();
+		writer.field("subgroupSize", subgroup.subgroupSize);
+		writer.field("supportedStages", subgroup.supportedStages);
+		writer.field("supportedOperations", subgroup.supportedOperations);
+		writer.field("quadOperationsInAllStages", subgroup.quadOperationsInAllStages);
+		writer.endObject();
+
+		writer.key("memoryTypes");
+		writer.beginArray();
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			writer.beginObject();
+			writer.field("propertyFlags", memoryProperties.memoryTypes[i].propertyFlags);
+			writer.field("heapIndex", memoryProperties.memoryTypes[i].heapIndex);
+			writer.endObject();
+		}
+		writer.endArray();
+		writer.key("memoryHeaps");
+		writer.beginArray();
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+			writer.beginObject();
+			writer.field("size", memoryProperties.memoryHeaps[i].size);
+			writer.field("flags", memoryProperties.memoryHeaps[i].flags);
+			writer.endObject();
+		}
+		writer.endArray();
+
+		writer.key("queueFamilies");
+		writer.beginArray();
+		for (const VkQueueFamilyProperties& family : queueFamilies) {
+			writer.beginObject();
+			writer.field("queueFlags", family.queueFlags);
+			writer.field("queueCount", family.queueCount);
+			writer.field("timestampValidBits", family.timestampValidBits);
+			uint32_t granularity[3] = { family.minImageTransferGranularity.width,
+				family.minImageTransferGranularity.height, family.minImageTransferGranularity.depth };
+			writeField(writer, "minImageTransferGranularity", granularity);
+			writer.endObject();
+		}
+		writer.endArray();
+
+		writer.key("extensions");
+		writer.beginArray();
+		for (const VkExtensionProperties& extension : extensions) {
+			writer.beginObject();
+			writer.field("extensionName", extension.extensionName);
+			writer.field("specVersion", extension.specVersion);
+			writer.endObject();
+		}
+		writer.endArray();
+
+		writer.endObject();
+	}
+
+	// ڂ 0 ̂܂܂ɂ(ÂXibvVbgǂ߂悤)
+	static DeviceSnapshot read(const JsonValue& device)
+	{
+		DeviceSnapshot snapshot;
+
+		const JsonValue& properties = device["properties"];
+		copyString(properties["deviceName"].asString(), snapshot.properties.deviceName, VK_MAX_PHYSICAL_DEVICE_NAME_SIZE);
+		readField(properties, "apiVersion", snapshot.properties.apiVersion);
+		readField(properties, "driverVersion", snapshot.properties.driverVersion);
+		readField(properties, "vendorID", snapshot.properties.vendorID);
+		readField(properties, "deviceID", snapshot.properties.deviceID);
+		readField(properties, "deviceType", snapshot.properties.deviceType);
+		if (const JsonValue* uuid = properties.find("pipelineCacheUUID")) fromHex(uuid->asString(), snapshot.properties.pipelineCacheUUID, VK_UUID_SIZE);
+		if (const JsonValue* limits = properties.find("limits")) {
+#define X(name) readField(*limits, #name, snapshot.properties.limits.name);
+			DEVICE_SNAPSHOT_LIMITS(X)
+#undef X
+		}
+		if (const JsonValue* sparse = properties.find("sparseProperties")) {
+#define X(name) readField(*sparse, #name, snapshot.properties.sparseProperties.name);
+			DEVICE_SNAPSHOT_SPARSE_PROPERTIES(X)
+#undef X
+		}
+
+		if (const JsonValue* features = device.find("features")) {
+#define X(name) readField(*features, #name, snapshot.features.name);
+			DEVICE_SNAPSHOT_FEATURES(X)
+#undef X
+			readField(*features, "timelineSemaphore", snapshot.timelineSemaphore);
+		}
+
+		if (const JsonValue* subgroup = device.find("subgroup")) {
+			readField(*subgroup, "subgroupSize", snapshot.subgroup.subgroupSize);
+			readField(*subgroup, "supportedStages", snapshot.subgroup.supportedStages);
+			readField(*subgroup, "supportedOperations", snapshot.subgroup.supportedOperations);
+			readField(*subgroup, "quadOperationsInAllStages", snapshot.subgroup.quadOperationsInAllStages);
+		}
+
+		const JsonValue& memoryTypes = device["memoryTypes"];
+		const JsonValue& memoryHeaps = device["memoryHeaps"];
+		if (VK_MAX_MEMORY_TYPES < memoryTypes.size() || VK_MAX_MEMORY_HEAPS < memoryHeaps.size()) {
+			throw std::runtime_error("too many memory types in device snapshot!");
+		}
+		VkPhysicalDeviceMemoryProperties& memory = snapshot.memoryProperties;
+		memory.memoryTypeCount = static_cast<uint32_t>(memoryTypes.size());
+		for (uint32_t i = 0; i < memory.memoryTypeCount; i++) {
+			readField(memoryTypes[i], "propertyFlags", memory.memoryTypes[i].propertyFlags);
+			readField(memoryTypes[i], "heapIndex", memory.memoryTypes[i].heapIndex);
+			if (memoryHeaps.size() <= memory.memoryTypes[i].heapIndex) throw std::runtime_error("bad heap index in device snapshot!");
+		}
+		memory.memoryHeapCount = static_cast<uint32_t>(memoryHeaps.size());
+		for (uint32_t i = 0; i < memory.memoryHeapCount; i++) {
+			readField(memoryHeaps[i], "size", memory.memoryHeaps[i].size);
+			readField(memoryHeaps[i], "flags", memory.memoryHeaps[i].flags);
+		}
+
+		for (const JsonValue& family : device["queueFamilies"].elements) {
+			VkQueueFamilyProperties properties = {};
+			readField(family, "queueFlags", properties.queueFlags);
+			readField(family, "queueCount", properties.queueCount);
+			readField(family, "timestampValidBits", properties.timestampValidBits);
+			uint32_t granularity[3] = {};
+			readField(family, "minImageTransferGranularity", granularity);
+			properties.minImageTransferGranularity = { granularity[0], granularity[1], granularity[2] };
+			snapshot.queueFamilies.push_back(properties);
+		}
+
+		if (const JsonValue* extensions = device.find("extensions")) {
+			for (const JsonValue& extension : extensions->elements) {
+				VkExtensionProperties properties = {};
+				copyString(extension["extensionName"].asString(), properties.extensionName, VK_MAX_EXTENSION_NAME_SIZE);
+				readField(extension, "specVersion", properties.specVersion);
+				snapshot.extensions.push_back(properties);
+			}
+		}
+		return snapshot;
+	}
+
+	template <typename T>
+	static void writeField(JsonWriter& writer, const char* name, const T& value)
+	{
+		writer.key(name);
+		writeValue(writer, value);
+	}
+
+	template <typename T>
+	static void writeValue(JsonWriter& writer, const T& value)
+	{
+		if constexpr (std::is_array<T>::value) {
+			writer.beginArray();
+			for (const auto& element : value) writeValue(writer, element);
+			writer.endArray();
+		}
+		else {
+			writer.value(value);
+		}
+	}
+
+	template <typename T>
+	static void readField(const JsonValue& object, const char* name, T& value)
+	{
+		const JsonValue* field = object.find(name);
+		if (field != nullptr) readValue(*field, value);
+	}
+
+	template <typename T>
+	static void readValue(const JsonValue& json, T& value)
+	{
+		if constexpr (std::is_array<T>::value) {
+			if (json.type != JsonValue::Type::Array || json.size() != std::extent<T>::value) {
+				throw std::runtime_error("wrong array length in device snapshot!");
+			}
+			for (size_t i = 0; i < std::extent<T>::value; i++) readValue(json[i], value[i]);
+		}
+		else if constexpr (std::is_enum<T>::value) {
+			value = static_cast<T>(json.asInt());
+		}
+		else if constexpr (std::is_floating_point<T>::value) {
+			value = static_cast<T>(json.asDouble());
+		}
+		else if constexpr (std::is_signed<T>::value) {
+			value = static_cast<T>(json.asInt());
+		}
+		else {
+			value = static_cast<T>(json.asUint());
+		}
+	}
+
+	static void copyString(const std::string& text, char* dest, size_t capacity)
+	{
+		size_t length = std::min(text.size(), capacity - 1);
+		memcpy(dest, text.data(), length);
+		dest[length] = '\0';
+	}
+
+	static std::string toHex(const uint8_t* data, size_t size)
+	{
+		const char* DIGITS = "0123456789abcdef";
+		std::string result;
+		for (size_t i = 0; i < size; i++) {
+			result += DIGITS[data[i] >> 4];
+			result += DIGITS[data[i] & 0xf];
+		}
+		return result;
+	}
+
+	static void fromHex(const std::string& text, uint8_t* data, size_t size)
+	{
+		if (text.size() != size * 2) throw std::runtime_error("bad UUID in device snapshot!");
+		for (size_t i = 0; i < size; i++) data[i] = static_cast<uint8_t>(std::stoul(text.substr(i * 2, 2), nullptr, 16));
+	}
+};
+
+/*** foCX̖₢킹 ***/
+// {̕foCXAǂݍ񂾃XibvVbg(͋[foCX)̂ǂɂ悤ɖ₢킹B
+// foCX̑I͂ʂčŝŁAXibvVbgłNƓfɂȂB
+
+class PhysicalDeviceView
+{
+private:
+	VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
+	const DeviceSnapshot* snapshot_ = nullptr;
+
+public:
+	explicit PhysicalDeviceView(VkPhysicalDevice physicalDevice) : physicalDevice_(physicalDevice) {}
+	explicit PhysicalDeviceView(const DeviceSnapshot& snapshot) : snapshot_(&snapshot) {}
+
+	// XibvVbgȂ VK_NULL_HANDLE
+	VkPhysicalDevice handle() const { return physicalDevice_; }
+	const DeviceSnapshot* snapshot() const { return snapshot_; }
+
+	void getProperties(VkPhysicalDeviceProperties* properties) const
+	{
+		if (snapshot_ != nullptr) *properties = snapshot_->properties;
+		else vkGetPhysicalDeviceProperties(physicalDevice_, properties);
+	}
+
+	void getFeatures(VkPhysicalDeviceFeatures* features) const
+	{
+		if (snapshot_ != nullptr) *features = snapshot_->features;
+		else vkGetPhysicalDeviceFeatures(physicalDevice_, features);
+	}
+
+	void getMemoryProperties(VkPhysicalDeviceMemoryProperties* memoryProperties) const
+	{
+		if (snapshot_ != nullptr) *memoryProperties = snapshot_->memoryProperties;
+		else vkGetPhysicalDeviceMemoryProperties(physicalDevice_, memoryProperties);
+	}
+
+	// vkGetPhysicalDeviceQueueFamilyProperties ƓAqueueFamilies  nullptr Ȃ琔Ԃ
+	void getQueueFamilyProperties(uint32_t* count, VkQueueFamilyProperties* queueFamilies) const
+	{
+		if (snapshot_ == nullptr) {
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, count, queueFamilies);
+			return;
+		}
+		if (queueFamilies == nullptr) {
+			*count = static_cast<uint32_t>(snapshot_->queueFamilies.size());
+			return;
+		}
+		*count = std::min(*count, static_cast<uint32_t>(snapshot_->queueFamilies.size()));
+		std::copy(snapshot_->queueFamilies.begin(), snapshot_->queueFamilies.begin() + *count, queueFamilies);
+	}
+};
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "ScratchAllocator.h"
+
+/*** ȌW ***/
+// 񋓂C[Eg̖O߂̃nbV\(JԒn@)BO͗񋓂z̒wŕȂB
+// ̈ ScratchScope ̂ŁAXR[v̒łgB
+
+class NameSet
+{
+private:
+	ScratchArray<const char*> slots_;// 󂫂 nullptrB傫 2 ̗ݏ
+	size_t size_ = 0;
+
+public:
+	NameSet(ScratchScope& scratch, size_t maxCount)
+	{
+		size_t capacity = 8;
+		while (capacity < maxCount * 2) capacity *= 2;// ȏ㖄܂Ȃ悤ɂ
+		slots_ = scratch.allocate<const char*>(capacity);
+	}
+
+	// V true
+	bool insert(const char* name)
+	{
+		size_t index = find(name);
+		if (slots_[index] != nullptr) return false;
+		if (slots_.size() < (size_ + 1) * 2) throw std::runtime_error("name set is full!");
+		slots_[index] = name;
+		size_++;
+		return true;
+	}
+
+	bool contains(const char* name) const { return slots_[find(name)] != nullptr; }
+	size_t size() const { return size_; }
+
+private:
+	// name ̓ĂꏊAׂ󂫂̏ꏊ
+	size_t find(const char* name) const
+	{
+		size_t mask = slots_.size() - 1;
+		size_t index = hash(name) & mask;
+		while (slots_[index] != nullptr && strcmp(slots_[index], name) != 0) index = (index + 1) & mask;
+		return index;
+	}
+
+	// FNV-1a
+	static uint32_t hash(const char* name)
+	{
+		uint32_t value = 2166136261u;
+		for (; *name != '\0'; name++) {
+			value ^= static_cast<unsigned char>(*name);
+			value *= 16777619u;
+		}
+		return value;
+	}
+};
+
+/*** C[Ɗǧ ***/
+// ΉĂ郌C[Eg 1 x񋓂ănbV\ɓAvꂽ̂ˑgƈꏏɗLɂB
+// @\̍\̂nǵAvkGetPhysicalDeviceFeatures2  1 xĂŋ@\ɑΉĂ邩܂Ŋm߁A
+// Lɂ̂̍\̂ pNext ɌqBK{̂̂gȂΗOACӂ͎̂̂gȂΒ߂B
+//   ScratchScope scratch;
+//   ExtensionNegotiator negotiator = ExtensionNegotiator::forDevice(scratch, physicalDevice);
+//   VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline = { VK_STRUCTURE_TYPE_..._TIMELINE_SEMAPHORE_FEATURES_KHR };
+//   negotiator.request(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, ExtensionNegotiator::Requirement::Optional, {},
+//       &timeline, &VkPhysicalDeviceTimelineSemaphoreFeaturesKHR::timelineSemaphore);
+//   negotiator.negotiate();
+//   createInfo.pNext = negotiator.featureChain();  // ppEnabledExtensionNames  extensionNames()
+
+class ExtensionNegotiator
+{
+public:
+	enum class Requirement
+	{
+		Required,
+		Optional,
+	};
+
+private:
+	enum class State : uint8_t
+	{
+		Pending,
+		Resolving,// ˑ𒲂ׂĂr(z̌oɎg)
+		Enabled,
+		Unavailable,		// g
+		Unsupported,		// g͂邪@\ɑΉĂȂ
+		MissingDependency,	// ˑggȂ
+	};
+
+	static constexpr uint32_t MAX_DEPENDENCIES = 4;
+
+	struct Request
+	{
+		const char* name;
+		Requirement requirement;
+		const char* dependencies[MAX_DEPENDENCIES];
+		uint32_t dependencyCount;
+		VkBaseOutStructure* features;	// Lɂ pNext Ɍq\(ĂяốB nullptr)
+		VkBaseOutStructure* query;		// Ή₢킹邽߂ features ̎ʂ
+		VkBool32* featureBit;			// Lɂ@\(features ̒̃o[)
+		const VkBool32* supportedBit;	// ΉĂ邩(query ̒́AfeatureBit Ɠo[)
+		State state;
+	};
+
+	ScratchScope* scratch_;
+	VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;// CX^X̂Ƃ VK_NULL_HANDLE
+
+	ScratchArray<VkExtensionProperties> availableExtensions_;
+	ScratchArray<VkLayerProperties> availableLayers_;
+	NameSet extensionSet_;
+	NameSet layerSet_;
+
+	SmallVector<Request, 16> requests_;
+	SmallVector<const char*, 16> enabledExtensions_;
+	SmallVector<const char*, 4> enabledLayers_;
+	NameSet enabledSet_;
+	VkBaseOutStructure* featureChain_ = nullptr;
+	bool negotiated_ = false;
+
+	ExtensionNegotiator(ScratchScope& scratch, VkPhysicalDevice physicalDevice,
+		ScratchArray<VkExtensionProperties> extensions, ScratchArray<VkLayerProperties> layers)
+		: scratch_(&scratch), physicalDevice_(physicalDevice), availableExtensions_(extensions), availableLayers_(layers),
+		extensionSet_(scratch, extensions.size()), layerSet_(scratch, layers.size()), enabledSet_(scratch, extensions.size())
+	{
+		for (const VkExtensionProperties& extension : availableExtensions_) extensionSet_.insert(extension.extensionName);
+		for (const VkLayerProperties& layer : availableLayers_) layerSet_.insert(layer.layerName);
+	}
+
+public:
+	// CX^X̃C[Ɗg
+	static ExtensionNegotiator forInstance(ScratchScope& scratch)
+	{
+		uint32_t layerCount = 0;
+		vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+		ScratchArray<VkLayerProperties> layers = scratch.allocate<VkLayerProperties>(layerCount);
+		vkEnumerateInstanceLayerProperties(&layerCount, layers.data());
+
+		uint32_t extensionCount = 0;
+		vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+		ScratchArray<VkExtensionProperties> extensions = scratch.allocate<VkExtensionProperties>(extensionCount);
+		vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+		return ExtensionNegotiator(scratch, VK_NULL_HANDLE, extensions, layers);
+	}
+
+	// _foCX̊g(@\̖₢킹)
+	static ExtensionNegotiator forDevice(ScratchScope& scratch, VkPhysicalDevice physicalDevice)
+	{
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		ScratchArray<VkExtensionProperties> extensions = scratch.allocate<VkExtensionProperties>(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+		return ExtensionNegotiator(scratch, physicalDevice, extensions, ScratchArray<VkLayerProperties>());
+	}
+
+	bool hasExtension(const char* name) const { return extensionSet_.contains(name); }
+	bool hasLayer(const char* name) const { return layerSet_.contains(name); }
+
+	// C[͂̏ŗLɂ(CX^X̂)
+	bool enableLayer(const char* name, Requirement requirement)
+	{
+		if (!layerSet_.contains(name)) {
+			if (requirement == Requirement::Required) throw std::runtime_error(std::string("required layer is not available: ") + name + "!");
+			return false;
+		}
+		enabledLayers_.push_back(name);
+		return true;
+	}
+
+	// extension  dependencies Lɂ悤v(dependencies vĂ΁ȀKv)
+	void request(const char* extension, Requirement requirement, std::initializer_list<const char*> dependencies = {})
+	{
+		if (negotiated_) throw std::runtime_error("extensions were already negotiated!");
+		if (MAX_DEPENDENCIES < dependencies.size()) throw std::runtime_error("too many extension dependencies!");
+
+		Request request = {};
+		request.name = extension;
+		request.requirement = requirement;
+		for (const char* dependency : dependencies) request.dependencies[request.dependencyCount++] = dependency;
+		request.state = State::Pending;
+		requests_.push_back(request);
+	}
+
+	// features->*feature ɑΉĂ΁AgLɂ features  pNext Ɍq(foCX̂)
+	// features  sType ݒ肵ĂA쐬I܂ŎcĂƁB\̂̕ʂ̋@\vĂ悢
+	template <typename Features>
+	void request(const char* extension, Requirement requirement, std::initializer_list<const char*> dependencies,
+		Features* features, VkBool32 Features::* feature)
+	{
+		if (physicalDevice_ == VK_NULL_HANDLE) throw std::runtime_error("instance extensions have no feature structures!");
+		request(extension, requirement, dependencies);
+
+		// \̂vς݂ȂA₢킹̎ʂL( sType  2 xqȂ)
+		VkBaseOutStructure* base = reinterpret_cast<VkBaseOutStructure*>(features);
+		Features* query = nullptr;
+		for (const Request& other : requests_) {
+			if (other.features == base) query = reinterpret_cast<Features*>(other.query);
+		}
+		if (query == nullptr) {
+			query = scratch_->allocate<Features>(1).data();
+			query->sType = features->sType;
+		}
+
+		Request& added = requests_.back();
+		added.features = base;
+		added.query = reinterpret_cast<VkBaseOutStructure*>(query);
+		added.featureBit = &(features->*feature);
+		added.supportedBit = &(query->*feature);
+	}
+
+	// vˑ֌WƂƂɉBK{̂̂gȂΗO
+	void negotiate()
+	{
+		if (negotiated_) return;
+		negotiated_ = true;
+
+		queryFeatures();
+		for (size_t i = 0; i < requests_.size(); i++) {
+			if (!resolve(i) && requests_[i].requirement == Requirement::Required) {
+				throw std::runtime_error(std::string("required extension is not available: ") + requests_[i].name
+					+ " (" + toString(requests_[i].state) + ")!");
+			}
+		}
+
+		// Lɂ\̂q(\̂ 1 x)
+		for (const Request& request : requests_) {
+			if (request.state != State::Enabled || request.features == nullptr) continue;
+			*request.featureBit = VK_TRUE;
+			if (contains(featureChain_, request.features)) continue;
+			request.features->pNext = featureChain_;
+			featureChain_ = request.features;
+		}
+	}
+
+	bool enabled(const char* extension) const { return enabledSet_.contains(extension); }
+
+	// 쐬ɓn
+	const char* const* extensionNames() const { return enabledExtensions_.data(); }
+	uint32_t extensionCount() const { return static_cast<uint32_t>(enabledExtensions_.size()); }
+	const char* const* layerNames() const { return enabledLayers_.data(); }
+	uint32_t layerCount() const { return static_cast<uint32_t>(enabledLayers_.size()); }
+	void* featureChain() const { return featureChain_; }
+
+	// Lɂ́EłȂ̂̈ꗗ
+	void report(std::ostream& stream, const char* title) const
+	{
+		stream << title << ":" << std::endl;
+		for (const char* layer : enabledLayers_) stream << "\tlayer " << layer << std::endl;
+		for (const char* extension : enabledExtensions_) stream << "\t" << extension << std::endl;
+		for (const Request& request : requests_) {
+			if (request.state == State::Enabled) continue;
+			stream << "\t(" << toString(request.state) << ") " << request.name << std::endl;
+		}
+	}
+
+private:
+	// ĝv̍\̂܂Ƃ߂ČqA1 xŖ₢킹
+	void queryFeatures()
+	{
+		if (physicalDevice_ == VK_NULL_HANDLE) return;
+
+		VkBaseOutStructure* chain = nullptr;
+		for (Request& request : requests_) {
+			if (request.query == nullptr || !extensionSet_.contains(request.name)) continue;
+			if (contains(chain, request.query)) continue;// LĂʂ͌qς
+			request.query->pNext = chain;
+			chain = request.query;
+		}
+		if (chain == nullptr) return;
+
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = chain;
+		vkGetPhysicalDeviceFeatures2(physicalDevice_, &features2);
+	}
+
+	// vLɂł true(ˑvɉALɂ鏇͈ˑ̂)
+	bool resolve(size_t index)
+	{
+		Request& request = requests_[index];
+		if (request.state == State::Resolving) throw std::runtime_error(std::string("circular extension dependency: ") + request.name + "!");
+		if (request.state != State::Pending) return request.state == State::Enabled;
+		request.state = State::Resolving;
+
+		State result = State::Enabled;
+		if (!extensionSet_.contains(request.name)) result = State::Unavailable;
+		else if (request.supportedBit != nullptr && *request.supportedBit != VK_TRUE) result = State::Unsupported;
+
+		for (uint32_t i = 0; i < request.dependencyCount && result == State::Enabled; i++) {
+			const char* dependency = request.dependencies[i];
+			size_t dependencyIndex = findRequest(dependency);
+			bool available = dependencyIndex < requests_.size() ? resolve(dependencyIndex) : extensionSet_.contains(dependency);
+			if (!available) result = State::MissingDependency;
+		}
+
+		// resolve()  requests_ ͑Ȃ̂ŁArequest ͂̂܂܎g
+		if (result == State::Enabled) {
+			for (uint32_t i = 0; i < request.dependencyCount; i++) enableExtension(request.dependencies[i]);
+			enableExtension(request.name);
+		}
+		request.state = result;
+		return result == State::Enabled;
+	}
+
+	static bool contains(const VkBaseOutStructure* chain, const VkBaseOutStructure* structure)
+	{
+		for (; chain != nullptr; chain = chain->pNext) {
+			if (chain == structure) return true;
+		}
+		return false;
+	}
+
+	size_t findRequest(const char* name) const
+	{
+		for (size_t i = 0; i < requests_.size(); i++) {
+			if (strcmp(requests_[i].name, name) == 0) return i;
+		}
+		return requests_.size();
+	}
+
+	void enableExtension(const char* name)
+	{
+		if (enabledSet_.insert(name)) enabledExtensions_.push_back(name);
+	}
+
+	static const char* toString(State state)
+	{
+		switch (state) {
+		case State::Enabled: return "enabled";
+		case State::Unavailable: return "not available";
+		case State::Unsupported: return "feature not supported";
+		case State::MissingDependency: return "missing dependency";
+		default: return "pending";
+		}
+	}
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*** t[̃Lv`(Čp̋L^) ***/
+// w肵͈͂̃t[ŃAvs GPU ̏ƁȀg\[X̃f[^
+// RpNgȃoCi`ŕۑBFrameReplayer  GPU (lavapipe)łĎsłB
+//
+// t@Č`(gGfBA)
+//   wb_[ : magic "VKCP", o[W, ŏ̃t[, t[
+//   R}h : [opcode u16][\ u16][yC[h̒ u32][yC[h] ̌JԂ
+// \[X̃f[^ Blob R}h 1 xۑAȍ~ ID ŎQƂ(e͋L)B
+
+namespace capture
+{
+	constexpr uint32_t MAGIC = 0x50434b56;// "VKCP"
+	constexpr uint32_t VERSION = 1;
+
+	enum class Opcode : uint16_t
+	{
+		BeginFrame = 1,			// u64 frame
+		EndFrame,				// u64 frame
+		Blob,					// u32 blobId, f[^
+		CreateBuffer,			// u32 bufferId, u64 size
+		UploadBuffer,			// u32 bufferId, u64 offset, u32 blobId
+		FillBuffer,				// u32 bufferId, u64 offset, u64 size, u32 value
+		CopyBuffer,				// u32 srcId, u32 dstId, u64 srcOffset, u64 dstOffset, u64 size
+		CreateComputePipeline,	// u32 pipelineId, u32 spirvBlobId, u32 specializationBlobId, u32 bindingCount, u32 pushConstantSize, ꉻGg
+		Dispatch,				// u32 pipelineId, u32 x, u32 y, u32 z, u32 pushConstantBlobId, u32 bufferCount, u32 bufferIds[]
+	};
+
+	constexpr uint32_t NO_BLOB = 0xffffffff;
+
+	inline const char* toString(Opcode opcode)
+	{
+		switch (opcode) {
+		case Opcode::BeginFrame: return "BeginFrame";
+		case Opcode::EndFrame: return "EndFrame";
+		case Opcode::Blob: return "Blob";
+		case Opcode::CreateBuffer: return "CreateBuffer";
+		case Opcode::UploadBuffer: return "UploadBuffer";
+		case Opcode::FillBuffer: return "FillBuffer";
+		case Opcode::CopyBuffer: return "CopyBuffer";
+		case Opcode::CreateComputePipeline: return "CreateComputePipeline";
+		case Opcode::Dispatch: return "Dispatch";
+		}
+		return "Unknown";
+	}
+
+	// yC[h̑gݗ
+	class PayloadWriter
+	{
+	private:
+		std::vector<unsigned char> data_;
+
+	public:
+		template <typename T>
+		PayloadWriter& put(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "payload values must be trivially copyable");
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+			data_.insert(data_.end(), bytes, bytes + sizeof(T));
+			return *this;
+		}
+
+		PayloadWriter& putBytes(const void* data, size_t size)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			data_.insert(data_.end(), bytes, bytes + size);
+			return *this;
+		}
+
+		const std::vector<unsigned char>& data() const { return data_; }
+	};
+
+	// yC[h̓ǂݏo(͈͊OǂƂO)
+	class PayloadReader
+	{
+	private:
+		const unsigned char* data_;
+		size_t size_;
+		size_t position_ = 0;
+
+	public:
+		PayloadReader(const unsigned char* data, size_t size) : data_(data), size_(size) {}
+
+		template <typename T>
+		T get()
+		{
+			T value;
+			std::memcpy(&value, bytes(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		const unsigned char* bytes(size_t size)
+		{
+			if (size_ < position_ + size) throw std::runtime_error("capture payload is truncated!");
+			const unsigned char* result = data_ + position_;
+			position_ += size;
+			return result;
+		}
+
+		size_t remaining() const { return size_ - position_; }
+	};
+
+	// Lv` 1 R}h
+	struct Command
+	{
+		Opcode opcode;
+		std::vector<unsigned char> payload;
+	};
+}
+
+class FrameCaptureWriter
+{
+private:
+	std::ofstream file_;
+	uint64_t firstFrame_ = 0;
+	uint64_t frameCount_ = 0;
+	bool inRange_ = false;
+
+	std::unordered_multimap<uint64_t, uint32_t> blobIds_;	// ẽnbV  blobId(nbVՓ˂畡ɂȂ)
+	std::vector<std::vector<unsigned char>> blobs_;			// blobId  e(nbVƂɒgׂ)
+	std::unordered_map<uint64_t, uint32_t> bufferIds_;		// VkBuffer  bufferId
+	std::unordered_map<uint64_t, uint32_t> pipelineIds_;	// VkPipeline  pipelineId
+	uint32_t nextBufferId_ = 0;		// nh̒l͔jɎg񂳂̂ŁAID ͐𐔂ĐU
+	uint32_t nextPipelineId_ = 0;
+
+	static uint64_t hashBytes(const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t h = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++) {
+			h ^= bytes[i];
+			h *= 1099511628211ull;
+		}
+		return h ^ size;
+	}
+
+	template <typename Handle>
+	static uint64_t handleKey(Handle handle) { return (uint64_t)(handle); }
+
+	void writeCommand(capture::Opcode opcode, const capture::PayloadWriter& payload)
+	{
+		uint16_t code = static_cast<uint16_t>(opcode);
+		uint16_t reserved = 0;
+		uint32_t size = static_cast<uint32_t>(payload.data().size());
+		file_.write(reinterpret_cast<const char*>(&code), sizeof(code));
+		file_.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+		file_.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		file_.write(reinterpret_cast<const char*>(payload.data().data()), size);
+	}
+
+	// f[^ۑ ID Ԃ(eȂ炷łɂ ID Ԃ)
+	// nbVœƂ݂ȂƁAՓ˂Ƃɕʂ̃f[^ōĎsĂ܂̂ŁAgׂ
+	uint32_t blob(const void* data, size_t size)
+	{
+		uint64_t hash = hashBytes(data, size);
+		auto [first, last] = blobIds_.equal_range(hash);
+		for (auto found = first; found != last; ++found) {
+			const std::vector<unsigned char>& saved = blobs_[found->second];
+			if (saved.size() == size && (size == 0 || std::memcmp(saved.data(), data, size) == 0)) return found->second;
+		}
+
+		uint32_t id = static_cast<uint32_t>(blobs_.size());
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		blobs_.emplace_back(bytes, bytes + size);
+		blobIds_.emplace(hash, id);
+		writeCommand(capture::Opcode::Blob, capture::PayloadWriter().put(id).putBytes(data, size));
+		return id;
+	}
+
+	uint32_t bufferId(VkBuffer buffer) const
+	{
+		auto found = bufferIds_.find(handleKey(buffer));
+		if (found == bufferIds_.end()) throw std::runtime_error("buffer was created before the capture started!");
+		return found->second;
+	}
+
+public:
+	// first  count t[ԂL^B\[X̍쐬ƃf[^̓]͔͈͊OłL^
+	bool open(const std::string& path, uint64_t firstFrame, uint64_t frameCount)
+	{
+		file_.open(path, std::ios::binary | std::ios::trunc);
+		if (!file_) return false;
+
+		firstFrame_ = firstFrame;
+		frameCount_ = frameCount;
+		file_.write(reinterpret_cast<const char*>(&capture::MAGIC), sizeof(capture::MAGIC));
+		file_.write(reinterpret_cast<const char*>(&capture::VERSION), sizeof(capture::VERSION));
+		file_.write(reinterpret_cast<const char*>(&firstFrame_), sizeof(firstFrame_));
+		file_.write(reinterpret_cast<const char*>(&frameCount_), sizeof(frameCount_));
+		return true;
+	}
+
+	void close() { if (file_.is_open()) file_.close(); }
+
+	bool isOpen() const { return file_.is_open(); }
+	bool isCapturing() const { return inRange_; }
+	bool isFinished(uint64_t frame) const { return firstFrame_ + frameCount_ <= frame; }
+
+	void beginFrame(uint64_t frame)
+	{
+		if (!isOpen()) return;
+		inRange_ = firstFrame_ <= frame && frame < firstFrame_ + frameCount_;
+		if (inRange_) writeCommand(capture::Opcode::BeginFrame, capture::PayloadWriter().put(frame));
+	}
+
+	void endFrame(uint64_t frame)
+	{
+		if (!isOpen()) return;
+		if (inRange_) writeCommand(capture::Opcode::EndFrame, capture::PayloadWriter().put(frame));
+		inRange_ = false;
+		if (isFinished(frame + 1)) close();
+	}
+
+	/*** \[X̍쐬E](Lv`͈͊OłL^) ***/
+	void createBuffer(VkBuffer buffer, VkDeviceSize size)
+	{
+		if (!isOpen()) return;
+		uint32_t id = nextBufferId_++;
+		bufferIds_[handleKey(buffer)] = id;
+		writeCommand(capture::Opcode::CreateBuffer, capture::PayloadWriter().put(id).put(uint64_t(size)));
+	}
+
+	// createBuffer() ŋL^obt@jOɌĂ(l̃nhŕʂ̃obt@ɂȂĂႦȂ)
+	void destroyBuffer(VkBuffer buffer)
+	{
+		bufferIds_.erase(handleKey(buffer));
+	}
+
+	void uploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, size_t size)
+	{
+		if (!isOpen()) return;
+		uint32_t blobId = blob(data, size);
+		writeCommand(capture::Opcode::UploadBuffer, capture::PayloadWriter().put(bufferId(buffer)).put(uint64_t(offset)).put(blobId));
+	}
+
+	// bindingCount ̃Xg[Wobt@ set 0  0 ԂׂĎgRs[gpCvC
+	void createComputePipeline(VkPipeline pipeline, const std::vector<uint32_t>& spirv, const VkSpecializationInfo* specialization,
+		uint32_t bindingCount, uint32_t pushConstantSize)
+	{
+		if (!isOpen()) return;
+		uint32_t id = nextPipelineId_++;
+		pipelineIds_[handleKey(pipeline)] = id;
+
+		uint32_t spirvBlob = blob(spirv.data(), spirv.size() * sizeof(uint32_t));
+		uint32_t specializationBlob = capture::NO_BLOB;
+		uint32_t entryCount = 0;
+		if (specialization != nullptr && specialization->dataSize != 0) {
+			specializationBlob = blob(specialization->pData, specialization->dataSize);
+			entryCount = specialization->mapEntryCount;
+		}
+
+		capture::PayloadWriter payload;
+		payload.put(id).put(spirvBlob).put(specializationBlob).put(bindingCount).put(pushConstantSize).put(entryCount);
+		for (uint32_t i = 0; i < entryCount; i++) {
+			const VkSpecializationMapEntry& entry = specialization->pMapEntries[i];
+			payload.put(entry.constantID).put(entry.offset).put(uint32_t(entry.size));
+		}
+		writeCommand(capture::Opcode::CreateComputePipeline, payload);
+	}
+
+	/*** t[̏(Lv`͈͓L^) ***/
+	void fillBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t value)
+	{
+		if (!inRange_) return;
+		writeCommand(capture::Opcode::FillBuffer,
+			capture::PayloadWriter().put(bufferId(buffer)).put(uint64_t(offset)).put(uint64_t(size)).put(value));
+	}
+
+	void copyBuffer(VkBuffer src, VkBuffer dst, const VkBufferCopy& region)
+	{
+		if (!inRange_) return;
+		writeCommand(capture::Opcode::CopyBuffer, capture::PayloadWriter().put(bufferId(src)).put(bufferId(dst))
+			.put(uint64_t(region.srcOffset)).put(uint64_t(region.dstOffset)).put(uint64_t(region.size)));
+	}
+
+	void dispatch(VkPipeline pipeline, std::initializer_list<VkBuffer> buffers, const void* pushConstants, uint32_t pushConstantSize,
+		uint32_t x, uint32_t y, uint32_t z)
+	{
+		if (!inRange_) return;
+		uint32_t pushBlob = pushConstantSize == 0 ? capture::NO_BLOB : blob(pushConstants, pushConstantSize);
+
+		capture::PayloadWriter payload;
+		payload.put(pipelineIds_.at(handleKey(pipeline))).put(x).put(y).put(z).put(pushBlob).put(uint32_t(buffers.size()));
+		for (VkBuffer buffer : buffers) payload.put(bufferId(buffer));
+		writeCommand(capture::Opcode::Dispatch, payload);
+	}
+};
+
+// Lv`t@C̓ǂݍ
+class FrameCaptureReader
+{
+public:
+	uint64_t firstFrame = 0;
+	uint64_t frameCount = 0;
+	std::vector<capture::Command> commands;
+
+	void load(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file) throw std::runtime_error("failed to open capture file!");
+
+		uint32_t magic = 0, version = 0;
+		file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		file.read(reinterpret_cast<char*>(&version), sizeof(version));
+		file.read(reinterpret_cast<char*>(&firstFrame), sizeof(firstFrame));
+		file.read(reinterpret_cast<char*>(&frameCount), sizeof(frameCount));
+		if (!file || magic != capture::MAGIC) throw std::runtime_error("not a capture file!");
+		if (version != capture::VERSION) throw std::runtime_error("unsupported capture version!");
+
+		while (true) {
+			uint16_t code = 0, reserved = 0;
+			uint32_t size = 0;
+			file.read(reinterpret_cast<char*>(&code), sizeof(code));
+			if (file.eof()) break;
+			file.read(reinterpret_cast<char*>(&reserved), sizeof(reserved));
+			file.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+			capture::Command command;
+			command.opcode = static_cast<capture::Opcode>(code);
+			command.payload.resize(size);
+			file.read(reinterpret_cast<char*>(command.payload.data()), size);
+			if (!file) throw std::runtime_error("capture file is truncated!");
+
+			commands.push_back(std::move(command));
+		}
+	}
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "SpscQueue.h"
+
+/*** t[pPbg ***/
+// V~[ṼXbh 1 t[Ԃ̕`ɕKvȂ(JEϊsE`ƃCg̈ꗗ)A
+// `Xbh͂ǂނɂBpPbg͍ŏ Depth ĂA2 ̃L[
+// V~[V  `  V~[VƉ(J͏Ȃ̂ŁAbN͗vȂ)B
+//   FramePacketRing<2> ring;
+//   FramePacket* packet = ring.beginWrite();   // V~[ṼXbh
+//   packet->addDraw(mesh, material, transform);
+//   ring.publish(packet);
+//
+//   FramePacketRing<2>::Lease packet(ring);     // `Xbh(XR[voƕԂ)
+//   if (packet) draw(*packet);
+
+struct Float3
+{
+	float x;
+	float y;
+	float z;
+};
+
+struct Camera
+{
+	Float3 position;
+	float yaw;	// Y ܂(WA)
+	float pitch;// X ܂(WA)
+	float fovY;	// c̉p(WA)
+	float aspect;
+	float nearZ;
+	float farZ;
+};
+
+// 3 s 4 ̕ϊs(sDBŌ̗񂪕sړ)
+struct Transform
+{
+	float rows[3][4];
+};
+
+// _([hWBradius ̋Ō͂ȂȂ)
+struct PointLight
+{
+	Float3 position;
+	float radius;
+	Float3 color;
+	float intensity;
+};
+
+struct DrawItem
+{
+	uint32_t mesh;
+	uint32_t material;
+	uint32_t transform;// FramePacket::transforms ̓Y
+};
+
+struct FramePacket
+{
+	constexpr static uint32_t MAX_DRAWS = 65536;// 𐔖ׂV[z肷
+	constexpr static uint32_t MAX_TRANSFORMS = 65536;
+	constexpr static uint32_t MAX_LIGHTS = 16384;// NX^[ɕ̂Ő̃Cgu
+
+	uint64_t simulationFrame = 0;
+	double simulationTime = 0.0;// b
+	std::chrono::steady_clock::time_point producedTime;// V~[VpPbgI
+
+	// ̃pPbgɔf(inputEventCount  0 Ȃ oldestInput ͎gȂ)
+	uint32_t inputEventCount = 0;
+	std::chrono::steady_clock::time_point oldestInput;
+
+	Camera camera{};
+	uint32_t transformCount = 0;
+	uint32_t drawCount = 0;
+	uint32_t lightCount = 0;
+	Transform transforms[MAX_TRANSFORMS];
+	DrawItem draws[MAX_DRAWS];
+	PointLight lights[MAX_LIGHTS];
+
+	void clear()
+	{
+		inputEventCount = 0;
+		transformCount = 0;
+		drawCount = 0;
+		lightCount = 0;
+	}
+
+	// ςȂ UINT32_MAX
+	uint32_t addTransform(const Transform& transform)
+	{
+		if (MAX_TRANSFORMS <= transformCount) return UINT32_MAX;
+		transforms[transformCount] = transform;
+		return transformCount++;
+	}
+
+	// ςȂ false
+	bool addDraw(uint32_t mesh, uint32_t material, uint32_t transform)
+	{
+		if (MAX_DRAWS <= drawCount || transformCount <= transform) return false;
+		draws[drawCount++] = { mesh, material, transform };
+		return true;
+	}
+
+	// ςȂ false
+	bool addLight(const PointLight& light)
+	{
+		if (MAX_LIGHTS <= lightCount) return false;
+		lights[lightCount++] = light;
+		return true;
+	}
+};
+
+// Depth ̃pPbgAV~[ṼXbh()ƕ`Xbh(ǂޑ)ŉ
+template <size_t Depth>
+class FramePacketRing
+{
+	static_assert(2 <= Depth, "FramePacketRing needs at least two packets to overlap simulation and rendering");
+
+private:
+	constexpr static size_t QUEUE_CAPACITY = std::bit_ceil(Depth);
+
+	std::unique_ptr<FramePacket[]> packets_{ new FramePacket[Depth] };// 傫̂ōŏɂ܂Ƃ߂Ċmۂ
+	SpscQueue<uint32_t, QUEUE_CAPACITY> ready_;// IpPbg(V~[V  `)
+	SpscQueue<uint32_t, QUEUE_CAPACITY> free_;// gIpPbg(`  V~[V)
+
+	// ҂Ă鑤N߂̒ʂԍ(l̂̂ɈӖ͂Ȃ)
+	std::atomic<uint64_t> published_{ 0 };
+	std::atomic<uint64_t> released_{ 0 };
+	std::atomic<bool> closed_{ false };
+
+public:
+	FramePacketRing()
+	{
+		for (uint32_t i = 0; i < Depth; i++) free_.push(i);
+	}
+
+	FramePacketRing(const FramePacketRing&) = delete;
+	FramePacketRing& operator=(const FramePacketRing&) = delete;
+
+	// V~[ṼXbhĂԁB󂢂pPbgΕ`悪Ԃ܂ő҂(close() ̌ nullptr)
+	FramePacket* beginWrite()
+	{
+		uint32_t index;
+		for (;;) {
+			uint64_t released = released_.load(std::memory_order_acquire);
+			if (closed_.load(std::memory_order_acquire)) return nullptr;
+			if (free_.pop(&index)) break;
+			released_.wait(released, std::memory_order_acquire);
+		}
+		FramePacket* packet = &packets_[index];
+		packet->clear();
+		return packet;
+	}
+
+	// V~[ṼXbhĂԁB̌̓pPbgȂ
+	void publish(FramePacket* packet)
+	{
+		packet->producedTime = std::chrono::steady_clock::now();
+		ready_.push(static_cast<uint32_t>(packet - packets_.get()));// pPbg Depth ̂ňȂ
+		published_.fetch_add(1, std::memory_order_release);
+		published_.notify_one();
+	}
+
+	// `XbhĂԁB̃pPbg͂܂ő҂(close() ̌ nullptr)
+	const FramePacket* acquire()
+	{
+		uint32_t index;
+		for (;;) {
+			uint64_t published = published_.load(std::memory_order_acquire);
+			if (closed_.load(std::memory_order_acquire)) return nullptr;
+			if (ready_.pop(&index)) break;
+			published_.wait(published, std::memory_order_acquire);
+		}
+		return &packets_[index];
+	}
+
+	// `XbhĂԁBpPbg̓egIԂ
+	void release(const FramePacket* packet)
+	{
+		free_.push(static_cast<uint32_t>(packet - packets_.get()));
+		released_.fetch_add(1, std::memory_order_release);
+		released_.notify_one();
+	}
+
+	// ǂ̃XbhĂł悢B҂Ă鑤NAȌ beginWrite()  acquire()  nullptr Ԃ
+	void close()
+	{
+		closed_.store(true, std::memory_order_release);
+		published_.fetch_add(1, std::memory_order_release);
+		published_.notify_all();
+		released_.fetch_add(1, std::memory_order_release);
+		released_.notify_all();
+	}
+
+	// acquire() pPbgAOŔƂ܂߂ăXR[v̏IɕԂ
+	class Lease
+	{
+	private:
+		FramePacketRing* ring_;
+		const FramePacket* packet_;
+
+	public:
+		explicit Lease(FramePacketRing& ring) : ring_(&ring), packet_(ring.acquire()) {}
+		~Lease()
+		{
+			if (packet_ != nullptr) ring_->release(packet_);
+		}
+
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+
+		explicit operator bool() const { return packet_ != nullptr; }
+		const FramePacket& operator*() const { return *packet_; }
+		const FramePacket* operator->() const { return packet_; }
+	};
+
+	// Iĕ`҂ĂpPbg̐
+	size_t pending() const { return ready_.size(); }
+
+	static constexpr size_t depth() { return Depth; }
+};
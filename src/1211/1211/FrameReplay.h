@@ -0,0 +1,469 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "FrameCapture.h"
+
+/*** Lv`̍Ďs ***/
+// EBhE炸(wbhX)Lv`R}hɎsAR}hƂ̎Ԃ𑪂B
+// T[tFX^CX^vgȂ̂ lavapipe łB
+// 1 R}hoĊ҂̂ŁAԂ̓R}hP̂ CPU+GPU ̏vԂɂȂB
+
+class FrameReplayer
+{
+private:
+	struct Buffer
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+	};
+
+	struct Pipeline
+	{
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		uint32_t bindingCount = 0;
+		uint32_t pushConstantSize = 0;
+	};
+
+	// R}h̎ނƂ̏Wv
+	struct Timing
+	{
+		uint64_t count = 0;
+		double totalSeconds = 0.0;
+		double maxSeconds = 0.0;
+	};
+
+	static constexpr uint32_t MAX_BINDINGS = 64;
+
+	VkInstance instance_ = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
+	VkDevice device_ = VK_NULL_HANDLE;
+	VkQueue queue_ = VK_NULL_HANDLE;
+	uint32_t queueFamily_ = 0;
+	VkCommandPool commandPool_ = VK_NULL_HANDLE;
+	VkCommandBuffer commandBuffer_ = VK_NULL_HANDLE;
+	VkFence fence_ = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool_ = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties memoryProperties_ = {};
+
+	std::map<uint32_t, std::vector<unsigned char>> blobs_;
+	std::map<uint32_t, Buffer> buffers_;
+	std::map<uint32_t, Pipeline> pipelines_;
+	std::map<capture::Opcode, Timing> timings_;
+	std::vector<double> frameSeconds_;
+
+public:
+	FrameReplayer()
+	{
+		try {
+			initialize();
+		}
+		catch (...) {
+			finalize();// r܂ō̂Еt
+			throw;
+		}
+	}
+	~FrameReplayer() { finalize(); }
+
+	FrameReplayer(const FrameReplayer&) = delete;
+	FrameReplayer& operator=(const FrameReplayer&) = delete;
+
+	void replay(const FrameCaptureReader& capture)
+	{
+		double frameTime = 0.0;
+		for (const capture::Command& command : capture.commands) {
+			auto start = std::chrono::steady_clock::now();
+			execute(command);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			Timing& timing = timings_[command.opcode];
+			timing.count++;
+			timing.totalSeconds += seconds;
+			timing.maxSeconds = std::max(timing.maxSeconds, seconds);
+
+			if (command.opcode == capture::Opcode::BeginFrame) frameTime = 0.0;
+			frameTime += seconds;
+			if (command.opcode == capture::Opcode::EndFrame) frameSeconds_.push_back(frameTime);
+		}
+	}
+
+	void printReport(std::ostream& out) const
+	{
+		out << std::fixed << std::setprecision(3);
+		out << "command                     count   total(ms)     avg(ms)     max(ms)" << std::endl;
+		for (const auto& [opcode, timing] : timings_) {
+			out << std::left << std::setw(24) << capture::toString(opcode) << std::right
+				<< std::setw(9) << timing.count
+				<< std::setw(12) << timing.totalSeconds * 1000.0
+				<< std::setw(12) << timing.totalSeconds * 1000.0 / static_cast<double>(timing.count)
+				<< std::setw(12) << timing.maxSeconds * 1000.0 << std::endl;
+		}
+		for (size_t i = 0; i < frameSeconds_.size(); i++) {
+			out << "frame " << i << ": " << frameSeconds_[i] * 1000.0 << " ms" << std::endl;
+		}
+	}
+
+private:
+	void initialize()
+	{
+		// T[tFXgȂ̂ŁAgC[vȂ
+		VkApplicationInfo appInfo = {};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "Frame Replay";
+		appInfo.apiVersion = VK_API_VERSION_1_1;
+
+		VkInstanceCreateInfo instanceInfo = {};
+		instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		instanceInfo.pApplicationInfo = &appInfo;
+		if (vkCreateInstance(&instanceInfo, nullptr, &instance_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create instance!");
+		}
+
+		// Rs[gL[ŏ̃foCX(CPU  lavapipe ܂)
+		uint32_t deviceCount = 0;
+		vkEnumeratePhysicalDevices(instance_, &deviceCount, nullptr);
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(instance_, &deviceCount, devices.data());
+		for (VkPhysicalDevice device : devices) {
+			std::optional<uint32_t> family = findComputeFamily(device);
+			if (family.has_value()) {
+				physicalDevice_ = device;
+				queueFamily_ = family.value();
+				break;
+			}
+		}
+		if (physicalDevice_ == VK_NULL_HANDLE) throw std::runtime_error("failed to find a device for replay!");
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memoryProperties_);
+
+		float priority = 1.0f;
+		VkDeviceQueueCreateInfo queueInfo = {};
+		queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueInfo.queueFamilyIndex = queueFamily_;
+		queueInfo.queueCount = 1;
+		queueInfo.pQueuePriorities = &priority;
+
+		VkDeviceCreateInfo deviceInfo = {};
+		deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceInfo.queueCreateInfoCount = 1;
+		deviceInfo.pQueueCreateInfos = &queueInfo;
+		if (vkCreateDevice(physicalDevice_, &deviceInfo, nullptr, &device_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create logical device!");
+		}
+		vkGetDeviceQueue(device_, queueFamily_, 0, &queue_);
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = queueFamily_;
+		if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create command pool!");
+		}
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = commandPool_;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+		vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer_);
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		vkCreateFence(device_, &fenceInfo, nullptr, &fence_);
+
+		// fBXpb` 1 ҂̂ŁAZbg 1 Α(fBXpb`̂тɃZbg)
+		VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MAX_BINDINGS };
+		VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
+		descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorPoolInfo.maxSets = 1;
+		descriptorPoolInfo.poolSizeCount = 1;
+		descriptorPoolInfo.pPoolSizes = &poolSize;
+		vkCreateDescriptorPool(device_, &descriptorPoolInfo, nullptr, &descriptorPool_);
+	}
+
+	void finalize()
+	{
+		if (device_ != VK_NULL_HANDLE) {
+			vkDeviceWaitIdle(device_);
+			for (auto& [id, pipeline] : pipelines_) {
+				vkDestroyPipeline(device_, pipeline.pipeline, nullptr);
+				vkDestroyPipelineLayout(device_, pipeline.layout, nullptr);
+				vkDestroyDescriptorSetLayout(device_, pipeline.setLayout, nullptr);
+			}
+			for (auto& [id, buffer] : buffers_) {
+				vkDestroyBuffer(device_, buffer.buffer, nullptr);
+				vkFreeMemory(device_, buffer.memory, nullptr);
+			}
+			vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
+			vkDestroyFence(device_, fence_, nullptr);
+			vkDestroyCommandPool(device_, commandPool_, nullptr);
+			vkDestroyDevice(device_, nullptr);
+		}
+		if (instance_ != VK_NULL_HANDLE) vkDestroyInstance(instance_, nullptr);
+	}
+
+	static std::optional<uint32_t> findComputeFamily(VkPhysicalDevice device)
+	{
+		uint32_t count = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &count, nullptr);
+		std::vector<VkQueueFamilyProperties> families(count);
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &count, families.data());
+		for (uint32_t i = 0; i < count; i++) {
+			if (0 < families[i].queueCount && (families[i].queueFlags & VK_QUEUE_COMPUTE_BIT)) return i;
+		}
+		return std::nullopt;
+	}
+
+	uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties_.memoryTypeCount; i++) {
+			if ((typeBits & (1u << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & properties) == properties) return i;
+		}
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	// L^ 1 oĊ܂ő҂
+	template <typename Record>
+	void submit(Record record)
+	{
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer_, &beginInfo);
+		record(commandBuffer_);
+		vkEndCommandBuffer(commandBuffer_);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer_;
+		if (vkQueueSubmit(queue_, 1, &submitInfo, fence_) != VK_SUCCESS) throw std::runtime_error("failed to submit replay command!");
+		vkWaitForFences(device_, 1, &fence_, VK_TRUE, UINT64_MAX);
+		vkResetFences(device_, 1, &fence_);
+	}
+
+	void execute(const capture::Command& command)
+	{
+		capture::PayloadReader in(command.payload.data(), command.payload.size());
+
+		switch (command.opcode) {
+		case capture::Opcode::BeginFrame:
+		case capture::Opcode::EndFrame:
+			break;
+
+		case capture::Opcode::Blob: {
+			uint32_t id = in.get<uint32_t>();
+			size_t size = in.remaining();
+			const unsigned char* data = in.bytes(size);
+			blobs_[id].assign(data, data + size);
+			break;
+		}
+
+		case capture::Opcode::CreateBuffer: {
+			uint32_t id = in.get<uint32_t>();
+			uint64_t size = in.get<uint64_t>();
+			buffers_[id] = createBuffer(size);
+			break;
+		}
+
+		case capture::Opcode::UploadBuffer: {
+			const Buffer& buffer = buffers_.at(in.get<uint32_t>());
+			uint64_t offset = in.get<uint64_t>();
+			const std::vector<unsigned char>& data = blobs_.at(in.get<uint32_t>());
+			void* mapped = nullptr;
+			vkMapMemory(device_, buffer.memory, offset, data.size(), 0, &mapped);
+			std::memcpy(mapped, data.data(), data.size());
+			vkUnmapMemory(device_, buffer.memory);
+			break;
+		}
+
+		case capture::Opcode::FillBuffer: {
+			VkBuffer buffer = buffers_.at(in.get<uint32_t>()).buffer;
+			uint64_t offset = in.get<uint64_t>();
+			uint64_t size = in.get<uint64_t>();
+			uint32_t value = in.get<uint32_t>();
+			submit([&](VkCommandBuffer cmd) { vkCmdFillBuffer(cmd, buffer, offset, size, value); });
+			break;
+		}
+
+		case capture::Opcode::CopyBuffer: {
+			VkBuffer src = buffers_.at(in.get<uint32_t>()).buffer;
+			VkBuffer dst = buffers_.at(in.get<uint32_t>()).buffer;
+			VkBufferCopy region = {};
+			region.srcOffset = in.get<uint64_t>();
+			region.dstOffset = in.get<uint64_t>();
+			region.size = in.get<uint64_t>();
+			submit([&](VkCommandBuffer cmd) { vkCmdCopyBuffer(cmd, src, dst, 1, &region); });
+			break;
+		}
+
+		case capture::Opcode::CreateComputePipeline:
+			createComputePipeline(in);
+			break;
+
+		case capture::Opcode::Dispatch:
+			dispatch(in);
+			break;
+
+		default:
+			throw std::runtime_error("unknown capture command!");
+		}
+	}
+
+	// Ďsł̓f[^̒g𒼐ڏ߂悤ɁAzXg猩郁ɒu
+	Buffer createBuffer(VkDeviceSize size)
+	{
+		Buffer result;
+		result.size = size;
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(device_, &bufferInfo, nullptr, &result.buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create buffer!");
+		}
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device_, result.buffer, &requirements);
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		if (vkAllocateMemory(device_, &allocInfo, nullptr, &result.memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate buffer memory!");
+		}
+		vkBindBufferMemory(device_, result.buffer, result.memory, 0);
+		return result;
+	}
+
+	void createComputePipeline(capture::PayloadReader& in)
+	{
+		uint32_t id = in.get<uint32_t>();
+		const std::vector<unsigned char>& spirv = blobs_.at(in.get<uint32_t>());
+		uint32_t specializationBlob = in.get<uint32_t>();
+		Pipeline pipeline;
+		pipeline.bindingCount = in.get<uint32_t>();
+		pipeline.pushConstantSize = in.get<uint32_t>();
+		if (MAX_BINDINGS < pipeline.bindingCount) throw std::runtime_error("too many bindings in pipeline!");
+		uint32_t entryCount = in.get<uint32_t>();
+
+		std::vector<VkSpecializationMapEntry> entries(entryCount);
+		for (VkSpecializationMapEntry& entry : entries) {
+			entry.constantID = in.get<uint32_t>();
+			entry.offset = in.get<uint32_t>();
+			entry.size = in.get<uint32_t>();
+		}
+
+		// CAEg : set 0 ɃXg[Wobt@ׂ
+		std::vector<VkDescriptorSetLayoutBinding> bindings(pipeline.bindingCount);
+		for (uint32_t i = 0; i < pipeline.bindingCount; i++) {
+			bindings[i] = { i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+		}
+		VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+		setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		setLayoutInfo.bindingCount = pipeline.bindingCount;
+		setLayoutInfo.pBindings = bindings.data();
+		vkCreateDescriptorSetLayout(device_, &setLayoutInfo, nullptr, &pipeline.setLayout);
+
+		VkPushConstantRange pushRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, pipeline.pushConstantSize };
+		VkPipelineLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.setLayoutCount = 1;
+		layoutInfo.pSetLayouts = &pipeline.setLayout;
+		layoutInfo.pushConstantRangeCount = pipeline.pushConstantSize == 0 ? 0 : 1;
+		layoutInfo.pPushConstantRanges = &pushRange;
+		vkCreatePipelineLayout(device_, &layoutInfo, nullptr, &pipeline.layout);
+
+		VkShaderModuleCreateInfo moduleInfo = {};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = spirv.size();
+		moduleInfo.pCode = reinterpret_cast<const uint32_t*>(spirv.data());
+		VkShaderModule module;
+		if (vkCreateShaderModule(device_, &moduleInfo, nullptr, &module) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shader module!");
+		}
+
+		VkSpecializationInfo specialization = {};
+		if (specializationBlob != capture::NO_BLOB) {
+			const std::vector<unsigned char>& data = blobs_.at(specializationBlob);
+			specialization.mapEntryCount = entryCount;
+			specialization.pMapEntries = entries.data();
+			specialization.dataSize = data.size();
+			specialization.pData = data.data();
+		}
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = module;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.stage.pSpecializationInfo = specializationBlob == capture::NO_BLOB ? nullptr : &specialization;
+		pipelineInfo.layout = pipeline.layout;
+		VkResult result = vkCreateComputePipelines(device_, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.pipeline);
+		vkDestroyShaderModule(device_, module, nullptr);
+		if (result != VK_SUCCESS) throw std::runtime_error("failed to create compute pipeline!");
+
+		pipelines_[id] = pipeline;
+	}
+
+	void dispatch(capture::PayloadReader& in)
+	{
+		const Pipeline& pipeline = pipelines_.at(in.get<uint32_t>());
+		uint32_t x = in.get<uint32_t>();
+		uint32_t y = in.get<uint32_t>();
+		uint32_t z = in.get<uint32_t>();
+		uint32_t pushBlob = in.get<uint32_t>();
+		uint32_t bufferCount = in.get<uint32_t>();
+		if (MAX_BINDINGS < bufferCount || pipeline.bindingCount < bufferCount) throw std::runtime_error("too many buffers in dispatch!");
+
+		vkResetDescriptorPool(device_, descriptorPool_, 0);
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool_;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &pipeline.setLayout;
+		VkDescriptorSet set;
+		if (vkAllocateDescriptorSets(device_, &allocInfo, &set) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate descriptor set!");
+		}
+
+		std::vector<VkDescriptorBufferInfo> bufferInfos(bufferCount);
+		std::vector<VkWriteDescriptorSet> writes(bufferCount);
+		for (uint32_t i = 0; i < bufferCount; i++) {
+			bufferInfos[i] = { buffers_.at(in.get<uint32_t>()).buffer, 0, VK_WHOLE_SIZE };
+			writes[i] = {};
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = set;
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo = &bufferInfos[i];
+		}
+		vkUpdateDescriptorSets(device_, bufferCount, writes.data(), 0, nullptr);
+
+		submit([&](VkCommandBuffer cmd) {
+			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0, 1, &set, 0, nullptr);
+			if (pushBlob != capture::NO_BLOB) {
+				const std::vector<unsigned char>& constants = blobs_.at(pushBlob);
+				vkCmdPushConstants(cmd, pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, static_cast<uint32_t>(constants.size()), constants.data());
+			}
+			vkCmdDispatch(cmd, x, y, z);
+		});
+	}
+};
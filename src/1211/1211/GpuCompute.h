@@ -0,0 +1,813 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ComputeBackend.h"
+#include "DebugLabels.h"
+#include "GpuTimeline.h"
+#include "GpuUploader.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
+#include "PipelineLayoutCache.h"
+#include "PipelinePermutation.h"
+#include "ShaderLibrary.h"
+#include "SpirvReflection.h"
+#include "VulkanHandle.h"
+
+/*** GPU ̌vZv~eBu ***/
+// ComputeBackend ̏ shaders/ ̃Rs[gVF[_[ŎsB
+// Ăяo̓R}hobt@ɏɋL^(Ԃɂ̓oA)Asubmit() ł܂Ƃ߂đB
+// řʂuꎞobt@ƃfXNv^ZbǵAI玟̏Ŏg񂷁B
+// foCXRs[gVF[_[ŃTuO[vZ(basic, vote, arithmetic)g
+// TuO[vł̃VF[_[gA[NO[v̑傫TuO[v̑傫猈߂B
+
+// vZɊ֌WfoCX̐
+struct ComputeDeviceFeatures
+{
+	uint32_t subgroupSize = 1;
+	bool subgroupOperations = false;// Rs[gVF[_[ŃTuO[v basic, vote, arithmetic g
+	uint32_t maxWorkGroupInvocations = 128;
+	uint32_t maxWorkGroupSize = 128;
+	uint32_t maxWorkGroupCount = 65535;
+	VkDeviceSize minStorageBufferOffsetAlignment = 256;
+
+	static ComputeDeviceFeatures query(VkPhysicalDevice physicalDevice)
+	{
+		VkPhysicalDeviceSubgroupProperties subgroup = {};
+		subgroup.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &subgroup;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+		return fromProperties(properties.properties, subgroup);
+	}
+
+	// ₢킹ς݂̒l(XibvVbgݒƂɂg)
+	static ComputeDeviceFeatures fromProperties(const VkPhysicalDeviceProperties& properties, const VkPhysicalDeviceSubgroupProperties& subgroup)
+	{
+		const VkSubgroupFeatureFlags REQUIRED = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_VOTE_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+		const VkPhysicalDeviceLimits& limits = properties.limits;
+
+		ComputeDeviceFeatures features;
+		features.subgroupSize = std::max(subgroup.subgroupSize, 1u);
+		features.subgroupOperations = (subgroup.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) != 0
+			&& (subgroup.supportedOperations & REQUIRED) == REQUIRED;
+		features.maxWorkGroupInvocations = limits.maxComputeWorkGroupInvocations;
+		features.maxWorkGroupSize = limits.maxComputeWorkGroupSize[0];
+		features.maxWorkGroupCount = limits.maxComputeWorkGroupCount[0];
+		features.minStorageBufferOffsetAlignment = std::max<VkDeviceSize>(limits.minStorageBufferOffsetAlignment, 1);
+		return features;
+	}
+};
+
+// GpuCompute ŎgXg[Wobt@(uint32_t ̔z)
+class GpuBuffer : public ComputeBuffer
+{
+	friend class GpuCompute;
+
+private:
+	UniqueBuffer buffer_;
+	UniqueDeviceMemory memory_;
+	MemoryBudgetMonitor* memoryBudget_ = nullptr;
+	uint32_t memoryType_ = 0;
+	VkDeviceSize allocationSize_ = 0;
+	size_t count_ = 0;
+
+public:
+	GpuBuffer() = default;
+	~GpuBuffer() override { reset(); }
+
+	GpuBuffer(GpuBuffer&& other) noexcept { *this = std::move(other); }
+	GpuBuffer& operator=(GpuBuffer&& other) noexcept
+	{
+		if (this != &other) {
+			reset();
+			buffer_ = std::move(other.buffer_);
+			memory_ = std::move(other.memory_);
+			memoryBudget_ = std::exchange(other.memoryBudget_, nullptr);
+			memoryType_ = other.memoryType_;
+			allocationSize_ = std::exchange(other.allocationSize_, 0);
+			count_ = std::exchange(other.count_, 0);
+		}
+		return *this;
+	}
+
+	VkBuffer get() const { return buffer_.get(); }
+	size_t size() const override { return count_; }
+	explicit operator bool() const { return static_cast<bool>(buffer_); }
+
+	// GPU ŎgIĂĂԂ
+	void reset()
+	{
+		buffer_.reset();
+		if (memory_ && memoryBudget_) memoryBudget_->trackFree(memoryType_, allocationSize_);
+		memory_.reset();
+		memoryBudget_ = nullptr;
+		allocationSize_ = 0;
+		count_ = 0;
+	}
+};
+
+class GpuCompute : public ComputeBackend
+{
+private:
+	enum Kernel { Reduce, Scan, ScanAdd, Histogram, Compact, RadixCount, RadixScatter, KERNEL_COUNT };
+
+	struct KernelSource
+	{
+		const char* name;			// shaders/ ̃t@C(gq .comp )
+		bool hasSubgroupVariant;	// "// variant: subgroup" 邩
+	};
+	static constexpr KernelSource KERNEL_SOURCES[KERNEL_COUNT] = {
+		{ "reduce", true },
+		{ "scan", true },
+		{ "scan_add", false },
+		{ "histogram", true },
+		{ "compact", true },
+		{ "radix_count", false },
+		{ "radix_scatter", true },
+	};
+
+	// shaders/include/workgroup.glsl ̓ꉻ萔
+	using WorkgroupSizeConstant = SpecConstant<0, uint32_t>;
+	using ItemsPerInvocationConstant = SpecConstant<1, uint32_t>;
+	using KernelKey = PermutationKey<WorkgroupSizeConstant, ItemsPerInvocationConstant>;
+
+	// eVF[_[̃vbV萔
+	struct CountParameters { uint32_t count; };
+	struct ReduceParameters { uint32_t count; uint32_t countNonZero; };
+	struct HistogramParameters { uint32_t count; uint32_t shift; uint32_t binCount; };
+	struct RadixParameters { uint32_t count; uint32_t shift; };
+
+	struct Pipeline
+	{
+		PipelinePermutationCache<KernelKey> permutations{ PERMUTATIONS_PER_KERNEL };
+		const PipelineLayoutCache::Layout* layout = nullptr;// PipelineLayoutCache Ă
+		size_t bindingCount = 0;
+	};
+
+	struct BufferRange
+	{
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		VkDeviceSize size;
+	};
+
+	// L^(܂͎s)̏ƁAꂪI܂Ŏg
+	struct Batch
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		std::vector<VkDescriptorPool> descriptorPools;	// Ō̂̂犄蓖Ă
+		std::vector<GpuBuffer> scratchBuffers;			// řʂu(Ō̂̂؂o)
+		VkDeviceSize scratchUsed = 0;					// Ō̈ꎞobt@̎gp(oCg)
+	};
+
+	static constexpr uint32_t RADIX_BITS = 4;// shaders/radix_*.comp  RADIX ƍ킹
+	static constexpr uint32_t RADIX = 1u << RADIX_BITS;
+	static_assert(MAX_HISTOGRAM_BINS == 256, "must match MAX_BINS in shaders/histogram.comp");
+	static constexpr uint32_t MAX_BINDINGS = 5;
+	static constexpr uint32_t SETS_PER_DESCRIPTOR_POOL = 64;
+	static constexpr VkDeviceSize MIN_SCRATCH_BUFFER_SIZE = 1 << 20;
+	static constexpr size_t PERMUTATIONS_PER_KERNEL = 4;// J[lƂɕێꉻ̐
+
+	VkDevice device_ = VK_NULL_HANDLE;
+	QueueTimeline* timeline_ = nullptr;
+	GpuUploader* uploader_ = nullptr;
+	DeletionQueue* deletionQueue_ = nullptr;// timeline ̒lŊǗĂ
+	MemoryBudgetMonitor* memoryBudget_ = nullptr;
+	ComputeDeviceFeatures features_;
+	bool useSubgroups_ = false;
+	uint32_t workgroupSize_ = 0;
+	uint32_t itemsPerInvocation_ = 0;
+
+	UniqueCommandPool commandPool_;
+	KernelKey kernelKey_;// foCXɍ킹đI񂾃[NO[v̌`
+	std::array<Pipeline, KERNEL_COUNT> pipelines_;
+	std::future<void> pipelinesReady_;// ōĂԂL
+	std::vector<UniqueDescriptorPool> descriptorPools_;
+	std::vector<VkDescriptorPool> freeDescriptorPools_;// I߂Ă(Zbgς)
+	std::vector<GpuBuffer> freeScratchBuffers_;
+	std::shared_ptr<Batch> batch_;// L^̏(܂L^ĂȂ΋)
+
+	MetricsRegistry::Counter dispatchMetric_ = MetricsRegistry::instance().counter(
+		"gpu_compute_dispatches_total", "Compute dispatches recorded by the compute primitives.");
+
+public:
+	GpuCompute() = default;
+	~GpuCompute() override { finalize(); }
+
+	GpuCompute(const GpuCompute&) = delete;
+	GpuCompute& operator=(const GpuCompute&) = delete;
+
+	// pCvC鎞@
+	enum class PipelineCreation
+	{
+		Immediate,	// initialize() ̒őSč
+		Background,	// ʂ̃XbhōAŏɎgƂɑ҂(N𑁂邽)
+	};
+
+	// timeline ̃L[(queueFamilyIndex ̂)ŎsBpCvC pipelineCache gđSč
+	// ǏЕt deletionQueue(timeline ̒lŊǗĂ)ɗa
+	// Background ̂Ƃ́AI܂ pipelineLayouts 𑼂gȂ
+	void initialize(VkDevice device, VkPhysicalDevice physicalDevice, VkPipelineCache pipelineCache,
+		QueueTimeline* timeline, uint32_t queueFamilyIndex, GpuUploader* uploader, DeletionQueue* deletionQueue, MemoryBudgetMonitor* memoryBudget,
+		const ShaderLibrary& shaders, PipelineLayoutCache& pipelineLayouts, PipelineCreation creation = PipelineCreation::Immediate)
+	{
+		device_ = device;
+		timeline_ = timeline;
+		uploader_ = uploader;
+		deletionQueue_ = deletionQueue;
+		memoryBudget_ = memoryBudget;
+		features_ = ComputeDeviceFeatures::query(physicalDevice);
+		useSubgroups_ = features_.subgroupOperations;
+		chooseWorkgroupShape(features_, &workgroupSize_, &itemsPerInvocation_);
+		kernelKey_.set<WorkgroupSizeConstant>(workgroupSize_);
+		kernelKey_.set<ItemsPerInvocationConstant>(itemsPerInvocation_);
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = queueFamilyIndex;
+		VkCommandPool commandPool;
+		if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create compute command pool!");
+		}
+		commandPool_ = UniqueCommandPool(device_, commandPool, vkDestroyCommandPool);
+
+		auto createPipelines = [this, pipelineCache, &shaders, &pipelineLayouts]() {
+			PROFILE_ZONE("create compute pipelines");
+			for (int kernel = 0; kernel < KERNEL_COUNT; kernel++) {
+				createPipeline(static_cast<Kernel>(kernel), pipelineCache, shaders, pipelineLayouts);
+			}
+		};
+		if (creation == PipelineCreation::Background) pipelinesReady_ = std::async(std::launch::async, createPipelines);
+		else createPipelines();
+	}
+
+	// ōĂpCvCł܂ő҂(̂ɎsĂA̗O𓊂)
+	void waitForPipelines()
+	{
+		if (pipelinesReady_.valid()) pipelinesReady_.get();
+	}
+
+	// VF[_[RpCƂɁASẴJ[l̃pCvC蒼(L^̏ȂƂɌĂԂ)
+	// ÂpCvC deletionQueue ɗaA܂łɑIĂj
+	void reloadPipelines(const ShaderLibrary& shaders, PipelineLayoutCache& pipelineLayouts)
+	{
+		waitForPipelines();
+		if (batch_) throw std::runtime_error("cannot reload compute pipelines while recording!");
+		for (int kernel = 0; kernel < KERNEL_COUNT; kernel++) {
+			Pipeline& pipeline = pipelines_[kernel];
+			const PipelineLayoutCache::Layout* layout;
+			size_t bindingCount;
+			auto factory = loadKernel(static_cast<Kernel>(kernel), shaders, pipelineLayouts, &layout, &bindingCount);
+			pipeline.permutations.reload(std::move(factory), kernelKey_, *deletionQueue_, timeline_->submittedValue());
+			pipeline.layout = layout;
+			pipeline.bindingCount = bindingCount;
+		}
+	}
+
+	bool pipelinesReady() const
+	{
+		return !pipelinesReady_.valid() || pipelinesReady_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	// SďIAdeletionQueue  flush() Ŗ߂ĂĂĂԂ
+	// (pCvCCAEg PipelineLayoutCache Ă̂ŁÂƂłЕt)
+	void finalize()
+	{
+		if (pipelinesReady_.valid()) pipelinesReady_.wait();// ЕtƂ́ÂɎsĂĂȂ
+		pipelinesReady_ = std::future<void>();
+		if (batch_) {
+			release(*batch_);// L^őĂȂ͎̂Ă
+			batch_.reset();
+		}
+		for (Pipeline& pipeline : pipelines_) pipeline.permutations.clear();
+		freeScratchBuffers_.clear();
+		freeDescriptorPools_.clear();
+		descriptorPools_.clear();
+		commandPool_.reset();
+	}
+
+	// [NO[v̑傫: TuO[vł̓TuO[v̑傫 2 (TuO[v̘a 1 ̃XLő)A
+	// Lł 256BǂfoCX̏ȉ 2 ׂ̂ɂB
+	// 1 [NO[v󂯎vf́A[NO[v̑傫ɂ炸 4096 OɂB
+	static void chooseWorkgroupShape(const ComputeDeviceFeatures& features, uint32_t* workgroupSize, uint32_t* itemsPerInvocation)
+	{
+		uint32_t size = features.subgroupOperations ? std::clamp(features.subgroupSize * features.subgroupSize, 64u, 1024u) : 256u;
+		uint32_t limit = std::min(features.maxWorkGroupInvocations, features.maxWorkGroupSize);
+		while (limit < size) size /= 2;
+		*workgroupSize = size;
+		*itemsPerInvocation = std::clamp(4096u / size, 2u, 16u);
+	}
+
+	const ComputeDeviceFeatures& features() const { return features_; }
+	bool usesSubgroupKernels() const { return useSubgroups_; }
+	uint32_t workgroupSize() const { return workgroupSize_; }
+	uint32_t blockSize() const { return workgroupSize_ * itemsPerInvocation_; }// 1 [NO[v󂯎vf
+
+	const char* name() const override { return "gpu"; }
+
+	std::string description() const override
+	{
+		return "gpu (workgroup: " + std::to_string(workgroupSize_) + ", block: " + std::to_string(blockSize())
+			+ ", subgroup size: " + std::to_string(features_.subgroupSize)
+			+ ", subgroup kernels: " + (usesSubgroupKernels() ? "yes" : "no") + ")";
+	}
+
+	std::unique_ptr<ComputeBuffer> createBuffer(size_t count) override
+	{
+		return std::make_unique<GpuBuffer>(createStorageBuffer(count));
+	}
+
+	// data  buffer ̐擪֓](܂łɋL^͐ɑ̂ŁAԂ͌Ă񂾏ɂȂ)
+	void write(ComputeBuffer& buffer, const std::vector<uint32_t>& data) override
+	{
+		checkSize(buffer, data.size());
+		if (data.empty()) return;
+		submit();
+		uploader_->upload(cast<GpuBuffer>(buffer).get(), data);
+	}
+
+	// L^𑗂A܂ő҂
+	std::vector<uint32_t> read(const ComputeBuffer& buffer, size_t count) override
+	{
+		checkSize(buffer, count);
+		std::vector<uint32_t> data(count);
+		if (count == 0) return data;
+
+		GpuBuffer readback = createBuffer(count, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+		VkCommandBuffer commandBuffer = record();
+		VkBufferCopy region = {};
+		region.size = count * sizeof(uint32_t);
+		vkCmdCopyBuffer(commandBuffer, cast<GpuBuffer>(buffer).get(), readback.get(), 1, &region);
+
+		VkMemoryBarrier hostBarrier = {};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+		TimelinePoint done = submit();
+		timeline_->wait(done.value);
+
+		void* mapped;
+		if (vkMapMemory(device_, readback.memory_.get(), 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+			throw std::runtime_error("failed to map readback memory!");
+		}
+		std::memcpy(data.data(), mapped, count * sizeof(uint32_t));
+		vkUnmapMemory(device_, readback.memory_.get());
+		return data;
+	}
+
+	// L^𑗂A܂ő҂ČЕt
+	void finish() override
+	{
+		TimelinePoint done = submit();
+		timeline_->wait(done.value);
+		timeline_->runCallbacks();
+		deletionQueue_->collect(done.value);
+	}
+
+	/*** vZv~eBu(L^邾ŁÂ submit()Eread()Efinish()) ***/
+	void copy(const ComputeBuffer& source, ComputeBuffer& destination, size_t count) override
+	{
+		checkSize(source, count);
+		checkSize(destination, count);
+		if (count == 0) return;
+
+		VkCommandBuffer commandBuffer = record();
+		VkBufferCopy region = {};
+		region.size = count * sizeof(uint32_t);
+		vkCmdCopyBuffer(commandBuffer, cast<GpuBuffer>(source).get(), cast<GpuBuffer>(destination).get(), 1, &region);
+		barrier();
+	}
+
+	void reduce(const ComputeBuffer& input, size_t count, ComputeBuffer& result) override
+	{
+		checkSize(input, count);
+		checkSize(result, 1);
+
+		VkCommandBuffer commandBuffer = record();
+		DEBUG_CMD_LABEL(commandBuffer, "reduce");
+		if (count == 0) {
+			vkCmdFillBuffer(commandBuffer, cast<GpuBuffer>(result).get(), 0, sizeof(uint32_t), 0);
+			barrier();
+			return;
+		}
+		recordReduce(whole(input), static_cast<uint32_t>(count), whole(result));
+	}
+
+	void exclusiveScan(const ComputeBuffer& input, ComputeBuffer& output, size_t count) override
+	{
+		checkSize(input, count);
+		checkSize(output, count);
+		if (count == 0) return;
+
+		DEBUG_CMD_LABEL(record(), "exclusive scan");
+		recordExclusiveScan(whole(input), whole(output), static_cast<uint32_t>(count));
+	}
+
+	void histogram(const ComputeBuffer& input, size_t count, ComputeBuffer& bins, uint32_t binCount, uint32_t shift = 0) override
+	{
+		checkHistogram(binCount, shift);
+		checkSize(input, count);
+		checkSize(bins, binCount);
+
+		VkCommandBuffer commandBuffer = record();
+		DEBUG_CMD_LABEL(commandBuffer, "histogram");
+		vkCmdFillBuffer(commandBuffer, cast<GpuBuffer>(bins).get(), 0, binCount * sizeof(uint32_t), 0);
+		barrier();
+		if (count == 0) return;
+
+		uint32_t n = static_cast<uint32_t>(count);
+		dispatch(Histogram, { whole(input), whole(bins) }, HistogramParameters{ n, shift, binCount }, blockCount(n));
+	}
+
+	void compact(const ComputeBuffer& values, const ComputeBuffer& flags, size_t count, ComputeBuffer& output, ComputeBuffer& outputCount) override
+	{
+		checkSize(values, count);
+		checkSize(flags, count);
+		checkSize(output, count);
+		checkSize(outputCount, 1);
+
+		VkCommandBuffer commandBuffer = record();
+		DEBUG_CMD_LABEL(commandBuffer, "compact");
+		if (count == 0) {
+			vkCmdFillBuffer(commandBuffer, cast<GpuBuffer>(outputCount).get(), 0, sizeof(uint32_t), 0);
+			barrier();
+			return;
+		}
+
+		// ubNƂɎc𐔂AXLăubN̏݊JnʒuɂĂl߂
+		uint32_t n = static_cast<uint32_t>(count);
+		uint32_t blocks = blockCount(n);
+		BufferRange offsets = scratch(blocks);
+		dispatch(Reduce, { whole(flags), offsets }, ReduceParameters{ n, 1 }, blocks);
+		recordExclusiveScan(offsets, offsets, blocks);
+		dispatch(Compact, { whole(values), whole(flags), offsets, whole(output), whole(outputCount) }, CountParameters{ n }, blocks);
+	}
+
+	void radixSort(ComputeBuffer& keys, ComputeBuffer& temporary, size_t count, uint32_t keyBits = 32) override
+	{
+		checkKeyBits(keyBits);
+		checkSize(keys, count);
+		checkSize(temporary, count);
+		if (count < 2) return;
+
+		VkCommandBuffer commandBuffer = record();
+		DEBUG_CMD_LABEL(commandBuffer, "radix sort");
+
+		// 4 rbg: Ƃ̐𐔂AXLď݈ʒuɂAבւ
+		uint32_t n = static_cast<uint32_t>(count);
+		uint32_t blocks = blockCount(n);
+		BufferRange histograms = scratch(static_cast<size_t>(blocks) * RADIX);
+		BufferRange source = whole(keys);
+		BufferRange destination = whole(temporary);
+		for (uint32_t shift = 0; shift < keyBits; shift += RADIX_BITS) {
+			RadixParameters parameters = { n, shift };
+			dispatch(RadixCount, { source, histograms }, parameters, blocks);
+			recordExclusiveScan(histograms, histograms, blocks * RADIX);
+			dispatch(RadixScatter, { source, destination, histograms }, parameters, blocks);
+			std::swap(source, destination);
+		}
+
+		// pX̐Ȃ猋ʂ temporary ɂ̂Ŗ߂
+		if (source.buffer != cast<GpuBuffer>(keys).get()) {
+			VkBufferCopy region = {};
+			region.size = count * sizeof(uint32_t);
+			vkCmdCopyBuffer(commandBuffer, source.buffer, cast<GpuBuffer>(keys).get(), 1, &region);
+			barrier();
+		}
+	}
+
+	// L^𑗂(L^ĂȂ΁AŌɑ̒lԂ)
+	TimelinePoint submit()
+	{
+		if (!batch_) return { timeline_, timeline_->submittedValue() };
+
+		std::shared_ptr<Batch> batch = std::move(batch_);
+		batch_.reset();
+		vkEndCommandBuffer(batch->commandBuffer);
+
+		uint64_t value;
+		try {
+			value = timeline_->submit({ batch->commandBuffer });
+		}
+		catch (...) {
+			release(*batch);
+			throw;
+		}
+
+		// IAR}hobt@AfXNv^v[ƈꎞobt@̏ɉ
+		deletionQueue_->defer(value, [this, batch]() { release(*batch); });
+		return { timeline_, value };
+	}
+
+private:
+	// J[l̓ꉻƂ̃pCvC悤ɂAkernelKey_ ̂̂Ă
+	void createPipeline(Kernel kernel, VkPipelineCache pipelineCache, const ShaderLibrary& shaders, PipelineLayoutCache& pipelineLayouts)
+	{
+		Pipeline& pipeline = pipelines_[kernel];
+		auto factory = loadKernel(kernel, shaders, pipelineLayouts, &pipeline.layout, &pipeline.bindingCount);
+		pipeline.permutations.initialize(device_, pipelineCache, timeline_, std::move(factory));
+		pipeline.permutations.get(kernelKey_);
+	}
+
+	// J[l̃VF[_[ǂݍŃpCvCCAEg߁AꉻƂ̃pCvC֐Ԃ
+	PipelinePermutationCache<KernelKey>::Factory loadKernel(Kernel kernel, const ShaderLibrary& shaders, PipelineLayoutCache& pipelineLayouts,
+		const PipelineLayoutCache::Layout** layout, size_t* bindingCount) const
+	{
+		const KernelSource& source = KERNEL_SOURCES[kernel];
+		std::string name = std::string(source.name) + (useSubgroups_ && source.hasSubgroupVariant ? ".subgroup" : "") + ".comp";
+		std::vector<uint32_t> code = shaders.loadSpirv(name);
+
+		ShaderReflection reflection = SpirvReflector::reflect(code);
+		if (MAX_BINDINGS < reflection.bindings.size()) throw std::runtime_error("too many bindings in compute kernel " + name + " !");
+		*layout = &pipelineLayouts.get(reflection);
+		*bindingCount = reflection.bindings.size();
+
+		return [code = std::move(code), name, layout = *layout](VkDevice device, VkPipelineCache cache, const VkSpecializationInfo& specialization) {
+			UniqueShaderModule module = ShaderLibrary::createModule(device, code);
+			VkComputePipelineCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			createInfo.stage.module = module.get();
+			createInfo.stage.pName = "main";
+			createInfo.stage.pSpecializationInfo = &specialization;
+			createInfo.layout = layout->pipelineLayout;
+
+			VkPipeline handle;
+			if (vkCreateComputePipelines(device, cache, 1, &createInfo, nullptr, &handle) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create compute pipeline " + name + " !");
+			}
+			DEBUG_NAME(device, handle, name.c_str());
+			return handle;
+		};
+	}
+
+	GpuBuffer createStorageBuffer(size_t count)
+	{
+		return createBuffer(count, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+
+	GpuBuffer createBuffer(size_t count, VkBufferUsageFlags usage, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+	{
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = std::max<VkDeviceSize>(count, 1) * sizeof(uint32_t);
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkBuffer buffer;
+		if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create compute buffer!");
+		}
+		GpuBuffer result;
+		result.buffer_ = UniqueBuffer(device_, buffer, vkDestroyBuffer);
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device_, buffer, &requirements);
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, required, preferred, requirements.size);
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(device_, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate compute buffer memory!");
+		}
+		result.memory_ = UniqueDeviceMemory(device_, memory, vkFreeMemory);
+		result.memoryBudget_ = memoryBudget_;
+		result.memoryType_ = allocInfo.memoryTypeIndex;
+		result.allocationSize_ = requirements.size;
+		result.count_ = count;
+		memoryBudget_->trackAllocation(result.memoryType_, result.allocationSize_);
+		vkBindBufferMemory(device_, buffer, memory, 0);
+		return result;
+	}
+
+	// preferred ̂ size \ZɎ܂̂΂A required 𖞂̂I
+	// (foCX[Jȃq[v\Z𒴂Ƃ́AxĂzXg̃ɒu)
+	uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, VkDeviceSize size) const
+	{
+		const VkPhysicalDeviceMemoryProperties& properties = memoryBudget_->memoryProperties();
+		for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+			VkMemoryPropertyFlags flags = required | preferred;
+			if ((typeBits & (1u << i)) && (properties.memoryTypes[i].propertyFlags & flags) == flags && memoryBudget_->fitsInBudget(i, size)) return i;
+		}
+		for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+			if ((typeBits & (1u << i)) && (properties.memoryTypes[i].propertyFlags & required) == required) return i;
+		}
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	static BufferRange whole(const ComputeBuffer& buffer) { return { cast<GpuBuffer>(buffer).get(), 0, VK_WHOLE_SIZE }; }
+
+	uint32_t blockCount(uint32_t count) const
+	{
+		return static_cast<uint32_t>((static_cast<uint64_t>(count) + blockSize() - 1) / blockSize());
+	}
+
+	// L^̃R}hobt@(΍AOɑ]̌Ɏs悤ɃoA)
+	VkCommandBuffer record()
+	{
+		if (batch_) return batch_->commandBuffer;
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = commandPool_.get();
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		auto batch = std::make_shared<Batch>();
+		if (vkAllocateCommandBuffers(device_, &allocInfo, &batch->commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate compute command buffer!");
+		}
+		DEBUG_NAME(device_, batch->commandBuffer, "compute batch");
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(batch->commandBuffer, &beginInfo);
+
+		batch_ = std::move(batch);
+		barrier();
+		return batch_->commandBuffer;
+	}
+
+	// ÕfBXpb`E]݂̏ÃfBXpb`E]猩悤ɂ
+	void barrier()
+	{
+		VkMemoryBarrier memoryBarrier = {};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		vkCmdPipelineBarrier(batch_->commandBuffer, stages, stages, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	template <typename Parameters>
+	void dispatch(Kernel kernel, std::initializer_list<BufferRange> buffers, const Parameters& parameters, uint32_t groupCount)
+	{
+		waitForPipelines();
+		Pipeline& pipeline = pipelines_[kernel];
+		if (buffers.size() != pipeline.bindingCount || sizeof(Parameters) != pipeline.layout->pushConstantRange.size) {
+			throw std::runtime_error(std::string("arguments do not match compute kernel ") + KERNEL_SOURCES[kernel].name + " !");
+		}
+		if (features_.maxWorkGroupCount < groupCount) throw std::runtime_error("too many elements for compute primitives!");
+
+		VkDescriptorSet set = allocateDescriptorSet(pipeline.layout->setLayouts[0]);
+		VkDescriptorBufferInfo bufferInfos[MAX_BINDINGS];
+		VkWriteDescriptorSet writes[MAX_BINDINGS];
+		uint32_t binding = 0;
+		for (const BufferRange& range : buffers) {
+			bufferInfos[binding] = { range.buffer, range.offset, range.size };
+			writes[binding] = {};
+			writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[binding].dstSet = set;
+			writes[binding].dstBinding = binding;
+			writes[binding].descriptorCount = 1;
+			writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[binding].pBufferInfo = &bufferInfos[binding];
+			binding++;
+		}
+		vkUpdateDescriptorSets(device_, binding, writes, 0, nullptr);
+
+		VkCommandBuffer commandBuffer = batch_->commandBuffer;
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.permutations.get(kernelKey_));
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout->pipelineLayout, 0, 1, &set, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipeline.layout->pipelineLayout, pipeline.layout->pushConstantRange.stageFlags,
+			0, sizeof(Parameters), &parameters);
+		vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+		dispatchMetric_.add(1);
+		barrier();
+	}
+
+	// ubNƂ̘a߁A1 ɂȂ܂ŌJԂ
+	void recordReduce(BufferRange input, uint32_t count, BufferRange result)
+	{
+		while (true) {
+			uint32_t blocks = blockCount(count);
+			BufferRange sums = blocks == 1 ? result : scratch(blocks);
+			dispatch(Reduce, { input, sums }, ReduceParameters{ count, 0 }, blocks);
+			if (blocks == 1) return;
+			input = sums;
+			count = blocks;
+		}
+	}
+
+	// ubNƂɃXLAubN̑a(ċAI)XLĊeubNɑ
+	void recordExclusiveScan(BufferRange input, BufferRange output, uint32_t count)
+	{
+		uint32_t blocks = blockCount(count);
+		BufferRange blockSums = scratch(blocks);
+		dispatch(Scan, { input, output, blockSums }, CountParameters{ count }, blocks);
+		if (1 < blocks) {
+			recordExclusiveScan(blockSums, blockSums, blocks);
+			dispatch(ScanAdd, { output, blockSums }, CountParameters{ count }, blocks);
+		}
+	}
+
+	// L^̏ŎgꎞIȗ̈(I܂őł͎gȂ)
+	BufferRange scratch(size_t count)
+	{
+		VkDeviceSize size = std::max<VkDeviceSize>(count, 1) * sizeof(uint32_t);
+		VkDeviceSize alignment = features_.minStorageBufferOffsetAlignment;
+		VkDeviceSize offset = (batch_->scratchUsed + alignment - 1) / alignment * alignment;
+		if (batch_->scratchBuffers.empty() || batch_->scratchBuffers.back().size() * sizeof(uint32_t) < offset + size) {
+			batch_->scratchBuffers.push_back(acquireScratchBuffer(size));
+			offset = 0;
+		}
+		batch_->scratchUsed = offset + size;
+		return { batch_->scratchBuffers.back().get(), offset, size };
+	}
+
+	GpuBuffer acquireScratchBuffer(VkDeviceSize size)
+	{
+		for (auto it = freeScratchBuffers_.begin(); it != freeScratchBuffers_.end(); ++it) {
+			if (size <= it->size() * sizeof(uint32_t)) {
+				GpuBuffer buffer = std::move(*it);
+				freeScratchBuffers_.erase(it);
+				return buffer;
+			}
+		}
+		return createStorageBuffer(static_cast<size_t>(std::max(size, MIN_SCRATCH_BUFFER_SIZE) / sizeof(uint32_t)));
+	}
+
+	VkDescriptorSet allocateDescriptorSet(VkDescriptorSetLayout setLayout)
+	{
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &setLayout;
+
+		VkDescriptorSet set;
+		if (!batch_->descriptorPools.empty()) {
+			allocInfo.descriptorPool = batch_->descriptorPools.back();
+			if (vkAllocateDescriptorSets(device_, &allocInfo, &set) == VK_SUCCESS) return set;
+		}
+
+		// tɂȂ玟̃v[犄蓖Ă
+		allocInfo.descriptorPool = acquireDescriptorPool();
+		batch_->descriptorPools.push_back(allocInfo.descriptorPool);
+		if (vkAllocateDescriptorSets(device_, &allocInfo, &set) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate compute descriptor set!");
+		}
+		return set;
+	}
+
+	VkDescriptorPool acquireDescriptorPool()
+	{
+		if (!freeDescriptorPools_.empty()) {
+			VkDescriptorPool pool = freeDescriptorPools_.back();
+			freeDescriptorPools_.pop_back();
+			return pool;
+		}
+
+		VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SETS_PER_DESCRIPTOR_POOL * MAX_BINDINGS };
+		VkDescriptorPoolCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		createInfo.maxSets = SETS_PER_DESCRIPTOR_POOL;
+		createInfo.poolSizeCount = 1;
+		createInfo.pPoolSizes = &poolSize;
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(device_, &createInfo, nullptr, &pool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create compute descriptor pool!");
+		}
+		descriptorPools_.push_back(UniqueDescriptorPool(device_, pool, vkDestroyDescriptorPool));
+		return pool;
+	}
+
+	// I(܂͑炸Ɏ̂Ă)̂Еt
+	void release(Batch& batch)
+	{
+		vkFreeCommandBuffers(device_, commandPool_.get(), 1, &batch.commandBuffer);
+		batch.commandBuffer = VK_NULL_HANDLE;
+		for (VkDescriptorPool pool : batch.descriptorPools) {
+			vkResetDescriptorPool(device_, pool, 0);
+			freeDescriptorPools_.push_back(pool);
+		}
+		batch.descriptorPools.clear();
+		for (GpuBuffer& buffer : batch.scratchBuffers) freeScratchBuffers_.push_back(std::move(buffer));
+		batch.scratchBuffers.clear();
+	}
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "GpuTimeline.h"
+
+/*** GPU ̊҂R[` ***/
+// GPU ̏̊(TimelinePoint) co_await ő҂Ă悤ɂAǂݍ݂Ȃǂɏ悤ɂB
+//   GpuTask<> load() {
+//       TimelinePoint done = uploader.upload(buffer, data);
+//       co_await done;            // Xbh͎~߂ɒfA瑱s
+//       ...
+//   }
+// fR[` QueueTimeline::runCallbacks() ̒ōĊĴŁAt[̃[v(̃Xbh)œB
+// GpuTask ͍ŏ co_await  GpuTaskRunner::spawn() ܂Ŏsn߂ȂB
+
+// TimelinePoint  co_await ł悤ɂ
+struct TimelineAwaiter
+{
+	TimelinePoint point;
+
+	bool await_ready() { return point.timeline->isComplete(point.value); }
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		point.timeline->onComplete(point.value, [handle]() { handle.resume(); });
+	}
+	void await_resume() {}
+};
+
+inline TimelineAwaiter operator co_await(TimelinePoint point) { return { point }; }
+
+template <typename T = void>
+class GpuTask;
+
+namespace gpu_task_detail
+{
+	// IA҂ĂR[`֒ږ߂
+	struct FinalAwaiter
+	{
+		bool await_ready() noexcept { return false; }
+		template <typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+		{
+			std::coroutine_handle<> continuation = handle.promise().continuation;
+			return continuation ? continuation : std::noop_coroutine();
+		}
+		void await_resume() noexcept {}
+	};
+
+	struct PromiseBase
+	{
+		std::coroutine_handle<> continuation;
+		std::exception_ptr exception;
+
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		FinalAwaiter final_suspend() noexcept { return {}; }
+		void unhandled_exception() { exception = std::current_exception(); }
+	};
+
+	template <typename T>
+	struct Promise : PromiseBase
+	{
+		std::optional<T> value;
+
+		GpuTask<T> get_return_object();
+		void return_value(T result) { value = std::move(result); }
+	};
+
+	template <>
+	struct Promise<void> : PromiseBase
+	{
+		GpuTask<void> get_return_object();
+		void return_void() {}
+	};
+}
+
+template <typename T>
+class GpuTask
+{
+public:
+	using promise_type = gpu_task_detail::Promise<T>;
+
+private:
+	std::coroutine_handle<promise_type> handle_;
+
+public:
+	explicit GpuTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+	~GpuTask() { if (handle_) handle_.destroy(); }
+
+	GpuTask(const GpuTask&) = delete;
+	GpuTask& operator=(const GpuTask&) = delete;
+
+	GpuTask(GpuTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+	GpuTask& operator=(GpuTask&& other) noexcept
+	{
+		if (this != &other) {
+			if (handle_) handle_.destroy();
+			handle_ = std::exchange(other.handle_, nullptr);
+		}
+		return *this;
+	}
+
+	bool done() const { return !handle_ || handle_.done(); }
+
+	// ŏ̒f܂Ŏs(GpuTaskRunner Ă)
+	void start() { if (handle_ && !handle_.done()) handle_.resume(); }
+
+	// ŗOoĂΓ
+	void rethrowIfFailed() const
+	{
+		if (handle_ && handle_.promise().exception) std::rethrow_exception(handle_.promise().exception);
+	}
+
+	// ʂ̃R[` co_await ő҂(̎_Ŏsn߂)
+	auto operator co_await() && noexcept
+	{
+		struct Awaiter
+		{
+			std::coroutine_handle<promise_type> handle;
+
+			bool await_ready() { return !handle || handle.done(); }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+			{
+				handle.promise().continuation = awaiting;
+				return handle;
+			}
+			T await_resume()
+			{
+				if (handle.promise().exception) std::rethrow_exception(handle.promise().exception);
+				if constexpr (!std::is_void_v<T>) return std::move(*handle.promise().value);
+			}
+		};
+		return Awaiter{ handle_ };
+	}
+};
+
+namespace gpu_task_detail
+{
+	template <typename T>
+	GpuTask<T> Promise<T>::get_return_object() { return GpuTask<T>(std::coroutine_handle<Promise<T>>::from_promise(*this)); }
+
+	inline GpuTask<void> Promise<void>::get_return_object() { return GpuTask<void>(std::coroutine_handle<Promise<void>>::from_promise(*this)); }
+}
+
+/*** s̃^XN̊Ǘ ***/
+// N co_await Ȃ^XN(ǂݍ݂̊JnȂ)aAÎЕtB
+class GpuTaskRunner
+{
+private:
+	std::vector<GpuTask<>> tasks_;
+
+public:
+	// ^XNaĎsn߂
+	void spawn(GpuTask<> task)
+	{
+		task.start();
+		if (task.done()) {
+			task.rethrowIfFailed();
+			return;
+		}
+		tasks_.push_back(std::move(task));
+	}
+
+	// I^XNЕtA̐Ԃ(ŗOoĂΓ)
+	size_t poll()
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < tasks_.size();) {
+			if (!tasks_[i].done()) {
+				i++;
+				continue;
+			}
+			GpuTask<> task = std::move(tasks_[i]);
+			tasks_[i] = std::move(tasks_.back());
+			tasks_.pop_back();
+			count++;
+			task.rethrowIfFailed();
+		}
+		return count;
+	}
+
+	// IĂȂ^XNj(ĊJȂ܂܏IƂɌĂ)
+	void clear() { tasks_.clear(); }
+
+	size_t size() const { return tasks_.size(); }
+	bool empty() const { return tasks_.empty(); }
+};
@@ -0,0 +1,434 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "DebugLabels.h"
+#include "ScratchAllocator.h"
+
+/*** L[Ƃ GPU ̐i݋ ***/
+// L[ɑ 1, 2, 3, ... ƒPɑltAǂ܂ŏI 1 ̐lňB
+// VK_KHR_timeline_semaphore g΃^CCZ}tH 1 gA
+// gȂΑMƂɃtFXt(tFX͎g)ƂB
+// tFXoCiZ}tHƂɎɁA̒lő҂EjEAbv[h̊𔻒fB
+// VK_ERROR_DEVICE_LOST 󂯂 DeviceLostError 𓊂AȌ͑SďÎƂĈ
+// (GPU ͂sȂ̂ŁA҂Ă̂̂܂ܕЕt)B
+
+class QueueTimeline;
+
+// foCXꂽ(foCX蒼Α)
+class DeviceLostError : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// ^CĈl(̒l̏IΖ)
+struct TimelinePoint
+{
+	QueueTimeline* timeline;
+	uint64_t value;
+};
+
+class QueueTimeline
+{
+private:
+	VkDevice device_ = VK_NULL_HANDLE;
+	VkQueue queue_ = VK_NULL_HANDLE;
+	bool useTimelineSemaphore_ = false;
+
+	// ^CCZ}tH
+	VkSemaphore semaphore_ = VK_NULL_HANDLE;
+	PFN_vkGetSemaphoreCounterValueKHR getSemaphoreCounterValue_ = nullptr;
+	PFN_vkWaitSemaphoresKHR waitSemaphores_ = nullptr;
+
+	// tFXőpꍇ(Mɕ)
+	struct PendingFence
+	{
+		uint64_t value;
+		VkFence fence;
+	};
+	std::deque<PendingFence> pendingFences_;
+	std::vector<VkFence> freeFences_;
+
+	uint64_t submittedValue_ = 0;	// ŌɑM̒l
+	uint64_t completedValue_ = 0;	// IƂmFłl
+	bool lost_ = false;				// foCXꂽ
+
+	std::multimap<uint64_t, std::function<void()>> callbacks_;// lIĂԊ֐
+
+public:
+	QueueTimeline() = default;
+	~QueueTimeline() { finalize(); }
+
+	QueueTimeline(const QueueTimeline&) = delete;
+	QueueTimeline& operator=(const QueueTimeline&) = delete;
+
+	// timelineSemaphoreEnabled ̓foCX쐬 timelineSemaphore ̋@\Lɂǂ
+	void initialize(VkDevice device, VkQueue queue, bool timelineSemaphoreEnabled)
+	{
+		device_ = device;
+		queue_ = queue;
+		useTimelineSemaphore_ = timelineSemaphoreEnabled;
+		submittedValue_ = 0;
+		completedValue_ = 0;
+		lost_ = false;
+		if (!useTimelineSemaphore_) return;
+
+		getSemaphoreCounterValue_ = (PFN_vkGetSemaphoreCounterValueKHR)vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+		waitSemaphores_ = (PFN_vkWaitSemaphoresKHR)vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+		if (getSemaphoreCounterValue_ == nullptr || waitSemaphores_ == nullptr) {
+			useTimelineSemaphore_ = false;// ֐Ȃ΃tFXőp
+			return;
+		}
+
+		VkSemaphoreTypeCreateInfoKHR typeInfo = {};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		createInfo.pNext = &typeInfo;
+		if (vkCreateSemaphore(device_, &createInfo, nullptr, &semaphore_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create timeline semaphore!");
+		}
+	}
+
+	// GPU ̏SďIĂĂԂ
+	void finalize()
+	{
+		if (device_ == VK_NULL_HANDLE) return;
+
+		if (semaphore_ != VK_NULL_HANDLE) vkDestroySemaphore(device_, semaphore_, nullptr);
+		for (const PendingFence& pending : pendingFences_) vkDestroyFence(device_, pending.fence, nullptr);
+		for (VkFence fence : freeFences_) vkDestroyFence(device_, fence, nullptr);
+		semaphore_ = VK_NULL_HANDLE;
+		pendingFences_.clear();
+		freeFences_.clear();
+		callbacks_.clear();
+		device_ = VK_NULL_HANDLE;
+	}
+
+	bool usesTimelineSemaphore() const { return useTimelineSemaphore_; }
+	bool isLost() const { return lost_; }
+	uint64_t submittedValue() const { return submittedValue_; }
+	VkSemaphore semaphore() const { return semaphore_; }// tFXőpĂƂ VK_NULL_HANDLE
+
+	// R}hobt@𑗐MÅ\lԂ
+	// waits ̒l܂ő̃L[̏iނ̂҂Ăs
+	// (tFXőpĂƂ GPU ő҂ĂȂ̂ŁAMO CPU ő҂)
+	uint64_t submit(const std::vector<VkCommandBuffer>& commandBuffers,
+		const std::vector<TimelinePoint>& waits = {}, VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)
+	{
+		return useTimelineSemaphore_ ? submit<true>(commandBuffers, waits, waitStage) : submit<false>(commandBuffers, waits, waitStage);
+	}
+
+	// ȉ̃ev[gł́AUseTimelineSemaphore  usesTimelineSemaphore() ƈvĂ邱
+	// (DeviceCapabilities.h  dispatchCapabilities() őIŁAt[Ƃ̏ŕ򂵂Ȃ悤ɂ)
+	template <bool UseTimelineSemaphore>
+	uint64_t submit(const std::vector<VkCommandBuffer>& commandBuffers,
+		const std::vector<TimelinePoint>& waits = {}, VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)
+	{
+		if (lost_) throw DeviceLostError("device lost!");
+		uint64_t value = submittedValue_ + 1;
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+		submitInfo.pCommandBuffers = commandBuffers.data();
+
+		VkResult result;
+		if constexpr (UseTimelineSemaphore) {
+			SmallVector<VkSemaphore, 8> waitSemaphores;
+			SmallVector<uint64_t, 8> waitValues;
+			SmallVector<VkPipelineStageFlags, 8> waitStages;
+			for (const TimelinePoint& wait : waits) {
+				if (wait.timeline == this || wait.value <= wait.timeline->completedValue_) continue;// L[̏͏ԂɎs
+				if (!wait.timeline->useTimelineSemaphore_) {
+					wait.timeline->wait(wait.value);
+					continue;
+				}
+				waitSemaphores.push_back(wait.timeline->semaphore_);
+				waitValues.push_back(wait.value);
+				waitStages.push_back(waitStage);
+			}
+
+			VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+			timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+			timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+			timelineInfo.pWaitSemaphoreValues = waitValues.data();
+			timelineInfo.signalSemaphoreValueCount = 1;
+			timelineInfo.pSignalSemaphoreValues = &value;
+
+			submitInfo.pNext = &timelineInfo;
+			submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+			submitInfo.pWaitSemaphores = waitSemaphores.data();
+			submitInfo.pWaitDstStageMask = waitStages.data();
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &semaphore_;
+
+			result = vkQueueSubmit(queue_, 1, &submitInfo, VK_NULL_HANDLE);
+		}
+		else {
+			for (const TimelinePoint& wait : waits) {
+				if (wait.timeline != this) wait.timeline->wait(wait.value);
+			}
+
+			VkFence fence = acquireFence();
+			result = vkQueueSubmit(queue_, 1, &submitInfo, fence);
+			if (result == VK_SUCCESS) pendingFences_.push_back({ value, fence });
+			else freeFences_.push_back(fence);
+		}
+
+		if (result == VK_ERROR_DEVICE_LOST) {
+			markLost();
+			throw DeviceLostError("device lost while submitting to queue!");
+		}
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit to queue!");
+		}
+		submittedValue_ = value;
+		return value;
+	}
+
+	// Il GPU ɖ₢킹(҂Ȃ)
+	uint64_t completedValue()
+	{
+		return useTimelineSemaphore_ ? completedValue<true>() : completedValue<false>();
+	}
+
+	template <bool UseTimelineSemaphore>
+	uint64_t completedValue()
+	{
+		if (lost_) return completedValue_;
+
+		VkResult result = VK_SUCCESS;
+		if constexpr (UseTimelineSemaphore) {
+			uint64_t value = 0;
+			result = getSemaphoreCounterValue_(device_, semaphore_, &value);
+			if (result == VK_SUCCESS) completedValue_ = value;
+		}
+		else {
+			while (!pendingFences_.empty()) {
+				result = vkGetFenceStatus(device_, pendingFences_.front().fence);
+				if (result != VK_SUCCESS) break;
+				completedValue_ = pendingFences_.front().value;
+				releaseFence(pendingFences_.front().fence);
+				pendingFences_.pop_front();
+			}
+		}
+		if (result == VK_ERROR_DEVICE_LOST) {
+			markLost();
+			throw DeviceLostError("device lost while polling timeline!");
+		}
+		return completedValue_;
+	}
+
+	bool isComplete(uint64_t value) { return value <= completedValue_ || value <= completedValue(); }
+
+	template <bool UseTimelineSemaphore>
+	bool isComplete(uint64_t value) { return value <= completedValue_ || value <= completedValue<UseTimelineSemaphore>(); }
+
+	// value ܂ŏÎ҂BԐ؂Ȃ false
+	bool wait(uint64_t value, uint64_t timeoutNanoseconds = UINT64_MAX)
+	{
+		return useTimelineSemaphore_ ? wait<true>(value, timeoutNanoseconds) : wait<false>(value, timeoutNanoseconds);
+	}
+
+	template <bool UseTimelineSemaphore>
+	bool wait(uint64_t value, uint64_t timeoutNanoseconds = UINT64_MAX)
+	{
+		if (isComplete<UseTimelineSemaphore>(value)) return true;
+		if (submittedValue_ < value) throw std::runtime_error("waiting for a timeline value that was never submitted!");
+
+		VkResult result;
+		if constexpr (UseTimelineSemaphore) {
+			VkSemaphoreWaitInfoKHR waitInfo = {};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &semaphore_;
+			waitInfo.pValues = &value;
+			result = waitSemaphores_(device_, &waitInfo, timeoutNanoseconds);
+		}
+		else {
+			VkFence fence = fenceFor(value);
+			result = vkWaitForFences(device_, 1, &fence, VK_TRUE, timeoutNanoseconds);
+		}
+		if (result == VK_ERROR_DEVICE_LOST) {
+			markLost();
+			throw DeviceLostError("device lost while waiting for timeline!");
+		}
+		if (result != VK_SUCCESS && result != VK_TIMEOUT) {
+			throw std::runtime_error("failed to wait for timeline!");
+		}
+		completedValue<UseTimelineSemaphore>();// L^ĂlXV
+		return result == VK_SUCCESS;
+	}
+
+	// SĂ̒lÎ҂(̃L[ɂ܂Ă悢)
+	static bool waitAll(const std::vector<TimelinePoint>& points, uint64_t timeoutNanoseconds = UINT64_MAX)
+	{
+		return waitPoints(points.data(), points.size(), true, timeoutNanoseconds);
+	}
+
+	// ǂꂩ 1 ̒lÎ҂
+	static bool waitAny(const std::vector<TimelinePoint>& points, uint64_t timeoutNanoseconds = UINT64_MAX)
+	{
+		return waitPoints(points.data(), points.size(), false, timeoutNanoseconds);
+	}
+
+	// value I callback Ă(Ă΂̂ runCallbacks() ̒)
+	void onComplete(uint64_t value, std::function<void()> callback)
+	{
+		callbacks_.emplace(value, std::move(callback));
+	}
+
+	// Il̃R[obNl̏ɌĂсAĂ񂾐Ԃ(t[ƂɌĂ)
+	size_t runCallbacks()
+	{
+		return useTimelineSemaphore_ ? runCallbacks<true>() : runCallbacks<false>();
+	}
+
+	template <bool UseTimelineSemaphore>
+	size_t runCallbacks()
+	{
+		if (callbacks_.empty()) return 0;
+
+		uint64_t completed = completedValue<UseTimelineSemaphore>();
+		size_t count = 0;
+		while (!callbacks_.empty() && callbacks_.begin()->first <= completed) {
+			std::function<void()> callback = std::move(callbacks_.begin()->second);
+			callbacks_.erase(callbacks_.begin());
+			callback();
+			count++;
+		}
+		return count;
+	}
+
+private:
+	// ͑SďIƂɂ(tFX GPU GȂ̂ŁÂ܂܎g񂵂ɖ߂)
+	void markLost()
+	{
+		lost_ = true;
+		completedValue_ = submittedValue_;
+		for (const PendingFence& pending : pendingFences_) freeFences_.push_back(pending.fence);
+		pendingFences_.clear();
+	}
+
+	VkFence acquireFence()
+	{
+		if (!freeFences_.empty()) {
+			VkFence fence = freeFences_.back();
+			freeFences_.pop_back();
+			return fence;
+		}
+
+		VkFenceCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkFence fence;
+		if (vkCreateFence(device_, &createInfo, nullptr, &fence) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create fence!");
+		}
+		DEBUG_NAME(device_, fence, "timeline fence");
+		return fence;
+	}
+
+	void releaseFence(VkFence fence)
+	{
+		vkResetFences(device_, 1, &fence);
+		freeFences_.push_back(fence);
+	}
+
+	// value m点tFX(value ȏ̒lōŏɑM)
+	VkFence fenceFor(uint64_t value) const
+	{
+		for (const PendingFence& pending : pendingFences_) {
+			if (value <= pending.value) return pending.fence;
+		}
+		return VK_NULL_HANDLE;
+	}
+
+	static bool waitPoints(const TimelinePoint* points, size_t count, bool waitForAll, uint64_t timeoutNanoseconds)
+	{
+		// ɏIĂ̂͏
+		SmallVector<TimelinePoint, 8> pending;
+		for (size_t i = 0; i < count; i++) {
+			const TimelinePoint& point = points[i];
+			if (!point.timeline->isComplete(point.value)) pending.push_back(point);
+			else if (!waitForAll) return true;
+		}
+		if (pending.empty()) return true;
+
+		for (const TimelinePoint& point : pending) {
+			if (point.timeline->submittedValue_ < point.value) {
+				throw std::runtime_error("waiting for a timeline value that was never submitted!");
+			}
+		}
+
+		// foCX̑҂ 1 ̌Ăяoɂ܂Ƃ߂(^CCƃtFX͍Ȃ̂ŕʁXɑ҂)
+		VkDevice device = pending[0].timeline->device_;
+		SmallVector<VkSemaphore, 8> semaphores;
+		SmallVector<uint64_t, 8> values;
+		SmallVector<VkFence, 8> fences;
+		PFN_vkWaitSemaphoresKHR waitSemaphores = nullptr;
+		for (const TimelinePoint& point : pending) {
+			if (point.timeline->device_ != device) {
+				throw std::runtime_error("timeline points must belong to the same device!");
+			}
+			if (point.timeline->useTimelineSemaphore_) {
+				semaphores.push_back(point.timeline->semaphore_);
+				values.push_back(point.value);
+				waitSemaphores = point.timeline->waitSemaphores_;
+			}
+			else {
+				fences.push_back(point.timeline->fenceFor(point.value));
+			}
+		}
+
+		VkResult result = VK_SUCCESS;
+		if (!semaphores.empty() && (waitForAll || fences.empty())) {
+			VkSemaphoreWaitInfoKHR waitInfo = {};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+			waitInfo.flags = waitForAll ? 0 : VK_SEMAPHORE_WAIT_ANY_BIT_KHR;
+			waitInfo.semaphoreCount = static_cast<uint32_t>(semaphores.size());
+			waitInfo.pSemaphores = semaphores.data();
+			waitInfo.pValues = values.data();
+			result = waitSemaphores(device, &waitInfo, timeoutNanoseconds);
+		}
+		if (result == VK_SUCCESS && !fences.empty() && (waitForAll || semaphores.empty())) {
+			result = vkWaitForFences(device, static_cast<uint32_t>(fences.size()), fences.data(), waitForAll ? VK_TRUE : VK_FALSE, timeoutNanoseconds);
+		}
+		if (result == VK_ERROR_DEVICE_LOST) {
+			for (const TimelinePoint& point : pending) point.timeline->markLost();
+			throw DeviceLostError("device lost while waiting for timeline!");
+		}
+		if (result != VK_SUCCESS && result != VK_TIMEOUT) {
+			throw std::runtime_error("failed to wait for timeline!");
+		}
+
+		// uǂꂩ 1 v́AI܂ŏɖ₢킹
+		if (!waitForAll && !semaphores.empty() && !fences.empty()) {
+			auto start = std::chrono::steady_clock::now();
+			for (;;) {
+				for (const TimelinePoint& point : pending) {
+					if (point.timeline->isComplete(point.value)) return true;
+				}
+				auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+				if (timeoutNanoseconds <= static_cast<uint64_t>(elapsed)) return false;
+				std::this_thread::yield();
+			}
+		}
+
+		for (const TimelinePoint& point : pending) point.timeline->completedValue();// L^ĂlXV
+		return result == VK_SUCCESS;
+	}
+};
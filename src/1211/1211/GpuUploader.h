@@ -0,0 +1,184 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "DebugLabels.h"
+#include "GpuTimeline.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
+#include "VulkanHandle.h"
+
+/*** obt@ւ̃f[^̓] ***/
+// CPU ̃f[^Xe[WOobt@(CPU 珑߂郁)ɃRs[A]R}h GPU ̃obt@֑B
+// ҂ TimelinePoint Ԃ̂ŁAKvȏ co_await 邩 QueueTimeline::wait() ő҂B
+// Xe[WOobt@ƃR}hobt@́A]IƂ QueueTimeline ̃R[obNŉ(MOɎsƂ UniqueHandle )B
+//   co_await uploader.upload(buffer, vertices);
+
+class GpuUploader
+{
+private:
+	VkDevice device_ = VK_NULL_HANDLE;
+	QueueTimeline* timeline_ = nullptr;
+	MemoryBudgetMonitor* memoryBudget_ = nullptr;
+	UniqueCommandPool commandPool_;
+	uint32_t stagingMemoryType_ = 0;
+
+	MetricsRegistry::Counter uploadBytesMetric_ = MetricsRegistry::instance().counter(
+		"gpu_upload_bytes_total", "Bytes copied to device buffers through staging buffers.");
+
+public:
+	GpuUploader() = default;
+	~GpuUploader() { finalize(); }
+
+	GpuUploader(const GpuUploader&) = delete;
+	GpuUploader& operator=(const GpuUploader&) = delete;
+
+	// timeline ̃L[(queueFamilyIndex ̂)œ]
+	void initialize(VkDevice device, QueueTimeline* timeline, uint32_t queueFamilyIndex, MemoryBudgetMonitor* memoryBudget)
+	{
+		device_ = device;
+		timeline_ = timeline;
+		memoryBudget_ = memoryBudget;
+		stagingMemoryType_ = findMemoryType(memoryBudget->memoryProperties(), ~0u,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;// 1 ĝĂR}hobt@
+		poolInfo.queueFamilyIndex = queueFamilyIndex;
+		VkCommandPool commandPool;
+		if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create upload command pool!");
+		}
+		commandPool_ = UniqueCommandPool(device_, commandPool, vkDestroyCommandPool);
+		DEBUG_NAME(device_, commandPool, "upload command pool");
+	}
+
+	// ]SďIĂĂԂ(QueueTimeline::runCallbacks() ŃXe[WOobt@ꂽ)
+	void finalize()
+	{
+		commandPool_.reset();
+	}
+
+	// size ̃Xe[WOobt@mۂĂ\ZɎ܂邩(܂ȂƂ́AĂԑœ]̃t[ɉ)
+	bool stagingFits(VkDeviceSize size) const
+	{
+		return memoryBudget_->fitsInBudget(stagingMemoryType_, size);
+	}
+
+	// data  dst  offset ̈ʒu֓]
+	TimelinePoint upload(VkBuffer dst, const void* data, VkDeviceSize size, VkDeviceSize offset = 0)
+	{
+		// Xe[WOobt@ɃRs[
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkBuffer stagingHandle;
+		if (vkCreateBuffer(device_, &bufferInfo, nullptr, &stagingHandle) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create staging buffer!");
+		}
+		UniqueBuffer staging(device_, stagingHandle, vkDestroyBuffer);
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device_, staging.get(), &requirements);
+		if ((requirements.memoryTypeBits & (1u << stagingMemoryType_)) == 0) {
+			throw std::runtime_error("staging buffer cannot use host visible memory!");
+		}
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = stagingMemoryType_;
+
+		VkDeviceMemory memoryHandle;
+		if (vkAllocateMemory(device_, &allocInfo, nullptr, &memoryHandle) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate staging memory!");
+		}
+		UniqueDeviceMemory memory(device_, memoryHandle, vkFreeMemory);
+		vkBindBufferMemory(device_, staging.get(), memory.get(), 0);
+		DEBUG_NAME(device_, staging.get(), "upload staging");
+		DEBUG_NAME(device_, memory.get(), "upload staging memory");
+
+		void* mapped;
+		if (vkMapMemory(device_, memory.get(), 0, size, 0, &mapped) != VK_SUCCESS) {
+			throw std::runtime_error("failed to map staging memory!");
+		}
+		std::memcpy(mapped, data, static_cast<size_t>(size));
+		vkUnmapMemory(device_, memory.get());
+
+		// ]R}h
+		VkCommandBufferAllocateInfo commandInfo = {};
+		commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		commandInfo.commandPool = commandPool_.get();
+		commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		commandInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(device_, &commandInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate upload command buffer!");
+		}
+		DEBUG_NAME(device_, commandBuffer, "upload");
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+		VkBufferCopy region = {};
+		region.dstOffset = offset;
+		region.size = size;
+		vkCmdCopyBuffer(commandBuffer, staging.get(), dst, 1, &region);
+		vkEndCommandBuffer(commandBuffer);
+
+		// MɎsAR}hobt@͂ŉ(Xe[WOobt@ƃ̓fXgN^ŉ)
+		uint64_t value;
+		try {
+			value = timeline_->submit({ commandBuffer });
+		}
+		catch (...) {
+			vkFreeCommandBuffers(device_, commandPool_.get(), 1, &commandBuffer);
+			throw;
+		}
+		uploadBytesMetric_.add(size);
+		memoryBudget_->trackAllocation(stagingMemoryType_, requirements.size);
+
+		// ]IЕt(ḾAXe[WOobt@ƃ̏LR[obNɈڂ)
+		VkDevice device = device_;
+		VkCommandPool commandPool = commandPool_.get();
+		VkBuffer stagingBuffer = staging.release();
+		VkDeviceMemory stagingMemory = memory.release();
+		MemoryBudgetMonitor* memoryBudget = memoryBudget_;
+		uint32_t memoryType = stagingMemoryType_;
+		VkDeviceSize allocationSize = requirements.size;
+		timeline_->onComplete(value, [=]() {
+			vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+			vkDestroyBuffer(device, stagingBuffer, nullptr);
+			vkFreeMemory(device, stagingMemory, nullptr);
+			memoryBudget->trackFree(memoryType, allocationSize);
+		});
+
+		return { timeline_, value };
+	}
+
+	template <typename T>
+	TimelinePoint upload(VkBuffer dst, const std::vector<T>& data, VkDeviceSize offset = 0)
+	{
+		return upload(dst, data.data(), sizeof(T) * data.size(), offset);
+	}
+
+	// typeBits ̒ properties SĎŏ̃^Cv
+	static uint32_t findMemoryType(const VkPhysicalDeviceMemoryProperties& memoryProperties, uint32_t typeBits, VkMemoryPropertyFlags properties)
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) return i;
+		}
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+};
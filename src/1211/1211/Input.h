@@ -0,0 +1,126 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+
+#include "SpscQueue.h"
+
+/***  ***/
+// GLFW ̃Cxg̓CXbhłłȂ̂ŁACXbh̓Cxg҂Ď󂯂邾ɂA
+// 󂯂͎͂t SpscQueue ŕ`XbhɓnB`Xbh̓R}hL^钼O
+// sample() ł܂Ƃ߂Ď荞ނ̂ŁAt[̏߂Ɏ荞ނ͂ʂɏo܂łZȂB
+//   input.attach(window);          // CXbh(R[obNݒ肷)
+//   input.sample(state);           // `Xbh
+//   if (state.keyDown(GLFW_KEY_W)) ...
+
+struct InputEvent
+{
+	enum class Type : uint8_t
+	{
+		Key,
+		MouseButton,
+		CursorPosition,
+		Scroll,
+	};
+
+	Type type;
+	int32_t code;	// L[}EX{^
+	int32_t action;	// GLFW_PRESS / GLFW_RELEASE / GLFW_REPEAT
+	int32_t mods;
+	double x;		// J[\̈ʒuXN[
+	double y;
+	std::chrono::steady_clock::time_point time{};// GLFW 󂯎(L[ɓƂ push() t)
+};
+
+// `Xbh猩͂̏
+struct InputState
+{
+	std::bitset<GLFW_KEY_LAST + 1> keys;
+	std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> mouseButtons;
+	double cursorX = 0.0;
+	double cursorY = 0.0;
+
+	// O sample() ̕
+	double scrollX = 0.0;
+	double scrollY = 0.0;
+	uint32_t eventCount = 0;
+	std::chrono::steady_clock::time_point oldestEvent;// eventCount  0 łȂ΁AԌÂCxg̎
+
+	bool keyDown(int key) const { return 0 <= key && key <= GLFW_KEY_LAST && keys[key]; }
+	bool mouseButtonDown(int button) const { return 0 <= button && button <= GLFW_MOUSE_BUTTON_LAST && mouseButtons[button]; }
+
+	void apply(const InputEvent& event)
+	{
+		if (eventCount++ == 0) oldestEvent = event.time;
+		switch (event.type) {
+		case InputEvent::Type::Key:
+			if (0 <= event.code && event.code <= GLFW_KEY_LAST) keys[event.code] = event.action != GLFW_RELEASE;
+			break;
+		case InputEvent::Type::MouseButton:
+			if (0 <= event.code && event.code <= GLFW_MOUSE_BUTTON_LAST) mouseButtons[event.code] = event.action != GLFW_RELEASE;
+			break;
+		case InputEvent::Type::CursorPosition:
+			cursorX = event.x;
+			cursorY = event.y;
+			break;
+		case InputEvent::Type::Scroll:
+			scrollX += event.x;
+			scrollY += event.y;
+			break;
+		}
+	}
+};
+
+class InputQueue
+{
+private:
+	static constexpr size_t CAPACITY = 4096;// `悪~܂ĂbԂ̃}EẌړ͓
+
+	SpscQueue<InputEvent, CAPACITY> events_;
+	std::atomic<uint64_t> dropped_{ 0 };// ςŎ̂Ă
+
+public:
+	// CXbhĂ(EBhẼ[U[|C^g)
+	void attach(GLFWwindow* window)
+	{
+		glfwSetWindowUserPointer(window, this);
+		glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int, int action, int mods) {
+			from(window).push({ InputEvent::Type::Key, key, action, mods, 0.0, 0.0 });
+		});
+		glfwSetMouseButtonCallback(window, [](GLFWwindow* window, int button, int action, int mods) {
+			from(window).push({ InputEvent::Type::MouseButton, button, action, mods, 0.0, 0.0 });
+		});
+		glfwSetCursorPosCallback(window, [](GLFWwindow* window, double x, double y) {
+			from(window).push({ InputEvent::Type::CursorPosition, 0, 0, 0, x, y });
+		});
+		glfwSetScrollCallback(window, [](GLFWwindow* window, double x, double y) {
+			from(window).push({ InputEvent::Type::Scroll, 0, 0, 0, x, y });
+		});
+	}
+
+	// `XbhĂԁB͂ĂCxgS state ɔf(XN[ʂƐ͑O̕Ă琔)
+	void sample(InputState& state)
+	{
+		state.scrollX = 0.0;
+		state.scrollY = 0.0;
+		state.eventCount = 0;
+
+		InputEvent event;
+		while (events_.pop(&event)) state.apply(event);
+	}
+
+	uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	static InputQueue& from(GLFWwindow* window) { return *static_cast<InputQueue*>(glfwGetWindowUserPointer(window)); }
+
+	void push(InputEvent event)
+	{
+		event.time = std::chrono::steady_clock::now();
+		if (!events_.push(event)) dropped_.fetch_add(1, std::memory_order_relaxed);
+	}
+};
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "FrameCapture.h"
+#include "FramePacket.h"
+#include "GpuUploader.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
+#include "VulkanHandle.h"
+#include "DebugLabels.h"
+
+/*** CX^VO ***/
+// FramePacket ̕`̈ꗗ}eAƃbVŕAgݍ킹 1 ̃CX^X`ɂ܂Ƃ߂B
+// CX^XƂ̃f[^(ϊs)͂܂Ƃ߂ɃXe[WOobt@֋l߁At[̃R}hobt@
+// GPU ̃obt@֓]Bobt@̓t[̃XbgƂɍŏɍĂAt[̒ł͊mۂȂB
+// Lv`̃t[ł́Al߂f[^Ƃ̓] FrameCaptureWriter ɂL^B
+//   batcher.build(frameSlot, packet);          // Xbg̑Õt[ GPU ŏIĂ
+//   batcher.recordUpload(commandBuffer);
+//   batcher.recordDraws(commandBuffer, 1, meshes, meshCount, [&](uint32_t material) { ... });
+
+// bṼCfbNXobt@͈̒̔
+struct MeshRange
+{
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+};
+
+// 1 ̃CX^X`
+struct InstanceBatch
+{
+	uint32_t mesh;
+	uint32_t material;
+	uint32_t firstInstance;
+	uint32_t instanceCount;
+};
+
+class InstanceBatcher
+{
+public:
+	using InstanceData = Transform;// _VF[_[ł vec4 ~ 3 ̍sƂēǂ
+	constexpr static uint32_t MAX_ID = 0xffff;// bVƃ}eA̔ԍ̓\[g̃L[ 16 rbgl߂
+
+private:
+	struct Buffer
+	{
+		UniqueBuffer buffer;
+		UniqueDeviceMemory memory;
+		uint32_t memoryType = 0;
+		VkDeviceSize allocationSize = 0;
+	};
+
+	struct Slot
+	{
+		Buffer staging;	// CPU (ƃ}bvĂ)
+		Buffer instances;// _VF[_[ǂ
+		InstanceData* mapped = nullptr;
+	};
+
+	VkDevice device_ = VK_NULL_HANDLE;
+	MemoryBudgetMonitor* memoryBudget_ = nullptr;
+	FrameCaptureWriter* capture_ = nullptr;
+	uint32_t maxInstances_ = 0;
+	std::vector<Slot> slots_;
+	uint32_t currentSlot_ = 0;
+	uint32_t instanceCount_ = 0;
+
+	// build() ̍Ɨp(initialize() ōő̑傫܂ŊmۂĂ)
+	std::vector<uint64_t> sortKeys_;//  32 rbg}eAƃbVA 32 rbg`̔ԍ
+	std::vector<uint64_t> sortTemporary_;
+	std::vector<InstanceBatch> batches_;
+
+	MetricsRegistry::Gauge batchCountMetric_ = MetricsRegistry::instance().gauge(
+		"app_instance_batches", "Instanced draws built from the last frame packet.");
+	MetricsRegistry::Gauge instanceCountMetric_ = MetricsRegistry::instance().gauge(
+		"app_instances", "Instances packed from the last frame packet.");
+
+public:
+	InstanceBatcher() = default;
+	~InstanceBatcher() { finalize(); }
+
+	InstanceBatcher(const InstanceBatcher&) = delete;
+	InstanceBatcher& operator=(const InstanceBatcher&) = delete;
+
+	// frameCount ̓t[̃Xbg̐( GPU Ŏgꂤt[̐)
+	void initialize(VkDevice device, MemoryBudgetMonitor* memoryBudget, FrameCaptureWriter* capture, uint32_t frameCount, uint32_t maxInstances)
+	{
+		device_ = device;
+		memoryBudget_ = memoryBudget;
+		capture_ = capture;
+		maxInstances_ = maxInstances;
+		sortKeys_.resize(maxInstances);
+		sortTemporary_.resize(maxInstances);
+		batches_.reserve(maxInstances);
+
+		VkDeviceSize size = static_cast<VkDeviceSize>(maxInstances) * sizeof(InstanceData);
+		slots_.resize(frameCount);
+		for (Slot& slot : slots_) {
+			slot.staging = createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			slot.instances = createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			void* mapped;
+			if (vkMapMemory(device_, slot.staging.memory.get(), 0, size, 0, &mapped) != VK_SUCCESS) {
+				throw std::runtime_error("failed to map instance staging buffer!");
+			}
+			slot.mapped = static_cast<InstanceData*>(mapped);
+			DEBUG_NAME(device_, slot.staging.buffer.get(), "instance staging");
+			DEBUG_NAME(device_, slot.instances.buffer.get(), "instances");
+		}
+	}
+
+	// Xbg̃obt@gt[AS GPU ŏIĂĂԂ
+	void finalize()
+	{
+		for (Slot& slot : slots_) {
+			for (Buffer* buffer : { &slot.staging, &slot.instances }) {
+				if (buffer->memory) memoryBudget_->trackFree(buffer->memoryType, buffer->allocationSize);
+				if (buffer->buffer) capture_->destroyBuffer(buffer->buffer.get());
+			}
+		}
+		slots_.clear();// }bv͉ƈꏏɊO
+		batches_.clear();
+		instanceCount_ = 0;
+	}
+
+	// packet ̕`܂Ƃ߂āACX^X̃f[^ slot ̃Xe[WOobt@ɋl߂
+	// drawMeshes ΁A`悲Ƃ̃bV DrawItem::mesh ̑ɂg(LOD I񂾌̃bVȂǁBUINT32_MAX ͕`Ȃ)
+	void build(uint32_t slot, const FramePacket& packet, const uint32_t* drawMeshes = nullptr)
+	{
+		currentSlot_ = slot;
+		batches_.clear();
+		uint32_t drawCount = packet.drawCount < maxInstances_ ? packet.drawCount : maxInstances_;// Ȃ͕`Ȃ
+
+		instanceCount_ = 0;
+		for (uint32_t i = 0; i < drawCount; i++) {
+			const DrawItem& draw = packet.draws[i];
+			uint32_t mesh = drawMeshes != nullptr ? drawMeshes[i] : draw.mesh;
+			if (mesh == UINT32_MAX) continue;
+			if (MAX_ID < mesh || MAX_ID < draw.material) {
+				throw std::runtime_error("mesh or material id too large for instance batching!");
+			}
+			sortKeys_[instanceCount_++] = static_cast<uint64_t>(draw.material << 16 | mesh) << 32 | i;
+		}
+		const uint64_t* sorted = sortByBatch(instanceCount_);
+
+		// ׂɃCX^X̃f[^l߁AL[ςƂŕ`𕪂
+		InstanceData* instances = slots_[slot].mapped;
+		for (uint32_t i = 0; i < instanceCount_; i++) {
+			const DrawItem& draw = packet.draws[static_cast<uint32_t>(sorted[i])];
+			uint32_t mesh = static_cast<uint32_t>(sorted[i] >> 32) & MAX_ID;
+			std::memcpy(&instances[i], &packet.transforms[draw.transform], sizeof(InstanceData));
+
+			if (batches_.empty() || batches_.back().mesh != mesh || batches_.back().material != draw.material) {
+				batches_.push_back({ mesh, draw.material, i, 0 });
+			}
+			batches_.back().instanceCount++;
+		}
+
+		batchCountMetric_.set(static_cast<double>(batches_.size()));
+		instanceCountMetric_.set(static_cast<double>(instanceCount_));
+	}
+
+	// build() ŋl߂f[^ GPU ̃obt@֓]A_VF[_[ǂ߂悤ɂ
+	void recordUpload(VkCommandBuffer commandBuffer) const
+	{
+		if (instanceCount_ == 0) return;
+		DEBUG_CMD_LABEL(commandBuffer, "instance upload");
+		const Slot& slot = slots_[currentSlot_];
+
+		VkBufferCopy region = {};
+		region.size = static_cast<VkDeviceSize>(instanceCount_) * sizeof(InstanceData);
+		vkCmdCopyBuffer(commandBuffer, slot.staging.buffer.get(), slot.instances.buffer.get(), 1, &region);
+		if (capture_->isCapturing()) {
+			capture_->uploadBuffer(slot.staging.buffer.get(), 0, slot.mapped, static_cast<size_t>(region.size));
+			capture_->copyBuffer(slot.staging.buffer.get(), slot.instances.buffer.get(), region);
+		}
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = slot.instances.buffer.get();
+		barrier.offset = 0;
+		barrier.size = region.size;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	// ܂Ƃ߂`L^(`pX̒ŁAbV̒_ƃCfbNX̃obt@ѕtĂĂ)
+	// }eAς邽т bindMaterial(material) ĂԁBmeshes ɖbVƁAindexCount  0 ̂(܂ǂݍ܂ĂȂ)͕`Ȃ
+	template <typename BindMaterial>
+	void recordDraws(VkCommandBuffer commandBuffer, uint32_t binding, const MeshRange* meshes, size_t meshCount, BindMaterial&& bindMaterial) const
+	{
+		if (batches_.empty()) return;
+
+		VkBuffer instances = slots_[currentSlot_].instances.buffer.get();
+		VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, binding, 1, &instances, &offset);
+
+		uint32_t boundMaterial = UINT32_MAX;
+		for (const InstanceBatch& batch : batches_) {
+			if (meshCount <= batch.mesh || meshes[batch.mesh].indexCount == 0) continue;
+			if (batch.material != boundMaterial) {
+				bindMaterial(batch.material);
+				boundMaterial = batch.material;
+			}
+			const MeshRange& mesh = meshes[batch.mesh];
+			vkCmdDrawIndexed(commandBuffer, mesh.indexCount, batch.instanceCount, mesh.firstIndex, mesh.vertexOffset, batch.firstInstance);
+		}
+	}
+
+	const std::vector<InstanceBatch>& batches() const { return batches_; }
+	uint32_t instanceCount() const { return instanceCount_; }
+
+	// pCvCƂ̒_(CX^XƂɐi binding ɁAs 3 s firstLocation ׂ)
+	static VkVertexInputBindingDescription bindingDescription(uint32_t binding)
+	{
+		return { binding, static_cast<uint32_t>(sizeof(InstanceData)), VK_VERTEX_INPUT_RATE_INSTANCE };
+	}
+
+	static std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions(uint32_t binding, uint32_t firstLocation)
+	{
+		std::array<VkVertexInputAttributeDescription, 3> attributes;
+		for (uint32_t row = 0; row < 3; row++) {
+			attributes[row] = { firstLocation + row, binding, VK_FORMAT_R32G32B32A32_SFLOAT, row * static_cast<uint32_t>(sizeof(float) * 4) };
+		}
+		return attributes;
+	}
+
+private:
+	// L[̏ 32 rbgňɕבւ(8 rbg̊\[gBSē̃pX͔΂)
+	// ׂʂ sortKeys_  sortTemporary_ ̂ǂ炩ɂ
+	const uint64_t* sortByBatch(uint32_t count)
+	{
+		uint64_t* source = sortKeys_.data();
+		uint64_t* destination = sortTemporary_.data();
+		for (uint32_t shift = 32; shift < 64; shift += 8) {
+			uint32_t offsets[256] = {};
+			for (uint32_t i = 0; i < count; i++) offsets[(source[i] >> shift) & 0xff]++;
+			if (count == 0 || offsets[(source[0] >> shift) & 0xff] == count) continue;
+
+			uint32_t sum = 0;
+			for (uint32_t& offset : offsets) {
+				uint32_t digitCount = offset;
+				offset = sum;
+				sum += digitCount;
+			}
+			for (uint32_t i = 0; i < count; i++) destination[offsets[(source[i] >> shift) & 0xff]++] = source[i];
+			std::swap(source, destination);
+		}
+		return source;
+	}
+
+	Buffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+	{
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkBuffer buffer;
+		if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create instance buffer!");
+		}
+		Buffer result;
+		result.buffer = UniqueBuffer(device_, buffer, vkDestroyBuffer);
+		capture_->createBuffer(buffer, size);
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device_, buffer, &requirements);
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = GpuUploader::findMemoryType(memoryBudget_->memoryProperties(), requirements.memoryTypeBits, properties);
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(device_, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate instance buffer memory!");
+		}
+		result.memory = UniqueDeviceMemory(device_, memory, vkFreeMemory);
+		result.memoryType = allocInfo.memoryTypeIndex;
+		result.allocationSize = requirements.size;
+		memoryBudget_->trackAllocation(result.memoryType, result.allocationSize);
+		vkBindBufferMemory(device_, buffer, memory, 0);
+		return result;
+	}
+};
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/***  JSON ̓ǂݏ ***/
+// ݒXibvVbĝ悤ȁAlǂ߂x̑傫̃t@CB
+// l͏Ă̂܂܎AoƂɌ^ɍ킹ĕϊ(64 rbg̐ۂ߂Ȃ)B
+//   JsonValue root = JsonValue::parse(text);
+//   uint64_t size = root["heaps"][0]["size"].asUint();
+//
+//   JsonWriter writer(out);
+//   writer.beginObject(); writer.key("size"); writer.value(size); writer.endObject();
+
+struct JsonValue
+{
+	enum class Type
+	{
+		Null,
+		Bool,
+		Number,
+		String,
+		Array,
+		Object,
+	};
+
+	Type type = Type::Null;
+	bool boolean = false;
+	std::string text;// Number Ȃ珑Ă܂܁AString Ȃl
+	std::vector<JsonValue> elements;
+	std::vector<std::pair<std::string, JsonValue>> members;// Ă
+
+	//  nullptr
+	const JsonValue* find(const char* key) const
+	{
+		for (const auto& member : members) {
+			if (member.first == key) return &member.second;
+		}
+		return nullptr;
+	}
+
+	const JsonValue& operator[](const char* key) const
+	{
+		const JsonValue* value = find(key);
+		if (value == nullptr) throw std::runtime_error(std::string("missing JSON member: ") + key + "!");
+		return *value;
+	}
+
+	const JsonValue& operator[](size_t index) const
+	{
+		if (type != Type::Array || elements.size() <= index) throw std::runtime_error("JSON array index out of range!");
+		return elements[index];
+	}
+
+	size_t size() const { return type == Type::Array ? elements.size() : members.size(); }
+
+	uint64_t asUint() const { return type == Type::Bool ? boolean : std::stoull(number()); }
+	int64_t asInt() const { return type == Type::Bool ? boolean : std::stoll(number()); }
+	double asDouble() const { return std::stod(number()); }
+	bool asBool() const { return type == Type::Bool ? boolean : asUint() != 0; }
+	const std::string& asString() const
+	{
+		if (type != Type::String) throw std::runtime_error("JSON value is not a string!");
+		return text;
+	}
+
+	static JsonValue parse(const std::string& source)
+	{
+		size_t position = 0;
+		JsonValue value = parseValue(source, position);
+		skipSpace(source, position);
+		if (position != source.size()) throw std::runtime_error("unexpected data after JSON value!");
+		return value;
+	}
+
+private:
+	const std::string& number() const
+	{
+		if (type != Type::Number) throw std::runtime_error("JSON value is not a number!");
+		return text;
+	}
+
+	static void skipSpace(const std::string& source, size_t& position)
+	{
+		while (position < source.size() && (source[position] == ' ' || source[position] == '\t'
+			|| source[position] == '\n' || source[position] == '\r')) position++;
+	}
+
+	static void expect(const std::string& source, size_t& position, char c)
+	{
+		skipSpace(source, position);
+		if (source.size() <= position || source[position] != c) {
+			throw std::runtime_error(std::string("expected '") + c + "' at offset " + std::to_string(position) + " in JSON!");
+		}
+		position++;
+	}
+
+	static bool consume(const std::string& source, size_t& position, const char* word)
+	{
+		size_t length = std::char_traits<char>::length(word);
+		if (source.compare(position, length, word) != 0) return false;
+		position += length;
+		return true;
+	}
+
+	static JsonValue parseValue(const std::string& source, size_t& position)
+	{
+		skipSpace(source, position);
+		if (source.size() <= position) throw std::runtime_error("unexpected end of JSON!");
+
+		JsonValue value;
+		char c = source[position];
+		if (c == '{') {
+			value.type = Type::Object;
+			position++;
+			skipSpace(source, position);
+			if (position < source.size() && source[position] == '}') {
+				position++;
+				return value;
+			}
+			do {
+				skipSpace(source, position);
+				std::string key = parseString(source, position);
+				expect(source, position, ':');
+				value.members.emplace_back(std::move(key), parseValue(source, position));
+				skipSpace(source, position);
+			} while (position < source.size() && source[position] == ',' && ++position);
+			expect(source, position, '}');
+		}
+		else if (c == '[') {
+			value.type = Type::Array;
+			position++;
+			skipSpace(source, position);
+			if (position < source.size() && source[position] == ']') {
+				position++;
+				return value;
+			}
+			do {
+				value.elements.push_back(parseValue(source, position));
+				skipSpace(source, position);
+			} while (position < source.size() && source[position] == ',' && ++position);
+			expect(source, position, ']');
+		}
+		else if (c == '"') {
+			value.type = Type::String;
+			value.text = parseString(source, position);
+		}
+		else if (consume(source, position, "true")) {
+			value.type = Type::Bool;
+			value.boolean = true;
+		}
+		else if (consume(source, position, "false")) {
+			value.type = Type::Bool;
+		}
+		else if (consume(source, position, "null")) {
+			value.type = Type::Null;
+		}
+		else {
+			size_t start = position;
+			while (position < source.size() && (std::string("+-.eE").find(source[position]) != std::string::npos
+				|| ('0' <= source[position] && source[position] <= '9'))) position++;
+			if (start == position) throw std::runtime_error("unexpected character at offset " + std::to_string(position) + " in JSON!");
+			value.type = Type::Number;
+			value.text = source.substr(start, position - start);
+		}
+		return value;
+	}
+
+	// \uXXXX  ASCII ͈̔͂(ȊO '?')
+	static std::string parseString(const std::string& source, size_t& position)
+	{
+		expect(source, position, '"');
+		std::string result;
+		while (position < source.size() && source[position] != '"') {
+			char c = source[position++];
+			if (c != '\\') {
+				result += c;
+				continue;
+			}
+			if (source.size() <= position) break;
+			char escaped = source[position++];
+			switch (escaped) {
+			case 'n': result += '\n'; break;
+			case 'r': result += '\r'; break;
+			case 't': result += '\t'; break;
+			case 'b': result += '\b'; break;
+			case 'f': result += '\f'; break;
+			case 'u': {
+				if (source.size() < position + 4) throw std::runtime_error("bad escape in JSON string!");
+				unsigned long code = std::stoul(source.substr(position, 4), nullptr, 16);
+				position += 4;
+				result += code < 0x80 ? static_cast<char>(code) : '?';
+				break;
+			}
+			default: result += escaped; break;
+			}
+		}
+		expect(source, position, '"');
+		return result;
+	}
+};
+
+// ` JSON ɏo(J}Ǝ͂œ)
+class JsonWriter
+{
+private:
+	std::ostream& out_;
+	std::vector<bool> first_;// qƂɁA܂vfĂȂ
+	bool afterKey_ = false;
+
+public:
+	explicit JsonWriter(std::ostream& out) : out_(out) {}
+
+	void beginObject() { open('{'); }
+	void endObject() { close('}'); }
+	void beginArray() { open('['); }
+	void endArray() { close(']'); }
+
+	void key(const char* name)
+	{
+		separate();
+		out_ << '"' << escape(name) << "\": ";
+		afterKey_ = true;
+	}
+
+	void value(const std::string& text)
+	{
+		separate();
+		out_ << '"' << escape(text) << '"';
+	}
+	void value(const char* text) { value(std::string(text)); }
+	void value(bool boolean)
+	{
+		separate();
+		out_ << (boolean ? "true" : "false");
+	}
+
+	// ƕ_(_͓ǂݖ߂ēlɂȂ錅ŏ)
+	template <typename T>
+	void value(T number)
+	{
+		static_assert(std::is_arithmetic<T>::value, "JSON numbers must be arithmetic");
+		separate();
+		if constexpr (std::is_floating_point<T>::value) {
+			std::streamsize precision = out_.precision(9);
+			out_ << number;
+			out_.precision(precision);
+		}
+		else {
+			out_ << +number;// char ^lƂď
+		}
+	}
+
+	template <typename T>
+	void field(const char* name, const T& fieldValue)
+	{
+		key(name);
+		value(fieldValue);
+	}
+
+	static std::string escape(const std::string& text)
+	{
+		std::string result;
+		for (char c : text) {
+			switch (c) {
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) result += ' ';
+				else result += c;
+			}
+		}
+		return result;
+	}
+
+private:
+	void open(char bracket)
+	{
+		separate();
+		out_ << bracket;
+		first_.push_back(true);
+	}
+
+	void close(char bracket)
+	{
+		bool empty = first_.back();
+		first_.pop_back();
+		if (!empty) newline();
+		out_ << bracket;
+		if (first_.empty()) out_ << '\n';
+	}
+
+	// l̑OɁAKvȂJ}Ɖs(L[͉̒Ȃ)
+	void separate()
+	{
+		if (afterKey_) {
+			afterKey_ = false;
+			return;
+		}
+		if (first_.empty()) return;
+		if (!first_.back()) out_ << ',';
+		first_.back() = false;
+		newline();
+	}
+
+	void newline()
+	{
+		out_ << '\n';
+		for (size_t i = 0; i < first_.size(); i++) out_ << "  ";
+	}
+};
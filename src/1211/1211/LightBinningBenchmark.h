@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "ClusteredLighting.h"
+#include "FramePacket.h"
+
+/*** Cg̐U蕪̃x`}[N ***/
+// Cg̐ςȂANX^[ւ̐U蕪 GPU(LightClusterer) CPU ̎QƎ(LightClusterGrid::bin)ŎsA
+// ԂׂāAʂv邩m߂BԂ iterations ̂ł́B
+// GPU ̎Ԃ ComputeBenchmark ƓAL^EME҂܂ CPU 猩ԁB
+// GPU ̌vZ͊ۂߕ CPU ƈႤ̂ŁANX^[̋EɂĂ邾̃CǵAǂ̌ʂł悢ƂɂB
+// LightClusterer (GPU Ƃ)QƎ𑪂B
+
+class LightBinningBenchmark
+{
+private:
+	constexpr static float BORDER_TOLERANCE = 1.0e-3f;// EƂ݂Ȃa̍()
+
+	struct Result
+	{
+		uint32_t lightCount = 0;
+		double referenceSeconds = 0.0;
+		double gpuSeconds = 0.0;
+		double averageLights = 0.0;// 1 NX^[(Cg 1 ȏ゠NX^[̕)
+		uint32_t maxLights = 0;
+		uint32_t overflowClusters = 0;// MAX_LIGHTS_PER_CLUSTER 𒴂Ĉꗗɓ肫ȂNX^[
+		bool matched = false;
+	};
+
+	std::vector<uint32_t> lightCounts_;
+	uint32_t iterations_;
+	std::vector<Result> results_;
+
+public:
+	LightBinningBenchmark(std::vector<uint32_t> lightCounts, uint32_t iterations)
+		: lightCounts_(std::move(lightCounts)), iterations_(std::max(iterations, 1u)) {}
+
+	// SẴCg̐Ŏsĕ\(GPU ̌ʂSĎQƎƈv true)
+	bool run(LightClusterer* clusterer, std::ostream& out)
+	{
+		// Simulation ƓJŁÂ̊iq̏ɃCgU΂点(񓯂f[^ɂ)
+		Camera camera = { { 0.0f, 2.0f, -10.0f }, 0.0f, 0.2f, 1.0f, 800.0f / 600.0f, 0.1f, 1000.0f };
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		for (uint32_t lightCount : lightCounts_) {
+			if (clusterer != nullptr) lightCount = std::min(lightCount, clusterer->maxLights());
+			std::vector<PointLight> lights(lightCount);
+			for (PointLight& light : lights) {
+				light.position = { (unit(random) - 0.5f) * 256.0f, unit(random) * 4.0f, unit(random) * 256.0f };
+				light.radius = 1.0f + unit(random) * 4.0f;
+				light.color = { unit(random), unit(random), unit(random) };
+				light.intensity = 1.0f;
+			}
+
+			// QƎ̓r[Ԃւ̕ϊ܂߂đ(GPU  bin() ̒ CPU ϊĂ)
+			ClusterParameters parameters = LightClusterGrid::parameters(camera, lightCount);
+			std::vector<ClusterLight> viewLights(lightCount);
+			std::vector<uint32_t> counts(LightClusterGrid::CLUSTER_COUNT);
+			std::vector<uint32_t> indices(LightClusterGrid::CLUSTER_COUNT * LightClusterGrid::MAX_LIGHTS_PER_CLUSTER);
+			Result result;
+			result.lightCount = lightCount;
+			result.referenceSeconds = measure([&]() {
+				LightClusterGrid::ViewTransform view(camera);
+				for (uint32_t i = 0; i < lightCount; i++) viewLights[i] = view.apply(lights[i]);
+				LightClusterGrid::bin(viewLights.data(), parameters, counts.data(), indices.data());
+			});
+
+			uint32_t usedClusters = 0;
+			uint64_t totalLights = 0;
+			for (uint32_t count : counts) {
+				if (count == 0) continue;
+				usedClusters++;
+				totalLights += count;
+				result.maxLights = std::max(result.maxLights, count);
+				if (LightClusterGrid::MAX_LIGHTS_PER_CLUSTER < count) result.overflowClusters++;
+			}
+			result.averageLights = 0 < usedClusters ? static_cast<double>(totalLights) / usedClusters : 0.0;
+
+			if (clusterer != nullptr) {
+				result.gpuSeconds = measure([&]() {
+					TimelinePoint point = clusterer->bin(0, camera, lights.data(), lightCount);
+					point.timeline->wait(point.value);
+				});
+				std::vector<uint32_t> gpuCounts;
+				std::vector<uint32_t> gpuIndices;
+				clusterer->readBack(0, gpuCounts, gpuIndices);
+				result.matched = matches(viewLights, parameters, gpuCounts, gpuIndices);
+			}
+			results_.push_back(result);
+		}
+
+		printReport(clusterer != nullptr, out);
+		return clusterer == nullptr
+			|| std::all_of(results_.begin(), results_.end(), [](const Result& result) { return result.matched; });
+	}
+
+private:
+	template <typename Function>
+	double measure(Function function) const
+	{
+		double best = std::numeric_limits<double>::max();
+		for (uint32_t i = 0; i < iterations_; i++) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	// GPU ̌ʂAaU蕪Ə傫U蕪̊ԂɓĂ邩
+	static bool matches(const std::vector<ClusterLight>& lights, const ClusterParameters& parameters,
+		const std::vector<uint32_t>& gpuCounts, const std::vector<uint32_t>& gpuIndices)
+	{
+		constexpr uint32_t MAX = LightClusterGrid::MAX_LIGHTS_PER_CLUSTER;
+		std::vector<uint32_t> innerCounts(LightClusterGrid::CLUSTER_COUNT);
+		std::vector<uint32_t> innerIndices(LightClusterGrid::CLUSTER_COUNT * MAX);
+		std::vector<uint32_t> outerCounts(LightClusterGrid::CLUSTER_COUNT);
+		std::vector<uint32_t> outerIndices(LightClusterGrid::CLUSTER_COUNT * MAX);
+		LightClusterGrid::bin(lights.data(), parameters, innerCounts.data(), innerIndices.data(), 1.0f - BORDER_TOLERANCE);
+		LightClusterGrid::bin(lights.data(), parameters, outerCounts.data(), outerIndices.data(), 1.0f + BORDER_TOLERANCE);
+
+		float boundsMin[3];
+		float boundsMax[3];
+		for (uint32_t cluster = 0; cluster < LightClusterGrid::CLUSTER_COUNT; cluster++) {
+			uint32_t count = gpuCounts[cluster];
+			if (count < innerCounts[cluster] || outerCounts[cluster] < count) return false;
+
+			// ꗗ̃Cg͏ɕсAS(傫)NX^[ɏdȂ
+			const uint32_t* listed = &gpuIndices[cluster * MAX];
+			uint32_t listedCount = std::min(count, MAX);
+			LightClusterGrid::bounds(cluster, parameters, boundsMin, boundsMax);
+			for (uint32_t i = 0; i < listedCount; i++) {
+				if (parameters.lightCount <= listed[i] || (0 < i && listed[i] <= listed[i - 1])) return false;
+				if (!LightClusterGrid::intersects(lights[listed[i]], boundsMin, boundsMax, 1.0f + BORDER_TOLERANCE)) return false;
+			}
+
+			// mɏdȂ郉Cg͈ꗗɓĂ(肫ȂƂ́Aꗗ̍Ō̃CgÔ̂)
+			const uint32_t* inner = &innerIndices[cluster * MAX];
+			uint32_t innerCount = std::min(innerCounts[cluster], MAX);
+			uint32_t j = 0;
+			for (uint32_t i = 0; i < innerCount; i++) {
+				if (MAX < count && 0 < listedCount && listed[listedCount - 1] < inner[i]) break;
+				while (j < listedCount && listed[j] < inner[i]) j++;
+				if (j == listedCount || listed[j] != inner[i]) return false;
+			}
+		}
+		return true;
+	}
+
+	void printReport(bool hasGpu, std::ostream& out) const
+	{
+		out << "light binning: " << LightClusterGrid::TILES_X << "x" << LightClusterGrid::TILES_Y << "x" << LightClusterGrid::SLICES
+			<< " clusters, up to " << LightClusterGrid::MAX_LIGHTS_PER_CLUSTER << " lights per cluster"
+			<< (hasGpu ? "" : " (no GPU, reference only)") << std::endl;
+
+		out << std::fixed << std::setprecision(3);
+		out << std::right << std::setw(8) << "lights" << std::setw(14) << "reference(ms)" << std::setw(14) << "gpu(ms)"
+			<< std::setw(12) << "avg/cluster" << std::setw(8) << "max" << std::setw(10) << "overflow" << "  result" << std::endl;
+		for (const Result& result : results_) {
+			out << std::setw(8) << result.lightCount << std::setw(14) << result.referenceSeconds * 1000.0;
+			if (hasGpu) out << std::setw(14) << result.gpuSeconds * 1000.0;
+			else out << std::setw(14) << "-";
+			out << std::setw(12) << std::setprecision(1) << result.averageLights << std::setprecision(3)
+				<< std::setw(8) << result.maxLights << std::setw(10) << result.overflowClusters
+				<< "  " << (!hasGpu ? "-" : result.matched ? "ok" : "MISMATCH") << std::endl;
+		}
+	}
+};
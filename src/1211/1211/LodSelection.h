@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOD_SELECTION_SSE2
+#endif
+
+#include "FramePacket.h"
+#include "WorkerPool.h"
+
+/*** LOD ̑I ***/
+// `悲ƂɁAʏ̌덷(LOD ̊􉽌덷ʂɓesNZ) maxErrorPixels ȉɂȂ
+// ԑe LOD IԁB``Nɕ WorkerPool ̃XbhŕǍvZ SSE2  4 `悸s
+// (SSE2 Ƃ͕ʂ̃[v)B
+//   const uint8_t* lods = selector.select(packet, chains, chainCount, viewportHeight, 1.0f);
+//   // lods[i]  packet.draws[i]  LOD(0 ԍׂ)
+
+// 1 ̃bV LOD ̕
+struct LodChain
+{
+	constexpr static uint32_t MAX_LODS = 8;
+
+	uint32_t firstLod;		// MeshStreamer  LOD ̒ʂԍ́ÃbV LOD 0
+	uint32_t lodCount;
+	float boundingRadius;	// bV̌_̔a(ϊs̊g̑O)
+	float errors[MAX_LODS];	// LOD Ƃ̊􉽌덷(ׂ珇ɑ傫Ȃ)
+};
+
+class LodSelector
+{
+private:
+	// 1 `N̍ŏ̕`搔(ƃXbhɔzԂ̕傫Ȃ)
+	static constexpr uint32_t MIN_CHUNK_SIZE = 4096;
+
+	WorkerPool pool_;
+	std::vector<uint8_t> lods_;// `悲Ƃ LOD
+
+	// select() ̊Ԃg(^XN͍ŏ 1 xAt[Ƃ std::function Ȃ)
+	const FramePacket* packet_ = nullptr;
+	const LodChain* chains_ = nullptr;
+	size_t chainCount_ = 0;
+	float errorPerDistance_ = 0.0f;//  1 ŋ􉽌덷
+	uint32_t chunkSize_ = MIN_CHUNK_SIZE;
+	std::function<void(size_t)> task_ = [this](size_t chunk) { selectChunk(chunk); };
+
+public:
+	// threadCount ͌ĂяoXbh܂߂(0 Ȃn[hEFÃXbh)
+	// ɂɓĂXbhȂA̕n
+	explicit LodSelector(size_t threadCount) : pool_(threadCount), lods_(FramePacket::MAX_DRAWS) {}
+
+	LodSelector(const LodSelector&) = delete;
+	LodSelector& operator=(const LodSelector&) = delete;
+
+	// chains ɖbV LOD 0 ɂB߂l͎ select() ܂Ŏg
+	const uint8_t* select(const FramePacket& packet, const LodChain* chains, size_t chainCount, float viewportHeight, float maxErrorPixels)
+	{
+		//  d ɂ􉽌덷 e ́Aʏ e * viewportHeight / (2 * tan(fovY / 2) * d) sNZɂȂ
+		float projectionScale = viewportHeight / (2.0f * std::tan(packet.camera.fovY * 0.5f));
+		packet_ = &packet;
+		chains_ = chains;
+		chainCount_ = chainCount;
+		errorPerDistance_ = maxErrorPixels / projectionScale;
+
+		size_t threads = pool_.threadCount();
+		uint32_t chunkSize = static_cast<uint32_t>((packet.drawCount + threads - 1) / threads);
+		chunkSize_ = std::max(MIN_CHUNK_SIZE, (chunkSize + 3) & ~3u);// SSE2 ̃[v[oȂ悤 4 ̔{
+		pool_.run((packet.drawCount + chunkSize_ - 1) / chunkSize_, task_);
+		return lods_.data();
+	}
+
+	size_t threadCount() const { return pool_.threadCount(); }
+
+private:
+	void selectChunk(size_t chunk)
+	{
+		uint32_t begin = static_cast<uint32_t>(chunk) * chunkSize_;
+		uint32_t end = std::min(begin + chunkSize_, packet_->drawCount);
+		const Float3& eye = packet_->camera.position;
+		float nearZ = packet_->camera.nearZ;
+
+		uint32_t i = begin;
+#ifdef LOD_SELECTION_SSE2
+		// 4 `悸A􉽌덷( ~ errorPerDistance_  g嗦)߂
+		__m128 eyeX = _mm_set1_ps(eye.x);
+		__m128 eyeY = _mm_set1_ps(eye.y);
+		__m128 eyeZ = _mm_set1_ps(eye.z);
+		__m128 minDistance = _mm_set1_ps(nearZ);
+		__m128 errorPerDistance = _mm_set1_ps(errorPerDistance_);
+		for (; i + 4 <= end; i += 4) {
+			const Transform* t[4];
+			float radius[4];
+			for (uint32_t j = 0; j < 4; j++) {
+				const DrawItem& draw = packet_->draws[i + j];
+				t[j] = &packet_->transforms[draw.transform];
+				radius[j] = draw.mesh < chainCount_ ? chains_[draw.mesh].boundingRadius : 0.0f;
+			}
+			__m128 dx = _mm_sub_ps(_mm_setr_ps(t[0]->rows[0][3], t[1]->rows[0][3], t[2]->rows[0][3], t[3]->rows[0][3]), eyeX);
+			__m128 dy = _mm_sub_ps(_mm_setr_ps(t[0]->rows[1][3], t[1]->rows[1][3], t[2]->rows[1][3], t[3]->rows[1][3]), eyeY);
+			__m128 dz = _mm_sub_ps(_mm_setr_ps(t[0]->rows[2][3], t[1]->rows[2][3], t[2]->rows[2][3], t[3]->rows[2][3]), eyeZ);
+			__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+			// g嗦 1 ڂ̒(g͏cœƂ݂Ȃ)
+			__m128 cx = _mm_setr_ps(t[0]->rows[0][0], t[1]->rows[0][0], t[2]->rows[0][0], t[3]->rows[0][0]);
+			__m128 cy = _mm_setr_ps(t[0]->rows[1][0], t[1]->rows[1][0], t[2]->rows[1][0], t[3]->rows[1][0]);
+			__m128 cz = _mm_setr_ps(t[0]->rows[2][0], t[1]->rows[2][0], t[2]->rows[2][0], t[3]->rows[2][0]);
+			__m128 scale = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz)));
+
+			// ̂̕\ʂ܂ł̋(JɓĂ߃Nbvʂ̋)
+			__m128 surface = _mm_max_ps(_mm_sub_ps(distance, _mm_mul_ps(_mm_loadu_ps(radius), scale)), minDistance);
+			float allowed[4];
+			_mm_storeu_ps(allowed, _mm_div_ps(_mm_mul_ps(surface, errorPerDistance), scale));
+			for (uint32_t j = 0; j < 4; j++) lods_[i + j] = pickLod(packet_->draws[i + j].mesh, allowed[j]);
+		}
+#endif // LOD_SELECTION_SSE2
+		for (; i < end; i++) {
+			const DrawItem& draw = packet_->draws[i];
+			const Transform& t = packet_->transforms[draw.transform];
+			float dx = t.rows[0][3] - eye.x;
+			float dy = t.rows[1][3] - eye.y;
+			float dz = t.rows[2][3] - eye.z;
+			float scale = std::sqrt(t.rows[0][0] * t.rows[0][0] + t.rows[1][0] * t.rows[1][0] + t.rows[2][0] * t.rows[2][0]);
+			float radius = draw.mesh < chainCount_ ? chains_[draw.mesh].boundingRadius : 0.0f;
+			float surface = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - radius * scale, nearZ);
+			lods_[i] = pickLod(draw.mesh, surface * errorPerDistance_ / scale);
+		}
+	}
+
+	// 􉽌덷 allowed ȉ̈ԑe LOD
+	uint8_t pickLod(uint32_t mesh, float allowed) const
+	{
+		if (chainCount_ <= mesh) return 0;
+		const LodChain& chain = chains_[mesh];
+		uint32_t lod = 0;
+		while (lod + 1 < chain.lodCount && chain.errors[lod + 1] <= allowed) lod++;
+		return static_cast<uint8_t>(lod);
+	}
+};
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+/*** foCX̎gpʂ̊Ď ***/
+// VK_EXT_memory_budget gƂ̓hCo񍐂\Z(budget)Ǝgp(usage)A
+// gȂƂ̓q[vTCYƃAvŐmۗʂgB
+
+// q[v 1 Ԃ̏
+struct MemoryHeapBudget
+{
+	VkDeviceSize size = 0;		// q[vŜ̑傫
+	VkDeviceSize budget = 0;	// ̃vZXgĂ悢ʂ̖ڈ
+	VkDeviceSize usage = 0;		// ̃vZXgĂ
+	bool deviceLocal = false;
+
+	float usageRatio() const { return budget == 0 ? 0.0f : static_cast<float>(usage) / static_cast<float>(budget); }
+};
+
+class MemoryBudgetMonitor
+{
+private:
+	VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
+	PFN_vkGetPhysicalDeviceMemoryProperties2 getMemoryProperties2_ = nullptr;
+	bool budgetExtensionEnabled_ = false;
+
+	VkPhysicalDeviceMemoryProperties memoryProperties_ = {};
+	std::vector<MemoryHeapBudget> heaps_;
+	std::vector<VkDeviceSize> trackedUsage_;// gƂ̂߂́AAvŐmۗ
+	std::vector<VkDeviceSize> unpolledUsage_;// O poll() ̌Ɋmۂ(fitsInBudget() ő)
+
+public:
+	// budgetExtensionEnabled ́A_foCX VK_EXT_memory_budget Lɂǂ
+	void initialize(VkInstance instance, VkPhysicalDevice physicalDevice, bool budgetExtensionEnabled)
+	{
+		physicalDevice_ = physicalDevice;
+		budgetExtensionEnabled_ = budgetExtensionEnabled;
+		getMemoryProperties2_ = (PFN_vkGetPhysicalDeviceMemoryProperties2)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2");
+
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memoryProperties_);
+		heaps_.assign(memoryProperties_.memoryHeapCount, MemoryHeapBudget());
+		trackedUsage_.assign(memoryProperties_.memoryHeapCount, 0);
+		unpolledUsage_.assign(memoryProperties_.memoryHeapCount, 0);
+
+		poll();
+	}
+
+	// t[ĂяočŐV̒lɍXV
+	void poll()
+	{
+		if (usesBudgetExtension()) poll<true>();
+		else poll<false>();
+	}
+
+	// UseBudgetExtension  usesBudgetExtension() ƈvĂ邱(t[̏ŕ򂵂Ȃ߂̂)
+	template <bool UseBudgetExtension>
+	void poll()
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+		if constexpr (UseBudgetExtension) {
+			budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+			VkPhysicalDeviceMemoryProperties2 properties2 = {};
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			properties2.pNext = &budgetProperties;
+			getMemoryProperties2_(physicalDevice_, &properties2);
+			memoryProperties_ = properties2.memoryProperties;
+		}
+
+		for (uint32_t i = 0; i < memoryProperties_.memoryHeapCount; i++) {
+			MemoryHeapBudget& heap = heaps_[i];
+			heap.size = memoryProperties_.memoryHeaps[i].size;
+			heap.deviceLocal = (memoryProperties_.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+			if constexpr (UseBudgetExtension) {
+				heap.budget = budgetProperties.heapBudget[i];
+				heap.usage = budgetProperties.heapUsage[i];
+			}
+			else {
+				// ̃vZX̕킩Ȃ̂ŁAq[v 8 \ZƂ݂Ȃ
+				heap.budget = heap.size / 10 * 8;
+				heap.usage = trackedUsage_[i];
+			}
+			unpolledUsage_[i] = 0;
+		}
+	}
+
+	// vkAllocateMemory / vkFreeMemory ̂тɌĂ(gƂ̎gpʂ̌ςɎg)
+	void trackAllocation(uint32_t memoryTypeIndex, VkDeviceSize size)
+	{
+		uint32_t heapIndex = memoryProperties_.memoryTypes[memoryTypeIndex].heapIndex;
+		trackedUsage_[heapIndex] += size;
+		unpolledUsage_[heapIndex] += size;
+	}
+
+	void trackFree(uint32_t memoryTypeIndex, VkDeviceSize size)
+	{
+		uint32_t heapIndex = memoryProperties_.memoryTypes[memoryTypeIndex].heapIndex;
+		for (VkDeviceSize* usage : { &trackedUsage_[heapIndex], &unpolledUsage_[heapIndex] }) *usage -= std::min(*usage, size);
+	}
+
+	// mۂĂ\ZɎ܂邩(mۂɎsOɔf邽߂̂)
+	// ̓rȂ poll() ̊ԂɑĊmۂƂ̂߂ɁAO poll() ̌ɊmۂĔf
+	bool fitsInBudget(uint32_t memoryTypeIndex, VkDeviceSize size) const
+	{
+		uint32_t heapIndex = memoryProperties_.memoryTypes[memoryTypeIndex].heapIndex;
+		const MemoryHeapBudget& heap = heaps_[heapIndex];
+		return heap.usage + unpolledUsage_[heapIndex] + size <= heap.budget;
+	}
+
+	// foCX[Jȃq[v̒ňԗ]T̂Ȃ̂̎gp
+	float deviceLocalUsageRatio() const
+	{
+		float ratio = 0.0f;
+		for (const MemoryHeapBudget& heap : heaps_) {
+			if (heap.deviceLocal) ratio = std::max(ratio, heap.usageRatio());
+		}
+		return ratio;
+	}
+
+	bool budgetExtensionEnabled() const { return budgetExtensionEnabled_; }
+	// g̒lۂɓǂ߂邩(LɂĂĂA֐ȂΎgȂ)
+	bool usesBudgetExtension() const { return budgetExtensionEnabled_ && getMemoryProperties2_ != nullptr; }
+	const std::vector<MemoryHeapBudget>& heaps() const { return heaps_; }
+	const VkPhysicalDeviceMemoryProperties& memoryProperties() const { return memoryProperties_; }
+};
+
+/*** s邽߂̕j ***/
+// gpɉĒiK߁AmۂɎsOɃXg[~Op̃LbV̂ĂA]ʂi肷B
+
+enum class MemoryPressure
+{
+	Normal,		// ]T
+	Elevated,	// \Zɋ߂ÂĂ
+	Critical,	// ̂܂܂ƊmۂɎs
+};
+
+// eiKłƂ΍
+struct MemoryPolicyActions
+{
+	bool evictStreamingCaches = false;			// Xg[~OpLbV邩
+	VkDeviceSize uploadBytesPerFrame = 0;		// 1 t[ɓ]Ă悢
+};
+
+class MemoryBudgetPolicy
+{
+public:
+	using Listener = std::function<void(MemoryPressure, const MemoryPolicyActions&)>;
+
+private:
+	// iK̐؂ւgp(߂Ƃ HYSTERESIS ܂ő҂āAs藈h)
+	static constexpr float ELEVATED_RATIO = 0.80f;
+	static constexpr float CRITICAL_RATIO = 0.92f;
+	static constexpr float HYSTERESIS = 0.05f;
+
+	MemoryPressure pressure_ = MemoryPressure::Normal;
+	MemoryPolicyActions actions_ = actionsFor(MemoryPressure::Normal);
+	std::vector<Listener> listeners_;
+
+public:
+	// iKςƂɌĂ΂鏈o^(Xg[~OA]Ȃ)
+	void addListener(Listener listener) { listeners_.push_back(std::move(listener)); }
+
+	// t[AĎʂnĒiKXV
+	void evaluate(const MemoryBudgetMonitor& monitor)
+	{
+		float ratio = monitor.deviceLocalUsageRatio();
+
+		MemoryPressure next = pressure_;
+		switch (pressure_) {
+		case MemoryPressure::Normal:
+			if (CRITICAL_RATIO <= ratio) next = MemoryPressure::Critical;
+			else if (ELEVATED_RATIO <= ratio) next = MemoryPressure::Elevated;
+			break;
+		case MemoryPressure::Elevated:
+			if (CRITICAL_RATIO <= ratio) next = MemoryPressure::Critical;
+			else if (ratio < ELEVATED_RATIO - HYSTERESIS) next = MemoryPressure::Normal;
+			break;
+		case MemoryPressure::Critical:
+			if (ratio < ELEVATED_RATIO - HYSTERESIS) next = MemoryPressure::Normal;
+			else if (ratio < CRITICAL_RATIO - HYSTERESIS) next = MemoryPressure::Elevated;
+			break;
+		}
+
+		if (next == pressure_) return;
+
+		pressure_ = next;
+		actions_ = actionsFor(next);
+		for (const Listener& listener : listeners_) {
+			listener(pressure_, actions_);
+		}
+	}
+
+	MemoryPressure pressure() const { return pressure_; }
+	const MemoryPolicyActions& actions() const { return actions_; }
+
+	static MemoryPolicyActions actionsFor(MemoryPressure pressure)
+	{
+		const VkDeviceSize MB = 1024 * 1024;
+
+		MemoryPolicyActions actions;
+		switch (pressure) {
+		case MemoryPressure::Normal:
+			actions.uploadBytesPerFrame = 64 * MB;
+			break;
+		case MemoryPressure::Elevated:
+			actions.uploadBytesPerFrame = 16 * MB;
+			break;
+		case MemoryPressure::Critical:
+			actions.evictStreamingCaches = true;
+			actions.uploadBytesPerFrame = 4 * MB;
+			break;
+		}
+		return actions;
+	}
+
+	static const char* toString(MemoryPressure pressure)
+	{
+		switch (pressure) {
+		case MemoryPressure::Normal: return "normal";
+		case MemoryPressure::Elevated: return "elevated";
+		case MemoryPressure::Critical: return "critical";
+		}
+		return "unknown";
+	}
+};
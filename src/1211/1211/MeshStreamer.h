@@ -0,0 +1,435 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "DebugLabels.h"
+#include "FrameCapture.h"
+#include "FramePacket.h"
+#include "GpuTask.h"
+#include "GpuTimeline.h"
+#include "GpuUploader.h"
+#include "InstanceBatcher.h"
+#include "LodSelection.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
+#include "VulkanHandle.h"
+
+/*** bṼXg[~O ***/
+// bV LOD Ƃɓo^ĂA`Ŏgꂽ LOD ǂݍŃfoCXɒuB
+// _ƃCfbNX 1 ̃obt@(傫풓Ă悢ʂ̏)ɒuAȂȂ
+// ΂炭gĂȂ LOD ǂoBǂݍݒ LOD ́AuĂ钆ňԋ߂ LOD őɕ`B
+// ǂݍ݂͕ʂ̃XbhōsAǂݏI LOD ̓] GpuTask œ]̊ co_await Ďg悤ɂB
+//   uint32_t mesh = streamer.addMesh(lods, lodCount, radius, [](uint32_t lod, void* vertices, uint32_t* indices) { ... });
+//   const uint32_t* meshes = streamer.resolve(packet, selector.select(packet, streamer.chains(), ...));
+//   batcher.build(frameSlot, packet, meshes);
+//   streamer.update(memoryPolicy.actions());
+
+// o^ LOD 1 Ԃ
+struct MeshLodInfo
+{
+	float geometricError;// ̃bVƂ̍ő̂(bV̍Wn)
+	uint32_t vertexCount;
+	uint32_t indexCount;
+};
+
+// lod ̒_(vertexCount ~ _̑傫)ƃCfbNX(indexCount )ށBǂݍݗp̃XbhĂ΂
+using MeshLoader = std::function<void(uint32_t lod, void* vertices, uint32_t* indices)>;
+
+class MeshStreamer
+{
+private:
+	constexpr static uint32_t MAX_LOADS_IN_FLIGHT = 4;
+	constexpr static VkDeviceSize MIN_CAPACITY_DIVISOR = 8;// \Zɍ킹Č炷ƂAw肳ꂽʂ 1/8 ͊mۂ
+
+	enum class State : uint8_t
+	{
+		Unloaded,
+		Loading,	// ǂݍݗp̃Xbhœǂł
+		Uploading,	// GPU ֓]Ă(uploadLod() ̃^XN҂Ă)
+		Resident,
+	};
+
+	struct Lod
+	{
+		uint32_t mesh;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		VkDeviceSize size;			// _̑傫̔{ɐ؂グ
+		State state = State::Unloaded;
+		VkDeviceSize offset = 0;	// Unloaded ȊÔƂAobt@̒̈ʒu
+		uint64_t lastUsedFrame = 0;	// Ōɕ`Ɏg(g)t[
+		std::future<std::vector<unsigned char>> loading;
+	};
+
+	struct Range
+	{
+		VkDeviceSize offset;
+		VkDeviceSize size;
+	};
+
+	// o^(foCX蒼Ăc)
+	std::vector<LodChain> chains_;
+	std::vector<MeshLoader> loaders_;
+	std::vector<Lod> lods_;
+	std::vector<MeshRange> ranges_;// LOD ̒ʂԍƂ̕`͈(uĂȂ LOD  indexCount  0)
+	uint32_t vertexStride_;
+
+	VkDevice device_ = VK_NULL_HANDLE;
+	QueueTimeline* timeline_ = nullptr;
+	GpuUploader* uploader_ = nullptr;
+	GpuTaskRunner* tasks_ = nullptr;
+	DeletionQueue* deletionQueue_ = nullptr;// timeline ̒lŊǗĂ
+	MemoryBudgetMonitor* memoryBudget_ = nullptr;
+	FrameCaptureWriter* capture_ = nullptr;
+	UniqueBuffer buffer_;
+	UniqueDeviceMemory memory_;
+	uint32_t memoryType_ = 0;
+	VkDeviceSize allocationSize_ = 0;
+	VkDeviceSize capacity_ = 0;
+	VkDeviceSize budget_ = 0;		// 풓Ă悢(ȂƂ capacity_ 菬)
+	VkDeviceSize residentBytes_ = 0;// ǂݍݒƓ]̕܂
+
+	std::vector<Range> freeRanges_;// ʒȕ
+	std::vector<uint32_t> inFlight_;// Loading  Uploading  LOD
+	std::vector<uint32_t> requested_;// ̃t[ŎguĂȂ LOD
+	std::vector<uint32_t> resolved_;// `悲Ƃ LOD ̒ʂԍ
+	uint64_t frame_ = 1;
+
+	MetricsRegistry::Gauge residentBytesMetric_ = MetricsRegistry::instance().gauge(
+		"mesh_resident_bytes", "Mesh LOD bytes resident or being streamed into device memory.");
+	MetricsRegistry::Gauge budgetMetric_ = MetricsRegistry::instance().gauge(
+		"mesh_residency_budget_bytes", "Device memory mesh LODs may occupy.");
+	MetricsRegistry::Counter streamedBytesMetric_ = MetricsRegistry::instance().counter(
+		"mesh_streamed_bytes_total", "Mesh LOD bytes uploaded to device memory.");
+	MetricsRegistry::Counter evictionMetric_ = MetricsRegistry::instance().counter(
+		"mesh_lod_evictions_total", "Mesh LODs evicted to stay within the residency budget.");
+	MetricsRegistry::Gauge fallbackMetric_ = MetricsRegistry::instance().gauge(
+		"mesh_lod_fallback_draws", "Draws in the last frame that used a different LOD than selected because it was not resident.");
+
+public:
+	// vertexStride ͒_ 1 ̑傫(4 ̔{)Be LOD ͒_̌ɃCfbNX𑱂Ēu
+	explicit MeshStreamer(uint32_t vertexStride) : vertexStride_(vertexStride)
+	{
+		if (vertexStride == 0 || vertexStride % 4 != 0) throw std::runtime_error("mesh vertex stride must be a multiple of 4!");
+		resolved_.resize(FramePacket::MAX_DRAWS);
+	}
+	~MeshStreamer() { finalize(); }
+
+	MeshStreamer(const MeshStreamer&) = delete;
+	MeshStreamer& operator=(const MeshStreamer&) = delete;
+
+	// capacity ͏풓Ă悢ʂ̏ŁAꂾ̃foCXŏɊmۂ(\ZɎ܂Ȃ΁A܂܂Ō炷)
+	// ]҂^XN tasks ɗaAtimeline  runCallbacks() ̒ōĊJ
+	// ǂoꏊ deletionQueue ɗaAGPU ŎgIĂ󂫂ɖ߂
+	// LOD ̓] capture ɂL^
+	void initialize(VkDevice device, QueueTimeline* timeline, GpuUploader* uploader, GpuTaskRunner* tasks, DeletionQueue* deletionQueue,
+		MemoryBudgetMonitor* memoryBudget, FrameCaptureWriter* capture, VkDeviceSize capacity)
+	{
+		device_ = device;
+		timeline_ = timeline;
+		uploader_ = uploader;
+		tasks_ = tasks;
+		deletionQueue_ = deletionQueue;
+		memoryBudget_ = memoryBudget;
+		capture_ = capture;
+		capacity_ = capacity - capacity % vertexStride_;
+		VkDeviceSize minimumCapacity = capacity_ / MIN_CAPACITY_DIVISOR;
+
+		// u LOD 邾ŁA`͑e LOD ő̂ŁA\Z𒴂Ċmۂ茸炷I
+		VkBuffer buffer;
+		VkMemoryAllocateInfo allocInfo = {};
+		for (;;) {
+			VkBufferCreateInfo bufferInfo = {};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = capacity_;
+			bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create mesh buffer!");
+			}
+			buffer_ = UniqueBuffer(device_, buffer, vkDestroyBuffer);
+
+			VkMemoryRequirements requirements;
+			vkGetBufferMemoryRequirements(device_, buffer, &requirements);
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = requirements.size;
+			allocInfo.memoryTypeIndex = GpuUploader::findMemoryType(memoryBudget_->memoryProperties(), requirements.memoryTypeBits,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			if (memoryBudget_->fitsInBudget(allocInfo.memoryTypeIndex, allocInfo.allocationSize)) break;
+
+			VkDeviceSize half = capacity_ / 2 - capacity_ / 2 % vertexStride_;
+			if (half < minimumCapacity || half == 0) throw std::runtime_error("mesh buffer does not fit in the memory budget!");
+			capacity_ = half;
+		}
+		budget_ = capacity_;
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(device_, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate mesh buffer memory!");
+		}
+		memory_ = UniqueDeviceMemory(device_, memory, vkFreeMemory);
+		memoryType_ = allocInfo.memoryTypeIndex;
+		allocationSize_ = allocInfo.allocationSize;
+		memoryBudget_->trackAllocation(memoryType_, allocationSize_);
+		vkBindBufferMemory(device_, buffer, memory, 0);
+		DEBUG_NAME(device_, buffer, "streamed meshes");
+		capture_->createBuffer(buffer, capacity_);
+
+		freeRanges_.assign(1, { 0, capacity_ });
+		inFlight_.reserve(MAX_LOADS_IN_FLIGHT);
+		budgetMetric_.set(static_cast<double>(budget_));
+	}
+
+	// GPU ̏SďIA]҂^XNSčĊJAdeletionQueue  flush() ĂĂԂ
+	// o^bV͎cAuĂ LOD ͑SĎ̂Ă
+	void finalize()
+	{
+		for (Lod& lod : lods_) {
+			if (lod.loading.valid()) lod.loading.wait();
+			lod.loading = {};
+			lod.state = State::Unloaded;
+		}
+		for (MeshRange& range : ranges_) range.indexCount = 0;
+		inFlight_.clear();
+		requested_.clear();
+		freeRanges_.clear();
+		residentBytes_ = 0;
+
+		if (memory_) memoryBudget_->trackFree(memoryType_, allocationSize_);
+		if (buffer_) capture_->destroyBuffer(buffer_.get());
+		memory_.reset();
+		buffer_.reset();
+	}
+
+	// bVo^āAbV̔ԍ(DrawItem::mesh)ԂBlods ׂ͍珇ɕׂ
+	uint32_t addMesh(const MeshLodInfo* lods, uint32_t lodCount, float boundingRadius, MeshLoader loader)
+	{
+		if (lodCount == 0 || LodChain::MAX_LODS < lodCount) throw std::runtime_error("unsupported mesh LOD count!");
+
+		uint32_t mesh = static_cast<uint32_t>(chains_.size());
+		LodChain chain = {};
+		chain.firstLod = static_cast<uint32_t>(lods_.size());
+		chain.lodCount = lodCount;
+		chain.boundingRadius = boundingRadius;
+		for (uint32_t i = 0; i < lodCount; i++) {
+			chain.errors[i] = lods[i].geometricError;
+			VkDeviceSize bytes = static_cast<VkDeviceSize>(lods[i].vertexCount) * vertexStride_ + static_cast<VkDeviceSize>(lods[i].indexCount) * sizeof(uint32_t);
+			Lod& lod = lods_.emplace_back();
+			lod.mesh = mesh;
+			lod.vertexCount = lods[i].vertexCount;
+			lod.indexCount = lods[i].indexCount;
+			lod.size = (bytes + vertexStride_ - 1) / vertexStride_ * vertexStride_;
+			ranges_.push_back({ 0, 0, 0 });
+		}
+		chains_.push_back(chain);
+		loaders_.push_back(std::move(loader));
+		requested_.reserve(lods_.size());// t[̒ő₳Ȃ
+		return mesh;
+	}
+
+	const LodChain* chains() const { return chains_.data(); }
+	size_t chainCount() const { return chains_.size(); }
+
+	// `悲ƂɁAI LOD(uĂȂΈԋ߂uĂ LOD)̒ʂԍԂ
+	// uĂȂbV UINT32_MAX(`Ȃ)BuĂȂ LOD  update() œǂݍ
+	const uint32_t* resolve(const FramePacket& packet, const uint8_t* selectedLods)
+	{
+		requested_.clear();
+		uint32_t fallbacks = 0;
+		for (uint32_t i = 0; i < packet.drawCount; i++) {
+			uint32_t mesh = packet.draws[i].mesh;
+			if (chains_.size() <= mesh) {
+				resolved_[i] = UINT32_MAX;
+				continue;
+			}
+			const LodChain& chain = chains_[mesh];
+			uint32_t wanted = chain.firstLod + std::min<uint32_t>(selectedLods[i], chain.lodCount - 1);
+			Lod& lod = lods_[wanted];
+			if (lod.lastUsedFrame != frame_) {
+				lod.lastUsedFrame = frame_;
+				if (lod.state == State::Unloaded) requested_.push_back(wanted);
+			}
+			if (lod.state == State::Resident) {
+				resolved_[i] = wanted;
+				continue;
+			}
+			resolved_[i] = nearestResident(chain, wanted);
+			if (resolved_[i] != UINT32_MAX) lods_[resolved_[i]].lastUsedFrame = frame_;// ɎgĂԂ͒ǂoȂ
+			fallbacks++;
+		}
+		fallbackMetric_.set(static_cast<double>(fallbacks));
+		return resolved_.data();
+	}
+
+	// ǂݍ݂Ɠ]i߁Au LOD ߂(t[ƂɁAresolve() ̌ŌĂ)
+	void update(const MemoryPolicyActions& actions)
+	{
+		// ȂƂ́AgĂȂ LOD ɒǂoAuĂ悢ʂɂ
+		budget_ = actions.evictStreamingCaches ? capacity_ / 2 : capacity_;
+		budgetMetric_.set(static_cast<double>(budget_));
+		while (budget_ < residentBytes_ && evictLeastRecentlyUsed()) {}
+
+		advanceInFlight(actions.uploadBytesPerFrame);
+
+		// (e)LOD ǂށBɕ`̂
+		std::sort(requested_.begin(), requested_.end(), [this](uint32_t a, uint32_t b) { return lods_[a].size < lods_[b].size; });
+		for (uint32_t index : requested_) {
+			if (MAX_LOADS_IN_FLIGHT <= inFlight_.size()) break;
+			if (!startLoad(index)) break;// ǂoĂȂ΁Ãt[ł܂
+		}
+
+		residentBytesMetric_.set(static_cast<double>(residentBytes_));
+		frame_++;
+	}
+
+	VkBuffer buffer() const { return buffer_.get(); }// _obt@ƃCfbNXobt@(VK_INDEX_TYPE_UINT32)̗Ɍѕt
+	const MeshRange* ranges() const { return ranges_.data(); }
+	size_t rangeCount() const { return ranges_.size(); }
+	VkDeviceSize residentBytes() const { return residentBytes_; }
+	VkDeviceSize budget() const { return budget_; }
+
+private:
+	// uĂ钆 wanted Ɉԋ߂ LOD(߂Ȃe)
+	uint32_t nearestResident(const LodChain& chain, uint32_t wanted) const
+	{
+		uint32_t last = chain.firstLod + chain.lodCount - 1;
+		for (uint32_t step = 1; step < chain.lodCount; step++) {
+			if (wanted + step <= last && lods_[wanted + step].state == State::Resident) return wanted + step;
+			if (chain.firstLod + step <= wanted && lods_[wanted - step].state == State::Resident) return wanted - step;
+		}
+		return UINT32_MAX;
+	}
+
+	// V LOD ǂݍނƂmۂ(ǂݍ݂̃XbhƓ]̃^XN)̂ŁAt[̊mۂɂ͐Ȃ
+	bool startLoad(uint32_t index)
+	{
+		AllocationCounter::Exempt exempt;
+		Lod& lod = lods_[index];
+		// uĂ悢ʂ𒴂镪ǂo(ǂoꏊ GPU ŎgI܂ŋ󂫂ɖ߂Ȃ̂ŁA󂫂ȂƂ͑҂)
+		while (budget_ < residentBytes_ + lod.size) {
+			if (!evictLeastRecentlyUsed()) return false;
+		}
+		Range range;
+		if (!allocate(lod.size, &range)) return false;
+		lod.offset = range.offset;
+		lod.state = State::Loading;
+		residentBytes_ += lod.size;
+
+		// ǂݍ(t@C̓ǂݍ݂WJz)͕ʂ̃Xbhōs
+		MeshLoader loader = loaders_[lod.mesh];// ǂłԂ addMesh() ŕтĂ悢悤Ɏʂn
+		uint32_t level = index - chains_[lod.mesh].firstLod;
+		VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(lod.vertexCount) * vertexStride_;
+		size_t size = static_cast<size_t>(lod.size);
+		lod.loading = std::async(std::launch::async, [loader, level, vertexBytes, size]() {
+			std::vector<unsigned char> data(size);
+			loader(level, data.data(), reinterpret_cast<uint32_t*>(data.data() + vertexBytes));
+			return data;
+		});
+		inFlight_.push_back(index);
+		return true;
+	}
+
+	// ǂݏÎ̓]n߁A]IĎg悤ɂȂ̂ inFlight_ O
+	void advanceInFlight(VkDeviceSize uploadBytesPerFrame)
+	{
+		VkDeviceSize uploaded = 0;
+		for (size_t i = 0; i < inFlight_.size();) {
+			uint32_t index = inFlight_[i];
+			Lod& lod = lods_[index];
+			if (lod.state == State::Loading && lod.loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready
+				&& (uploaded == 0 || uploaded + lod.size <= uploadBytesPerFrame)// 1 t[ɓ]ʂ}(1 ͕Ki߂)
+				&& uploader_->stagingFits(lod.size)) {// Xe[WOobt@\ZɎ܂Ȃ΁AO̓]Î҂
+				lod.state = State::Uploading;
+				uploaded += lod.size;
+				streamedBytesMetric_.add(lod.size);
+				AllocationCounter::Exempt exempt;// startLoad() Ŏn߂ǂݍ݂̑
+				tasks_->spawn(uploadLod(index, lod.loading.get()));
+			}
+			if (lods_[index].state == State::Resident) {
+				inFlight_[i] = inFlight_.back();
+				inFlight_.pop_back();
+				continue;
+			}
+			i++;
+		}
+	}
+
+	// ǂݏI LOD ]A]I`Ɏg悤ɂ
+	GpuTask<> uploadLod(uint32_t index, std::vector<unsigned char> data)
+	{
+		TimelinePoint uploaded = uploader_->upload(buffer_.get(), data.data(), lods_[index].size, lods_[index].offset);
+		capture_->uploadBuffer(buffer_.get(), lods_[index].offset, data.data(), static_cast<size_t>(lods_[index].size));
+		data = {};// Xe[WOobt@Ɏʂ̂ŁA]҂Ԃ͎Ȃ
+		co_await uploaded;
+
+		// ҂ĂԂ addMesh()  lods_ Ă邩Ȃ̂ŁAĊJĂ蒼
+		Lod& lod = lods_[index];
+		VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(lod.vertexCount) * vertexStride_;
+		ranges_[index] = { lod.indexCount, static_cast<uint32_t>((lod.offset + vertexBytes) / sizeof(uint32_t)),
+			static_cast<int32_t>(lod.offset / vertexStride_) };
+		lod.state = State::Resident;
+	}
+
+	// ̃t[ŎgĂȂŁAԒgĂȂ LOD ǂo( false)
+	bool evictLeastRecentlyUsed()
+	{
+		uint32_t victim = UINT32_MAX;
+		for (uint32_t i = 0; i < lods_.size(); i++) {
+			const Lod& lod = lods_[i];
+			if (lod.state != State::Resident || lod.lastUsedFrame == frame_) continue;
+			if (victim == UINT32_MAX || lod.lastUsedFrame < lods_[victim].lastUsedFrame) victim = i;
+		}
+		if (victim == UINT32_MAX) return false;
+
+		// Õt[ GPU ł܂gĂ邩Ȃ̂ŁAɑ鏈܂ŏIĂ󂫂ɖ߂
+		Lod& lod = lods_[victim];
+		Range range = { lod.offset, lod.size };
+		deletionQueue_->defer(timeline_->submittedValue() + 1, [this, range]() { release(range); });
+		ranges_[victim].indexCount = 0;
+		lod.state = State::Unloaded;
+		residentBytes_ -= lod.size;
+		evictionMetric_.add();
+		return true;
+	}
+
+	// ŏɓ󂫂
+	bool allocate(VkDeviceSize size, Range* range)
+	{
+		for (size_t i = 0; i < freeRanges_.size(); i++) {
+			Range& free = freeRanges_[i];
+			if (free.size < size) continue;
+			*range = { free.offset, size };
+			free.offset += size;
+			free.size -= size;
+			if (free.size == 0) freeRanges_.erase(freeRanges_.begin() + i);
+			return true;
+		}
+		return false;// ǂo܂ GPU ŎgĂ邩A󂫂א؂ɂȂĂ
+	}
+
+	// 󂫂ɖ߂Aׂ̋󂫂ƂȂ
+	void release(const Range& range)
+	{
+		auto next = std::lower_bound(freeRanges_.begin(), freeRanges_.end(), range.offset,
+			[](const Range& free, VkDeviceSize offset) { return free.offset < offset; });
+		next = freeRanges_.insert(next, range);
+		if (next + 1 != freeRanges_.end() && next->offset + next->size == (next + 1)->offset) {
+			next->size += (next + 1)->size;
+			freeRanges_.erase(next + 1);
+		}
+		if (next != freeRanges_.begin() && (next - 1)->offset + (next - 1)->size == next->offset) {
+			(next - 1)->size += next->size;
+			freeRanges_.erase(next);
+		}
+	}
+};
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/*** vl(gNX)̓o^Əo ***/
+// JE^[EQ[WEqXgOo^APrometheus ̃eLXg`ŏoB
+// l̉Z̓XbhƂ̗̈(V[h)ɑ΂čŝŁAzbgpXł̓bN
+//  atomic ߂ȂBoƂɑSV[hvB
+
+class MetricsRegistry
+{
+public:
+	static constexpr size_t MAX_SLOTS = 1024;// SgNXŎgZ̈̐
+
+	enum class Type { Counter, Gauge, Histogram };
+
+private:
+	// Xbh 1 Ԃ̉Z̈(ނ͎̂̃Xbh)
+	struct Shard
+	{
+		std::atomic<uint64_t> slots[MAX_SLOTS] = {};
+	};
+
+	struct Metric
+	{
+		Type type;
+		std::string name;
+		std::string labels;		// : heap="0"
+		std::string help;
+		size_t slot;			// V[h̐擪ʒu(Q[W͖gp)
+		std::vector<double> bounds;// qXgÕoPbg
+		std::atomic<uint64_t> gaugeBits{ 0 };// Q[W̒l(double ̃rbg)
+	};
+
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<Shard>> shards_;// IXbh̕cĂ
+	std::vector<std::unique_ptr<Metric>> metrics_;
+	size_t nextSlot_ = 0;
+
+	MetricsRegistry() = default;
+
+	static uint64_t toBits(double value) { uint64_t bits; std::memcpy(&bits, &value, sizeof(bits)); return bits; }
+	static double fromBits(uint64_t bits) { double value; std::memcpy(&value, &bits, sizeof(value)); return value; }
+
+	// ĂяoXbh̃V[h(񂾂o^̂߂ɃbN)
+	Shard& localShard()
+	{
+		thread_local Shard* shard = nullptr;
+		if (shard == nullptr) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			shards_.push_back(std::make_unique<Shard>());
+			shard = shards_.back().get();
+		}
+		return *shard;
+	}
+
+	// ̃XbhȂ̂ŁAǂݏo݂ő(fetch_add ͕sv)
+	void addToSlot(size_t slot, uint64_t value)
+	{
+		std::atomic<uint64_t>& target = localShard().slots[slot];
+		target.store(target.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	void addToSlot(size_t slot, double value)
+	{
+		std::atomic<uint64_t>& target = localShard().slots[slot];
+		target.store(toBits(fromBits(target.load(std::memory_order_relaxed)) + value), std::memory_order_relaxed);
+	}
+
+	uint64_t sumSlot(size_t slot) const
+	{
+		uint64_t sum = 0;
+		for (const auto& shard : shards_) sum += shard->slots[slot].load(std::memory_order_relaxed);
+		return sum;
+	}
+
+	double sumSlotAsDouble(size_t slot) const
+	{
+		double sum = 0.0;
+		for (const auto& shard : shards_) sum += fromBits(shard->slots[slot].load(std::memory_order_relaxed));
+		return sum;
+	}
+
+	Metric* registerMetric(Type type, const std::string& name, const std::string& labels, const std::string& help,
+		std::vector<double> bounds = {})
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		// OEx̂̂͋L
+		for (const auto& metric : metrics_) {
+			if (metric->name == name && metric->labels == labels) return metric.get();
+		}
+
+		size_t slotCount = 0;
+		if (type == Type::Counter) slotCount = 1;
+		if (type == Type::Histogram) slotCount = bounds.size() + 3;// eoPbg + Ȃ + v + 
+		if (MAX_SLOTS < nextSlot_ + slotCount) throw std::runtime_error("too many metrics registered!");
+
+		auto metric = std::make_unique<Metric>();
+		metric->type = type;
+		metric->name = name;
+		metric->labels = labels;
+		metric->help = help;
+		metric->slot = nextSlot_;
+		metric->bounds = std::move(bounds);
+		nextSlot_ += slotCount;
+
+		metrics_.push_back(std::move(metric));
+		return metrics_.back().get();
+	}
+
+public:
+	static MetricsRegistry& instance()
+	{
+		static MetricsRegistry registry;
+		return registry;
+	}
+
+	// l(o񐔁Amۉ񐔁A]ʂȂ)
+	class Counter
+	{
+		friend class MetricsRegistry;
+		Metric* metric_ = nullptr;
+	public:
+		void add(uint64_t value = 1) const { instance().addToSlot(metric_->slot, value); }
+	};
+
+	// ㉺l(gpʂȂ)BŌɐݒ肵lo
+	class Gauge
+	{
+		friend class MetricsRegistry;
+		Metric* metric_ = nullptr;
+	public:
+		void set(double value) const { metric_->gaugeBits.store(toBits(value), std::memory_order_relaxed); }
+	};
+
+	// l̕z(t[ԂȂ)
+	class Histogram
+	{
+		friend class MetricsRegistry;
+		Metric* metric_ = nullptr;
+	public:
+		void observe(double value) const
+		{
+			const std::vector<double>& bounds = metric_->bounds;
+			size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+
+			MetricsRegistry& registry = instance();
+			registry.addToSlot(metric_->slot + bucket, uint64_t(1));
+			registry.addToSlot(metric_->slot + bounds.size() + 1, value);
+			registry.addToSlot(metric_->slot + bounds.size() + 2, uint64_t(1));
+		}
+	};
+
+	Counter counter(const std::string& name, const std::string& help, const std::string& labels = "")
+	{
+		Counter counter;
+		counter.metric_ = registerMetric(Type::Counter, name, labels, help);
+		return counter;
+	}
+
+	Gauge gauge(const std::string& name, const std::string& help, const std::string& labels = "")
+	{
+		Gauge gauge;
+		gauge.metric_ = registerMetric(Type::Gauge, name, labels, help);
+		return gauge;
+	}
+
+	// bounds ͏̃oPbg
+	Histogram histogram(const std::string& name, const std::string& help, std::vector<double> bounds, const std::string& labels = "")
+	{
+		Histogram histogram;
+		histogram.metric_ = registerMetric(Type::Histogram, name, labels, help, std::move(bounds));
+		return histogram;
+	}
+
+	// Prometheus ̃eLXg`ŏo
+	std::string exportText()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		std::ostringstream out;
+		std::vector<const Metric*> sorted;
+		for (const auto& metric : metrics_) sorted.push_back(metric.get());
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Metric* a, const Metric* b) { return a->name < b->name; });
+
+		const std::string* previousName = nullptr;
+		for (const Metric* metric : sorted) {
+			// HELP  TYPE ͓Oɂ 1 񂾂
+			if (previousName == nullptr || *previousName != metric->name) {
+				static const char* TYPE_NAMES[] = { "counter", "gauge", "histogram" };
+				out << "# HELP " << metric->name << " " << metric->help << "\n";
+				out << "# TYPE " << metric->name << " " << TYPE_NAMES[static_cast<int>(metric->type)] << "\n";
+				previousName = &metric->name;
+			}
+
+			std::string labels = metric->labels.empty() ? "" : "{" + metric->labels + "}";
+			switch (metric->type) {
+			case Type::Counter:
+				out << metric->name << labels << " " << sumSlot(metric->slot) << "\n";
+				break;
+			case Type::Gauge:
+				out << metric->name << labels << " " << fromBits(metric->gaugeBits.load(std::memory_order_relaxed)) << "\n";
+				break;
+			case Type::Histogram: {
+				std::string prefix = metric->labels.empty() ? "" : metric->labels + ",";
+				uint64_t cumulative = 0;
+				for (size_t i = 0; i <= metric->bounds.size(); i++) {
+					cumulative += sumSlot(metric->slot + i);
+					std::ostringstream le;
+					if (i < metric->bounds.size()) le << metric->bounds[i]; else le << "+Inf";
+					out << metric->name << "_bucket{" << prefix << "le=\"" << le.str() << "\"} " << cumulative << "\n";
+				}
+				out << metric->name << "_sum" << labels << " " << sumSlotAsDouble(metric->slot + metric->bounds.size() + 1) << "\n";
+				out << metric->name << "_count" << labels << " " << sumSlot(metric->slot + metric->bounds.size() + 2) << "\n";
+				break;
+			}
+			}
+		}
+		return out.str();
+	}
+};
+
+/*** gNX̏o ***/
+class MetricsExporter
+{
+private:
+	std::thread socketThread_;
+	std::atomic<bool> running_{ false };
+#ifndef _WIN32
+	int socket_ = -1;
+	std::string socketPath_;
+#endif
+
+public:
+	~MetricsExporter() { stopSocket(); }
+
+	// t@C֏o(ǂ܂Ȃ悤Aꎞt@CɏĂu)
+	static bool writeFile(const std::string& path)
+	{
+		std::string temporary = path + ".tmp";
+		{
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+			if (!file) return false;
+			file << MetricsRegistry::instance().exportText();
+		}
+#ifdef _WIN32
+		// Windows  rename() ͊ɂt@CuȂ
+		return MoveFileExW(std::filesystem::path(temporary).c_str(), std::filesystem::path(path).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		return std::rename(temporary.c_str(), path.c_str()) == 0;// u̓Ag~bNȂ̂ŁAǂޑ͌ÂV̂ǂ炩
+#endif
+	}
+
+	// Unix \Pbgő҂󂯁Aڑ邽тɌ݂̒lԂ(Windows ł͖Ή)
+	bool serveSocket(const std::string& path)
+	{
+#ifdef _WIN32
+		(void)path;
+		return false;
+#else
+		sockaddr_un address = {};
+		if (sizeof(address.sun_path) <= path.size()) return false;
+		address.sun_family = AF_UNIX;
+		std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+		socket_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (socket_ < 0) return false;
+
+		::unlink(path.c_str());
+		if (::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(socket_, 4) != 0) {
+			::close(socket_);
+			socket_ = -1;
+			return false;
+		}
+
+		socketPath_ = path;
+		running_ = true;
+		// socket_  stopSocket() ̂ŁAlʂĎg
+		socketThread_ = std::thread([this, listener = socket_] {
+			while (running_) {
+				int client = ::accept(listener, nullptr, nullptr);
+				if (client < 0) {
+					if (errno == EINTR) continue;
+					break;// stopSocket()  shutdown() ꂽƂɗ
+				}
+				std::string text = MetricsRegistry::instance().exportText();
+				const char* data = text.data();
+				size_t remaining = text.size();
+				while (0 < remaining) {
+					ssize_t written = ::write(client, data, remaining);
+					if (written <= 0) break;
+					data += written;
+					remaining -= static_cast<size_t>(written);
+				}
+				::close(client);
+			}
+		});
+		return true;
+#endif
+	}
+
+	void stopSocket()
+	{
+		if (!running_) return;
+		running_ = false;
+#ifndef _WIN32
+		::shutdown(socket_, SHUT_RDWR);// accept() 𔲂
+#endif
+		if (socketThread_.joinable()) socketThread_.join();
+#ifndef _WIN32
+		// XbhĂ(ɕƁAԍŊJꂽʂ̃t@C accept() Ă܂)
+		::close(socket_);
+		socket_ = -1;
+		::unlink(socketPath_.c_str());
+#endif
+	}
+};
@@ -3,7 +3,50 @@
 #include <GLFW/glfw3.h>
 
 #include <vector>
+#include <algorithm>
 #include <optional>
+#include <cstring>
+#include <stdexcept>
+#include <fstream>
+#include <iterator>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <string>
+
+#include "MemoryBudget.h"
+#include "Metrics.h"
+#include "FrameCapture.h"
+#include "ValidationMessageLimiter.h"
+#include "PerformanceLint.h"
+#include "DebugLabels.h"
+#include "VulkanHandle.h"
+#include "GpuTimeline.h"
+#include "GpuTask.h"
+#include "GpuUploader.h"
+#include "ShaderLibrary.h"
+#include "PipelineLayoutCache.h"
+#include "GpuCompute.h"
+#include "CpuCompute.h"
+#include "ComputeBenchmark.h"
+#include "DeviceRecovery.h"
+#include "ScratchAllocator.h"
+#include "AllocationCounter.h"
+#include "DeviceCapabilities.h"
+#include "ExtensionNegotiator.h"
+#include "DeviceSnapshot.h"
+#include "Input.h"
+#include "FramePacket.h"
+#include "Simulation.h"
+#include "InstanceBatcher.h"
+#include "LodSelection.h"
+#include "MeshStreamer.h"
+#include "ProceduralMesh.h"
+#include "ClusteredLighting.h"
+#include "LightBinningBenchmark.h"
 
 // Debug tO
 #ifdef NDEBUG
@@ -16,25 +59,365 @@ const bool enableValidationLayers = false;
 const bool enableValidationLayers = true;
 #endif
 
+// Vulkan ̃hCo[g GPU (EBhEȂ̏ CPU őɎsł)
+class NoDeviceError : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
 class MyApplication
 {
 private:
+	// fobObZW[̃R[obN pUserData Ƃēn
+	struct DebugMessageHandlers
+	{
+		ValidationMessageLimiter limiter;// bZ[WʂɏoƂ̊Ԉ
+		PerformanceLintCollector performanceLint;// ptH[}Xx̎W
+	};
+
 	constexpr static char APP_NAME[] = "Vulkan Application";
 
+	// Vulkan ̃IuWFNg̓o[̐錾Ƌt̏ɔĵŁA쐬鏇ɕׂ
+	constexpr static int WINDOW_WIDTH = 800;
+	constexpr static int WINDOW_HEIGHT = 600;
 	GLFWwindow* window_;
-	VkInstance instance_;
+	InputQueue input_;// CXbhŎ󂯂͂V~[ṼXbhɓn
+	InputState inputState_;// V~[ṼXbhŌɎ荞񂾓
+	std::atomic<bool> quit_{ false };// EBhEꂽAV~[V`̃XbhI
+
+	// V~[Vƕ`ʂ̃XbhŕsĐi߂(V~[V͕`ő FRAME_PACKET_DEPTH - 1 t[ɐi)
+	constexpr static size_t FRAME_PACKET_DEPTH = 2;
+	Simulation simulation_;// V~[ṼXbhG
+	FramePacketRing<FRAME_PACKET_DEPTH> framePackets_;
+	bool headless_ = false;// EBhEȂ(x`}[NȂ)
+	DebugMessageHandlers debugMessageHandlers_;// debugMessenger_ ɔjĂ͂Ȃ
+	UniqueInstance instance_;
 	VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
-	VkDebugUtilsMessengerEXT debugMessenger_;// fobObZ[W`IuWFNg
+	DeviceCapabilities capabilities_;// I񂾃foCX̔\(t[̏͂ɍ킹Ď̉̂g)
+	UniqueDebugMessenger debugMessenger_;// fobObZ[W`IuWFNg
+
+	constexpr static char PERFORMANCE_LINT_FILE[] = "performance_lint.json";
+	std::string performanceBaseline_;// łȂ΁Ãx[XCɖptH[}Xxo玸sɂ
+	constexpr static char CPU_TRACE_FILE[] = "cpu_trace.json";
+
+	UniqueDevice device_;// _foCX
+	VkQueue graphicsQueue_ = VK_NULL_HANDLE;
+	VkQueue computeQueue_ = VK_NULL_HANDLE;// 񓯊Rs[g̃L[(̃L[t@~[΍Ȃ)
+	UniquePipelineCache pipelineCache_;// pCvC쐬ʂ̕ۑ(N܂ōėp)
+
+	// OtBbNXL[ɑ̐i݋(҂Ej͂̒lŔf)
+	QueueTimeline graphicsTimeline_;
+	QueueTimeline computeTimeline_;// computeQueue_ ɑ( computeTimeline()  graphicsTimeline_ Ԃ)
+	constexpr static uint64_t MAX_FRAMES_IN_FLIGHT = 2;// CPU  GPU ɐił悢t[
+	uint64_t frameTimelineValues_[MAX_FRAMES_IN_FLIGHT] = {};// et[̏I\^CC̒l
+	uint64_t countedSubmits_ = 0;// vlɐM̐
+	uint64_t countedComputeSubmits_ = 0;// ̂ computeTimeline_ ̂
+
+	// t[Ƃ̃R}hobt@(Xbg̑Õt[IĂL^)
+	UniqueCommandPool frameCommandPool_;
+	VkCommandBuffer frameCommandBuffers_[MAX_FRAMES_IN_FLIGHT] = {};
+	std::vector<VkCommandBuffer> frameSubmit_ = std::vector<VkCommandBuffer>(1);// MƂɊmۂȂ悤Ɏg
+	std::vector<TimelinePoint> frameWaits_ = std::vector<TimelinePoint>(1);// t[҂(Cg̐U蕪)
+	InstanceBatcher instanceBatcher_;// t[pPbg̕`bVƃ}eAƂ̃CX^X`ɂ܂Ƃ߂
+
+	// bV LOD(ʏ̌덷 LOD_ERROR_PIXELS ȉɂȂԑêIсAg LOD u)
+	constexpr static float LOD_ERROR_PIXELS = 1.0f;
+	constexpr static VkDeviceSize MESH_RESIDENCY_BYTES = 64 * 1024 * 1024;// bVɎgĂ悢foCX
+	LodSelector lodSelector_{ lodSelectionThreads() };
+	MeshStreamer meshStreamer_{ sizeof(MeshVertex) };
+
+	// t[pPbg̃CgARs[g̃L[Ŏ̃NX^[ɐU蕪
+	LightClusterer lightClusterer_;
+
+	GpuUploader uploader_;// obt@ւ̃f[^̓]
+	ShaderLibrary shaders_{ "shaders", "shaders/bin" };// RpCς݂̃VF[_[(rhOCxgŃRpC)
+	PipelineLayoutCache pipelineLayouts_;// VF[_[̃tNVpCvCCAEg(pCvC̊ԂŋL)
+#ifdef _DEBUG
+	std::future<bool> shaderCompile_;// zbg[hŗœĂVF[_[̃RpC(shaders_ ĝŁǍɐ錾)
+#endif // _DEBUG
+	GpuTaskRunner tasks_;// bV̓]ȂǁAGPU ̊ co_await ő҂
+	GpuCompute compute_;// vZv~eBu(XLE\[gȂ)
+
+	// GPU gĂ邩ȂIuWFNǵAɔjɂ֗a(graphicsTimeline_ ̒lŊǗ)
+	// â meshStreamer_  compute_ ĜŁAɐ錾(ɔj)
+	DeletionQueue deletionQueue_;
+
+	MemoryBudgetMonitor memoryBudget_;// foCX̎gp
+	MemoryBudgetPolicy memoryPolicy_;// s邽߂̑΍
+	DeviceRecovery deviceRecovery_;// foCXꂽƂɘ_foCX牺蒼
+	uint64_t frameIndex_ = 0;
+
+	// N̑(LIXNȂǂŕpɂɍċNƂɁAfȂԂZ)
+	std::chrono::steady_clock::time_point startTime_ = std::chrono::steady_clock::now();// AvNƂ݂Ȃ
+	bool fastStart_ = false;// EBhEƃfoCXsėpӂApCvC͗ō
+
+	// vl̏o
+	constexpr static char METRICS_FILE[] = "metrics.prom";
+	constexpr static char METRICS_SOCKET_FILE[] = "metrics.sock";
+	MetricsExporter metricsExporter_;
+	MetricsRegistry::Histogram frameTimeMetric_ = MetricsRegistry::instance().histogram(
+		"app_frame_time_seconds", "CPU time between frames.",
+		{ 0.004, 0.008, 0.0167, 0.0333, 0.05, 0.1, 0.25 });
+	MetricsRegistry::Counter frameCountMetric_ = MetricsRegistry::instance().counter(
+		"app_frames_total", "Number of frames processed.");
+	MetricsRegistry::Gauge memoryPressureMetric_ = MetricsRegistry::instance().gauge(
+		"gpu_memory_pressure_level", "Memory pressure level (0: normal, 1: elevated, 2: critical).");
+	std::vector<MetricsRegistry::Gauge> heapUsageMetrics_;
+	std::vector<MetricsRegistry::Gauge> heapBudgetMetrics_;
+	MetricsRegistry::Counter queueSubmitMetric_ = MetricsRegistry::instance().counter(
+		"vk_queue_submits_total", "Number of vkQueueSubmit calls.", "queue=\"graphics\"");
+	MetricsRegistry::Counter computeSubmitMetric_ = MetricsRegistry::instance().counter(
+		"vk_queue_submits_total", "Number of vkQueueSubmit calls.", "queue=\"compute\"");
+	MetricsRegistry::Gauge pendingDeletionMetric_ = MetricsRegistry::instance().gauge(
+		"vk_pending_deletions", "Objects waiting in the deferred deletion queue.");
+	MetricsRegistry::Gauge firstFrameMetric_ = MetricsRegistry::instance().gauge(
+		"app_time_to_first_frame_seconds", "Time from startup until the GPU finished the first frame.");
+	MetricsRegistry::Histogram inputLatencyMetric_ = MetricsRegistry::instance().histogram(
+		"app_input_latency_seconds", "Time from the oldest input event to the frame submit that used it.",
+		{ 0.001, 0.002, 0.004, 0.008, 0.016, 0.033, 0.05, 0.1 });
+	MetricsRegistry::Histogram simulationTimeMetric_ = MetricsRegistry::instance().histogram(
+		"app_simulation_time_seconds", "CPU time spent simulating one frame packet.",
+		{ 0.0005, 0.001, 0.002, 0.004, 0.008, 0.0167, 0.0333 });
+	MetricsRegistry::Histogram packetLatencyMetric_ = MetricsRegistry::instance().histogram(
+		"app_frame_packet_latency_seconds", "Time from publishing a frame packet until the render thread submitted it.",
+		{ 0.001, 0.002, 0.004, 0.008, 0.0167, 0.0333, 0.05 });
+	MetricsRegistry::Gauge drawCountMetric_ = MetricsRegistry::instance().gauge(
+		"app_draws", "Draw items in the last submitted frame packet.");
+
+	FrameCaptureWriter capture_;// \p̃t[̋L^(JĂƂL^)
+
+	// Ԃ̃t[Ńq[vmۂĂȂ̊mF(allocationCheckFrames_  0 ȂmFȂ)
+	// 񐔂̓XbhƂɐ̂ŁA`Xbh̃t[ƃV~[ṼXbh̃pPbgʁXɏWv
+	// ([J[Xbh⃁bV̓ǂݍ݂̃Xbhł̊mۂ͐Ȃ)
+	constexpr static uint64_t ALLOCATION_CHECK_WARMUP_FRAMES = 60;// ŏ̂̓LbVȂǂ̂ŐȂ
+	struct AllocationTally
+	{
+		uint64_t checked = 0;
+		uint64_t allocating = 0;// mۂt[(pPbg)̐
+		uint64_t max = 0;		// 1 t[(pPbg)ł̊mۂ̉񐔂̍ő
+
+		void add(uint64_t allocations)
+		{
+			checked++;
+			if (0 < allocations) {
+				allocating++;
+				max = std::max(max, allocations);
+			}
+		}
+	};
+	uint64_t allocationCheckFrames_ = 0;
+	AllocationTally renderAllocations_;
+	AllocationTally simulationAllocations_;// V~[ṼXbhAXbhIĂǂ
+
+	constexpr static char PIPELINE_CACHE_FILE[] = "pipeline_cache.bin";
 
 public:
 	MyApplication() : window_(nullptr) {}
-	~MyApplication() {}
+	~MyApplication() {}// Vulkan ̃IuWFNg͊eo[̃fXgN^Ŕj
+
+	// x`}[Nsp: x[XCɖptH[}Xxo checkPerformanceGate() s
+	// x͌؃C[ôŁA؃C[̖rhx[XCǂ߂ȂƂ́AxƂ݂ȂɎs
+	void enablePerformanceGate(const std::string& baselinePath)
+	{
+		if (!enableValidationLayers) throw std::runtime_error("performance gate requires validation layers (use a debug build)!");
+		if (!std::ifstream(baselinePath)) throw std::runtime_error("failed to open performance baseline " + baselinePath + " !");
+		performanceBaseline_ = baselinePath;
+	}
+
+	// run() ̌ɌĂԁBVptH[}XxΕ\ false Ԃ
+	bool checkPerformanceGate()
+	{
+		if (performanceBaseline_.empty()) return true;
+
+		std::vector<std::string> newWarnings = debugMessageHandlers_.performanceLint.findNewWarnings(performanceBaseline_);
+		for (const std::string& name : newWarnings) {
+			std::cerr << "new performance warning: " << name << std::endl;
+		}
+		return newWarnings.empty();
+	}
+
+	// EH[Abv̌ frames t[ŁA`ƃV~[ṼXbhq[vmۂȂmFďI
+	void enableAllocationCheck(uint64_t frames)
+	{
+		if (!AllocationCounter::enabled()) throw std::runtime_error("allocation counter is disabled in this build!");
+		allocationCheckFrames_ = frames;
+	}
+
+	// run() ̌ɌĂԁBmۂt[Ε\ false Ԃ
+	bool checkAllocations() const
+	{
+		if (allocationCheckFrames_ == 0) return true;
+
+		std::cout << "allocation check: " << renderAllocations_.checked << " frame(s), " << renderAllocations_.allocating
+			<< " allocating frame(s), max " << renderAllocations_.max << " allocation(s) per frame (render thread)" << std::endl;
+		std::cout << "allocation check: " << simulationAllocations_.checked << " packet(s), " << simulationAllocations_.allocating
+			<< " allocating packet(s), max " << simulationAllocations_.max << " allocation(s) per packet (simulation thread)" << std::endl;
+		std::cout << "allocation check: worker and mesh loading threads are not counted" << std::endl;
+		return renderAllocations_.checked == allocationCheckFrames_ && renderAllocations_.allocating == 0
+			&& simulationAllocations_.allocating == 0;
+	}
+
+	// ŏ̃t[𑁂oƂD悷(pCvC̍쐬͍ŏ̃t[̌)
+	void enableFastStart()
+	{
+		fastStart_ = true;
+	}
+
+	// first t[ڂ count t[Ԃ GPU ̏ path ɋL^
+	void enableCapture(const std::string& path, uint64_t first, uint64_t count)
+	{
+		if (!capture_.open(path, first, count)) {
+			throw std::runtime_error("failed to open capture file!");
+		}
+	}
+
+	// EBhE炸ɌvZv~eBuƃCg̐U蕪̃x`}[Ns(ʂQƎƈvȂ false)
+	// GPU  CPU őɎsACg̐U蕪͎QƎ𑪂
+	bool runComputeBenchmark(size_t count, uint32_t iterations)
+	{
+		return runComputeJob([&](ComputeBackend& backend) {
+			bool computeMatched = ComputeBenchmark(count, iterations).run(backend, std::cout);
+			std::cout << std::endl;
+			bool lightsMatched = LightBinningBenchmark({ 256, 1024, 4096, 16384 }, iterations)
+				.run(device_ ? &lightClusterer_ : nullptr, std::cout);
+			return computeMatched && lightsMatched;
+		});
+	}
+
+	// SĂ̕foCX̃XibvVbg path ɏo(EBhEȂ)
+	void dumpDeviceSnapshots(const std::string& path)
+	{
+		VkInstance instance;
+		createInstance(&instance, &debugMessageHandlers_, true);
+		instance_ = UniqueInstance(instance, vkDestroyInstance);
+
+		uint32_t deviceCount = 0;
+		vkEnumeratePhysicalDevices(instance_.get(), &deviceCount, nullptr);
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(instance_.get(), &deviceCount, devices.data());
+
+		std::vector<DeviceSnapshot> snapshots;
+		for (VkPhysicalDevice device : devices) snapshots.push_back(DeviceSnapshot::capture(device));
+		DeviceSnapshot::save(path, snapshots);
+		std::cout << "wrote " << snapshots.size() << " device snapshot(s) to " << path << std::endl;
+
+		instance_.reset();
+	}
+
+	// oXibvVbg͋[foCXƂāANƓfoCX̑IƐݒ̌sAʂ\
+	// (gfoCX false)
+	static bool replayDeviceSnapshots(const std::string& path, std::ostream& out)
+	{
+		std::vector<DeviceSnapshot> snapshots = DeviceSnapshot::load(path);
+
+		// foCX̑I
+		size_t best = snapshots.size();
+		int bestScore = 0;
+		DeviceCapabilities capabilities;
+		for (size_t i = 0; i < snapshots.size(); i++) {
+			DeviceCapabilities candidate;
+			int score = rateDeviceSuitability(PhysicalDeviceView(snapshots[i]), &candidate);
+			out << "device " << i << ": " << snapshots[i].properties.deviceName << " (score: " << score << ")" << std::endl;
+			if (bestScore < score) {
+				best = i;
+				bestScore = score;
+				capabilities = candidate;
+			}
+		}
+		if (best == snapshots.size()) {
+			out << "no suitable device" << std::endl;
+			return false;
+		}
+		const DeviceSnapshot& snapshot = snapshots[best];
+		out << "selected: device " << best << std::endl;
+
+		// L[ƁAt[̏̑gݍ킹(DeviceCapabilities.h)
+		out << "graphics queue family: " << capabilities.graphicsFamily.value() << std::endl;
+		out << "async compute queue family: ";
+		if (capabilities.hasAsyncCompute()) out << capabilities.asyncComputeFamily.value() << std::endl;
+		else out << "none" << std::endl;
+		bool memoryBudget = snapshot.hasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		bool timelineSemaphore = snapshot.hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) && snapshot.timelineSemaphore == VK_TRUE;
+		out << "timeline semaphore: " << (timelineSemaphore ? "yes" : "no (fence pool)") << std::endl;
+		out << "memory budget extension: " << (memoryBudget ? "yes" : "no (tracked usage)") << std::endl;
+
+		// (gƂ MemoryBudgetMonitor q[v 8 \ZƂ݂Ȃ)
+		const VkPhysicalDeviceMemoryProperties& memory = snapshot.memoryProperties;
+		for (uint32_t i = 0; i < memory.memoryHeapCount; i++) {
+			const VkMemoryHeap& heap = memory.memoryHeaps[i];
+			out << "heap " << i << ": " << (heap.size >> 20) << " MiB"
+				<< ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " device local" : "")
+				<< ", fallback budget " << ((heap.size / 10 * 8) >> 20) << " MiB" << std::endl;
+		}
+		try {
+			out << "staging memory type: " << GpuUploader::findMemoryType(memory, ~0u,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) << std::endl;
+			out << "device local memory type: " << GpuUploader::findMemoryType(memory, ~0u, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) << std::endl;
+		}
+		catch (const std::runtime_error& e) {
+			out << e.what() << std::endl;
+		}
+
+		// vZv~eBu̐ݒ
+		ComputeDeviceFeatures compute = ComputeDeviceFeatures::fromProperties(snapshot.properties, snapshot.subgroup);
+		uint32_t workgroupSize = 0;
+		uint32_t itemsPerInvocation = 0;
+		GpuCompute::chooseWorkgroupShape(compute, &workgroupSize, &itemsPerInvocation);
+		out << "compute kernels: " << (compute.subgroupOperations ? "subgroup" : "shared memory")
+			<< ", subgroup " << compute.subgroupSize << ", workgroup " << workgroupSize
+			<< ", block " << workgroupSize * itemsPerInvocation << std::endl;
+		return true;
+	}
+
+	// EBhEȂŌvZ̏s(GPU  CpuCompute Ŏs)
+	bool runComputeJob(const std::function<bool(ComputeBackend&)>& job)
+	{
+		headless_ = true;
+		try {
+			initializeVulkan();
+		}
+		catch (const NoDeviceError& e) {
+			std::cerr << e.what() << " running on the CPU instead." << std::endl;
+			// foCXOɎsĂ̂ŁACX^X܂łЕt
+			finalizeDebugMessenger(debugMessenger_, debugMessageHandlers_);
+			instance_.reset();
+
+			CpuCompute cpu;
+			return job(cpu);
+		}
+
+		// foCXꂽ蒼āAŏ蒼(obt@ job ̒ō蒼)
+		bool result;
+		for (;;) {
+			try {
+				result = job(compute_);
+				break;
+			}
+			catch (const DeviceLostError& e) {
+				recoverDevice(e);
+			}
+		}
+
+		finalizeVulkan();
+		return result;
+	}
 
 	void run()
 	{
 		// 
-		initializeWindow();
-		initializeVulkan();
+		if (fastStart_) {
+			// CX^XƃfoCX͕ʂ̃XbhōÅԂɃEBhE
+			// (GLFW ̏ƃEBhE̍쐬̓CXbhłłȂ)
+			glfwInit();
+			std::future<void> vulkan = std::async(std::launch::async, [this]() { initializeVulkan(); });
+			createWindow();
+			vulkan.get();
+		}
+		else {
+			initializeWindow();
+			initializeVulkan();
+		}
 
 		// ʏ폈
 		mainloop();
@@ -48,15 +431,17 @@ private:
 	// \EBhE̐ݒ
 	void initializeWindow()
 	{
-		const int WIDTH = 800;
-		const int HEIGHT = 600;
-
 		glfwInit();
+		createWindow();
+	}
 
+	void createWindow()
+	{
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);// OpenGL ̎ނ̐ݒ
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);// [U[̓EBhETCYύXłȂ
 
-		window_ = glfwCreateWindow(WIDTH, HEIGHT, APP_NAME, nullptr, nullptr);
+		window_ = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, APP_NAME, nullptr, nullptr);
+		input_.attach(window_);
 	}
 
 	void finalizeWindow()
@@ -66,29 +451,444 @@ private:
 	}
 
 	// ʏ̏
+	// GLFW ̃Cxg̓CXbhłłȂ̂ŁACXbh̓Cxg҂ɂB
+	// V~[ṼXbh͂荞Ńt[pPbgA`Xbhǂ Vulkan ̏s
 	void mainloop()
 	{
-		while (!glfwWindowShouldClose(window_))
+		metricsExporter_.serveSocket(METRICS_SOCKET_FILE);
+
+		// ǂ炩̃XbhIAƃCxg҂̃CXbhN
+		std::exception_ptr simulationError;
+		std::exception_ptr renderError;
+		auto startThread = [this](void (MyApplication::*loop)(), std::exception_ptr& error) {
+			return std::thread([this, loop, &error]() {
+				try {
+					(this->*loop)();
+				}
+				catch (...) {
+					error = std::current_exception();
+				}
+				requestQuit();
+			});
+		};
+		std::thread simulationThread = startThread(&MyApplication::simulationLoop, simulationError);
+		std::thread renderThread = startThread(&MyApplication::renderLoop, renderError);
+
+		while (!quit_.load(std::memory_order_acquire))
 		{
-			glfwPollEvents();
+			glfwWaitEvents();// ͂̃R[obN͂Ă΂
+			if (glfwWindowShouldClose(window_)) requestQuit();
+		}
+		simulationThread.join();
+		renderThread.join();
+		if (0 < input_.droppedCount()) std::cerr << "input events dropped: " << input_.droppedCount() << std::endl;
+
+		metricsExporter_.stopSocket();
+		MetricsExporter::writeFile(METRICS_FILE);
+		PROFILE_WRITE_TRACE(CPU_TRACE_FILE);
+		if (renderError) std::rethrow_exception(renderError);
+		if (simulationError) std::rethrow_exception(simulationError);
+	}
+
+	// V~[ṼXbh
+	// 󂢂pPbgΕ`悪ǂ܂ő҂̂ŁA`ɐi݂邱Ƃ͂Ȃ
+	void simulationLoop()
+	{
+		auto previousTime = std::chrono::steady_clock::now();
+		for (uint64_t packetIndex = 0;; packetIndex++)
+		{
+			FramePacket* packet = framePackets_.beginWrite();
+			if (packet == nullptr) break;// I
+
+			PROFILE_ZONE("simulate");
+			uint64_t allocationsBefore = AllocationCounter::count();
+			auto start = std::chrono::steady_clock::now();
+
+			// ͂̓pPbgOɎ荞
+			input_.sample(inputState_);
+			simulation_.update(std::chrono::duration<double>(start - previousTime).count(), inputState_);
+			simulation_.writePacket(*packet);
+			packet->inputEventCount = inputState_.eventCount;
+			packet->oldestInput = inputState_.oldestEvent;
+			previousTime = start;
+
+			framePackets_.publish(packet);
+			simulationTimeMetric_.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+			if (0 < allocationCheckFrames_ && ALLOCATION_CHECK_WARMUP_FRAMES <= packetIndex) {
+				simulationAllocations_.add(AllocationCounter::count() - allocationsBefore);
+			}
+		}
+	}
+
+	// `Xbh
+	void renderLoop()
+	{
+		auto previousTime = std::chrono::steady_clock::now();
+		auto lastExportTime = previousTime;
+
+		// \͂ƂɎ̉t[̏I(foCX蒼Ĕ\͂ςIђ)
+		while (!quit_.load(std::memory_order_acquire))
+		{
+			dispatchCapabilities(capabilities_, [&](auto path) { runFrames<decltype(path)>(previousTime, lastExportTime); });
+		}
+	}
+
+	// ǂ̃XbhĂł悢
+	void requestQuit()
+	{
+		quit_.store(true, std::memory_order_release);
+		framePackets_.close();// pPbg҂ĂXbhN
+		glfwPostEmptyEvent();
+	}
+
+	// 1 t[Ԃ̏AEBhE邩foCX̔\͂ς܂ŌJԂ
+	// (Path  dispatchCapabilities() őI񂾂̂ŁAł͋@\̗Lŕ򂵂Ȃ)
+	template <typename Path>
+	void runFrames(std::chrono::steady_clock::time_point& previousTime, std::chrono::steady_clock::time_point& lastExportTime)
+	{
+		while (!quit_.load(std::memory_order_acquire))
+		{
+			// foCXꂽÃt[͎̂ĂăfoCX蒼Ãt[瑱
+			try {
+				PROFILE_ZONE("frame");
+				ScratchScope frameScratch;// t[̒ŎgꎞIȔz͂(t[̏Iɂ܂Ƃ߂ĉ)
+				uint64_t allocationsBefore = AllocationCounter::count();
+				capture_.beginFrame(frameIndex_);
+
+				// MAX_FRAMES_IN_FLIGHT t[O GPU ̏I܂ő҂A
+				// ĨR[obNƁAgIIuWFNg̔js
+				uint64_t frameSlot = frameIndex_ % MAX_FRAMES_IN_FLIGHT;
+				graphicsTimeline_.wait<Path::TIMELINE_SEMAPHORE>(frameTimelineValues_[frameSlot]);
+				graphicsTimeline_.runCallbacks<Path::TIMELINE_SEMAPHORE>();// GPU ̊҂Ă^XNōĊJ
+				tasks_.poll();
+				deletionQueue_.collect(graphicsTimeline_.completedValue<Path::TIMELINE_SEMAPHORE>());
+
+				// ̎gp󋵂mFAȂȂOɑ΍􂷂
+				memoryBudget_.poll<Path::MEMORY_BUDGET>();
+				memoryPolicy_.evaluate(memoryBudget_);
+
+				// vl̍XV(t@Cւ̏o 1 b)
+				auto now = std::chrono::steady_clock::now();
+				frameTimeMetric_.observe(std::chrono::duration<double>(now - previousTime).count());
+				frameCountMetric_.add();
+				updateMemoryMetrics();
+				pendingDeletionMetric_.set(static_cast<double>(deletionQueue_.size()));
+				if (std::chrono::seconds(1) <= now - lastExportTime) {
+					AllocationCounter::Exempt exempt;// t[Ƃ̏ł͂Ȃ̂Ŋmۂ𐔂Ȃ
+					MetricsExporter::writeFile(METRICS_FILE);
+					lastExportTime = now;
+#ifdef _DEBUG
+					// VF[_[Ă痠ŃRpC(`͎~߂Ȃ)AIpCvC蒼
+					if (shaderCompile_.valid() && shaderCompile_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+						if (shaderCompile_.get()) reloadPipelines();
+					}
+					if (!shaderCompile_.valid() && shaders_.sourcesChanged()) {
+						shaderCompile_ = std::async(std::launch::async, [this]() { return shaders_.compile(true); });
+					}
+#endif // _DEBUG
+				}
+				previousTime = now;
+
+				// V~[VpPbǵAR}hL^钼OɎ󂯎(t[̏߂Ɏ󂯎VԂf)
+				// (t[𔲂ƂɁAOŔƂ܂߂ăV~[VɕԂ)
+				FramePacketRing<FRAME_PACKET_DEPTH>::Lease packet(framePackets_);
+				if (!packet) return;// I
+				drawCountMetric_.set(static_cast<double>(packet->drawCount));
+
+				// Cg̐U蕪Rs[g̃L[ɐɑAt[̓CggtOgVF[_[̑Oł҂
+				// (񓯊Rs[g̃L[΁ÅԂɃOtBbNX̃L[͑O̒iKi߂)
+				frameWaits_[0] = lightClusterer_.bin<Path::TIMELINE_SEMAPHORE>(static_cast<uint32_t>(frameSlot),
+					packet->camera, packet->lights, packet->lightCount);
+
+				// t[̏Ï(̃t[őSďIƁA̒lɂȂ)
+				frameSubmit_[0] = recordFrame(frameSlot, *packet);
+				frameTimelineValues_[frameSlot] = graphicsTimeline_.submit<Path::TIMELINE_SEMAPHORE>(frameSubmit_,
+					frameWaits_, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+				countQueueSubmits();
+				if (frameIndex_ == 0) recordFirstFrame(frameTimelineValues_[frameSlot]);
+				observePacketLatency(*packet);
+
+				capture_.endFrame(frameIndex_);
+				if (enableValidationLayers) debugMessageHandlers_.limiter.endFrame(std::cerr);
+				if (0 < allocationCheckFrames_) countFrameAllocations(AllocationCounter::count() - allocationsBefore);
+				frameIndex_++;
+				debugMessageHandlers_.performanceLint.setFrame(frameIndex_);
+			}
+			catch (const DeviceLostError& e) {
+				recoverDevice(e);
+				if (!Path::matches(capabilities_)) return;
+			}
+		}
+	}
+
+	// t[pPbgt[̃R}hobt@L^(Xbg̑Õt[ GPU ŏIĂĂ)
+	// `pX͂܂̂ŁACX^X̃f[^]Ƃ܂(` instanceBatcher_.recordDraws() 
+	// meshStreamer_.ranges() nċL^)
+	VkCommandBuffer recordFrame(uint64_t frameSlot, const FramePacket& packet)
+	{
+		VkCommandBuffer commandBuffer = frameCommandBuffers_[frameSlot];
+		vkResetCommandBuffer(commandBuffer, 0);
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+		{
+			DEBUG_CMD_LABEL(commandBuffer, "record frame");// CPU ̃][˂
+			// LOD IсAuĂ LOD ɓǂݑւĂ܂Ƃ߂
+			const uint8_t* lods = lodSelector_.select(packet, meshStreamer_.chains(), meshStreamer_.chainCount(),
+				static_cast<float>(WINDOW_HEIGHT), LOD_ERROR_PIXELS);
+			const uint32_t* meshes = meshStreamer_.resolve(packet, lods);
+			instanceBatcher_.build(static_cast<uint32_t>(frameSlot), packet, meshes);
+			instanceBatcher_.recordUpload(commandBuffer);
+			meshStreamer_.update(memoryPolicy_.actions());// V LOD ̓ǂݍ݂n߂Ƃ낾͊mۂ𐔂Ȃ
+		}
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record frame command buffer!");
+		}
+		return commandBuffer;
+	}
+
+	// Simulation gbV(0 ` 3)A𔼕ɂ 4 i LOD ̋Ƃēo^
+	void registerMeshes()
+	{
+		constexpr uint32_t LOD_COUNT = 4;
+		constexpr uint32_t FINEST_SEGMENTS = 64;
+		for (uint32_t mesh = 0; mesh < 4; mesh++) {
+			float radius = 0.5f + 0.1f * mesh;
+			MeshLodInfo lods[LOD_COUNT];
+			for (uint32_t lod = 0; lod < LOD_COUNT; lod++) {
+				uint32_t segments = FINEST_SEGMENTS >> lod;
+				lods[lod] = { ProceduralMesh::sphereError(segments, radius),
+					ProceduralMesh::sphereVertexCount(segments), ProceduralMesh::sphereIndexCount(segments) };
+			}
+			meshStreamer_.addMesh(lods, LOD_COUNT, radius, [radius](uint32_t lod, void* vertices, uint32_t* indices) {
+				ProceduralMesh::sphere(FINEST_SEGMENTS >> lod, radius, static_cast<MeshVertex*>(vertices), indices);
+			});
 		}
 	}
 
+	void createFrameCommandBuffers()
+	{
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;// XbgƂɋL^
+		poolInfo.queueFamilyIndex = capabilities_.graphicsFamily.value();
+		VkCommandPool pool;
+		if (vkCreateCommandPool(device_.get(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create frame command pool!");
+		}
+		frameCommandPool_ = UniqueCommandPool(device_.get(), pool, vkDestroyCommandPool);
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = pool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = MAX_FRAMES_IN_FLIGHT;
+		if (vkAllocateCommandBuffers(device_.get(), &allocInfo, frameCommandBuffers_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate frame command buffers!");
+		}
+		DEBUG_NAME(device_.get(), pool, "frame command pool");
+		for (uint64_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) DEBUG_NAME(device_.get(), frameCommandBuffers_[i], "frame");
+	}
+
+	// pPbgĂ瑗܂ł̒xƁApPbgɔfԌÂ͂̒xL^
+#ifdef _DEBUG
+	// RpCVF[_[ŃpCvC蒼(t[̃R}hL^OɌĂ)
+	// ÂpCvC͂܂łɑt[IĂ deletionQueue_ Ŕj
+	// (Cg̐U蕪̓Rs[g̃L[œAt[̊҂̂ graphicsTimeline_ ̒lő)
+	void reloadPipelines()
+	{
+		try {
+			lightClusterer_.reloadPipeline(shaders_, pipelineLayouts_, deletionQueue_, graphicsTimeline_.submittedValue());
+			compute_.reloadPipelines(shaders_, pipelineLayouts_);
+			std::cerr << "shaders reloaded" << std::endl;
+		}
+		catch (const std::runtime_error& e) {
+			std::cerr << "failed to reload shaders: " << e.what() << std::endl;// 蒼Ȃ̂͌ÂpCvĈ܂ܓ
+		}
+	}
+#endif // _DEBUG
+
+	// O񂩂̑M̐vlɑ(^CC̒l͑MƂ 1 )
+	// 񓯊Rs[g̃L[΁ACg̐U蕪OtBbNX̃L[̑Mɐ
+	void countQueueSubmits()
+	{
+		queueSubmitMetric_.add(graphicsTimeline_.submittedValue() - countedSubmits_);
+		countedSubmits_ = graphicsTimeline_.submittedValue();
+		if (computeQueue_ != VK_NULL_HANDLE) {
+			computeSubmitMetric_.add(computeTimeline_.submittedValue() - countedComputeSubmits_);
+			countedComputeSubmits_ = computeTimeline_.submittedValue();
+		}
+	}
+
+	void observePacketLatency(const FramePacket& packet)
+	{
+		auto now = std::chrono::steady_clock::now();
+		packetLatencyMetric_.observe(std::chrono::duration<double>(now - packet.producedTime).count());
+		if (0 < packet.inputEventCount) {
+			inputLatencyMetric_.observe(std::chrono::duration<double>(now - packet.oldestInput).count());
+		}
+	}
+
+	// ŏ̃t[ GPU ̏I܂ł̎ԂL^
+	void recordFirstFrame(uint64_t value)
+	{
+		graphicsTimeline_.onComplete(value, [this]() {
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime_).count();
+			firstFrameMetric_.set(seconds);
+			std::cout << "time to first frame: " << seconds * 1000.0 << " ms"
+				<< (fastStart_ ? " (fast start)" : "") << std::endl;
+		});
+	}
+
+	void countFrameAllocations(uint64_t allocations)
+	{
+		if (frameIndex_ < ALLOCATION_CHECK_WARMUP_FRAMES) return;
+
+		renderAllocations_.add(allocations);
+		if (allocationCheckFrames_ <= renderAllocations_.checked) requestQuit();
+	}
+
+	void updateMemoryMetrics()
+	{
+		const std::vector<MemoryHeapBudget>& heaps = memoryBudget_.heaps();
+		for (size_t i = 0; i < heaps.size(); i++) {
+			heapUsageMetrics_[i].set(static_cast<double>(heaps[i].usage));
+			heapBudgetMetrics_[i].set(static_cast<double>(heaps[i].budget));
+		}
+		memoryPressureMetric_.set(static_cast<double>(memoryPolicy_.pressure()));
+	}
+
 	// Vulkan̐ݒ
 	void initializeVulkan()
 	{
-		createInstance(&instance_);
-		initializeDebugMessenger(instance_, debugMessenger_);
-		physicalDevice_ = pickPhysicalDevice(instance_);
+		VkInstance instance;
+		createInstance(&instance, &debugMessageHandlers_, headless_);
+		instance_ = UniqueInstance(instance, vkDestroyInstance);
+		debugMessenger_ = initializeDebugMessenger(instance_.get(), &debugMessageHandlers_);
+		if (enableValidationLayers) DEBUG_UTILS_INITIALIZE(instance_.get());// VK_EXT_debug_utils ͌؃C[ƈꏏɗLɂĂ
+		capabilities_ = pickPhysicalDevice(instance_.get());
+		physicalDevice_ = capabilities_.physicalDevice;
+		initializeDevice();
+		registerMeshes();
+
+		for (size_t i = 0; i < memoryBudget_.heaps().size(); i++) {
+			std::string labels = "heap=\"" + std::to_string(i) + "\"";
+			heapUsageMetrics_.push_back(MetricsRegistry::instance().gauge(
+				"gpu_memory_heap_usage_bytes", "Device memory used by this process per heap.", labels));
+			heapBudgetMetrics_.push_back(MetricsRegistry::instance().gauge(
+				"gpu_memory_heap_budget_bytes", "Device memory budget per heap.", labels));
+		}
+#ifdef _DEBUG
+		memoryPolicy_.addListener([](MemoryPressure pressure, const MemoryPolicyActions& actions) {
+			std::cout << "memory pressure: " << MemoryBudgetPolicy::toString(pressure)
+				<< " (upload budget: " << actions.uploadBytesPerFrame / (1024 * 1024) << " MB/frame"
+				<< (actions.evictStreamingCaches ? ", evicting streaming caches" : "") << ")" << std::endl;
+		});
+#endif // _DEBUG
 	}
 
+	// _foCX牺̐ݒ(foCXꂽƂ͂蒼)
+	void initializeDevice()
+	{
+		EnabledDeviceFeatures enabledFeatures;
+		device_ = UniqueDevice(createLogicalDevice(capabilities_, &graphicsQueue_, &computeQueue_, &enabledFeatures), vkDestroyDevice);
+		graphicsTimeline_.initialize(device_.get(), graphicsQueue_, enabledFeatures.timelineSemaphore);
+		if (computeQueue_ != VK_NULL_HANDLE) computeTimeline_.initialize(device_.get(), computeQueue_, enabledFeatures.timelineSemaphore);
+		pipelineCache_ = UniquePipelineCache(device_.get(), createPipelineCache(device_.get(), physicalDevice_), vkDestroyPipelineCache);
+
+		// fobKvt@CŌ悤ɖOt
+		DEBUG_NAME(device_.get(), device_.get(), "main device");
+		DEBUG_NAME(device_.get(), graphicsQueue_, "graphics queue");
+		DEBUG_NAME(device_.get(), pipelineCache_.get(), "pipeline cache");
+		DEBUG_NAME(device_.get(), graphicsTimeline_.semaphore(), "graphics timeline");
+		if (computeQueue_ != VK_NULL_HANDLE) {
+			DEBUG_NAME(device_.get(), computeQueue_, "async compute queue");
+			DEBUG_NAME(device_.get(), computeTimeline_.semaphore(), "async compute timeline");
+		}
+
+		memoryBudget_.initialize(instance_.get(), physicalDevice_, enabledFeatures.memoryBudget);
+		uploader_.initialize(device_.get(), &graphicsTimeline_, capabilities_.graphicsFamily.value(), &memoryBudget_);
+		pipelineLayouts_.initialize(device_.get());
+		createFrameCommandBuffers();
+		instanceBatcher_.initialize(device_.get(), &memoryBudget_, &capture_, MAX_FRAMES_IN_FLIGHT, FramePacket::MAX_DRAWS);
+		lightClusterer_.initialize(device_.get(), &memoryBudget_, &capture_, &computeTimeline(), computeFamily(), capabilities_.graphicsFamily.value(),
+			MAX_FRAMES_IN_FLIGHT, FramePacket::MAX_LIGHTS, pipelineCache_.get(), shaders_, pipelineLayouts_);
+		// bṼobt@͗\Zɍ킹ďł̂ŁA点Ȃ̂mۂɂ
+		meshStreamer_.initialize(device_.get(), &graphicsTimeline_, &uploader_, &tasks_, &deletionQueue_, &memoryBudget_, &capture_, MESH_RESIDENCY_BYTES);
+		compute_.initialize(device_.get(), physicalDevice_, pipelineCache_.get(), &graphicsTimeline_,
+			capabilities_.graphicsFamily.value(), &uploader_, &deletionQueue_, &memoryBudget_, shaders_, pipelineLayouts_,
+			fastStart_ ? GpuCompute::PipelineCreation::Background : GpuCompute::PipelineCreation::Immediate);
+
+		// ۂɎgƂɂȂ@\L^(t[̏͂őI)
+		capabilities_.timelineSemaphore = graphicsTimeline_.usesTimelineSemaphore();
+		capabilities_.memoryBudget = memoryBudget_.usesBudgetExtension();
+	}
+
+	// ĵ͊eo[sAԂƎȌKvȂ̂͂ŖIɕЕt
 	void finalizeVulkan()
 	{
-		finalizeDebugMessenger(instance_, debugMessenger_);
-		vkDestroyInstance(instance_, nullptr);
+		finalizeDevice();
+		finalizeDebugMessenger(debugMessenger_, debugMessageHandlers_);
+		instance_.reset();
+	}
+
+	void finalizeDevice()
+	{
+		// I GPU ̏SďÎ҂AaĂ̂܂Ƃ߂Ĕj
+		// (ĊJ^XN GPU ɏ𑗂邱Ƃ̂ŁAĊĴȂ܂ŌJԂ)
+		// foCXꂽ́A^CCSďIƂɂĂ̂ő҂ɐi
+		vkDeviceWaitIdle(device_.get());
+		while (0 < graphicsTimeline_.runCallbacks() + computeTimeline_.runCallbacks()) vkDeviceWaitIdle(device_.get());
+		tasks_.poll();
+		tasks_.clear();
+		deletionQueue_.flush();
+		meshStreamer_.finalize();
+		uploader_.finalize();
+		compute_.finalize();
+		instanceBatcher_.finalize();
+		lightClusterer_.finalize();
+		frameCommandPool_.reset();
+		pipelineLayouts_.clear();
+		graphicsTimeline_.finalize();
+		computeTimeline_.finalize();
+		computeQueue_ = VK_NULL_HANDLE;
+
+		savePipelineCache(device_.get(), pipelineCache_.get());
+		pipelineCache_.reset();
+		device_.reset();
+	}
+
+	// _foCX牺蒼(ei initializeDevice() ō蒼AbV LOD ͎gꂽƂɓǂݍݒ)
+	// (pCvCLbV͕ۑt@CǂݒAVF[_[̓RpCς݂̂̂g)
+	void recoverDevice(const DeviceLostError& error)
+	{
+		deviceRecovery_.recover(error, [this]() { finalizeDevice(); }, [this]() {
+			initializeDevice();
+			std::fill(std::begin(frameTimelineValues_), std::end(frameTimelineValues_), 0);// V^CC 0 n܂
+			countedSubmits_ = 0;
+			countedComputeSubmits_ = 0;
+		});
 	}
 
-	static void createInstance(VkInstance* dest)
+	// Rs[g̏𑗂L[̃^CCƃL[t@~[(񓯊Rs[g̃L[΃OtBbNX̂)
+	QueueTimeline& computeTimeline() { return computeQueue_ != VK_NULL_HANDLE ? computeTimeline_ : graphicsTimeline_; }
+	uint32_t computeFamily() const
+	{
+		return computeQueue_ != VK_NULL_HANDLE ? capabilities_.asyncComputeFamily.value() : capabilities_.graphicsFamily.value();
+	}
+
+	// LOD ̑IɎgXbh̐(`Xbh܂)
+	// V~[ṼXbht[̂ŁA̕ 1 󂯂Ă
+	static size_t lodSelectionThreads()
+	{
+		return std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	static void createInstance(VkInstance* dest, DebugMessageHandlers* debugMessageHandlers, bool headless)
 	{
 		// AvP[V߂邽߂̍\
 		VkApplicationInfo appInfo = {};
@@ -97,116 +897,93 @@ private:
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);		// J҂߂o[Wԍ
 		appInfo.pEngineName = "My Engine";							// Q[GW
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);			// Q[GW̃o[W
-		appInfo.apiVersion = VK_API_VERSION_1_0;					// gpAPĨo[W
+		appInfo.apiVersion = VK_API_VERSION_1_1;					// gpAPĨo[W(vkGetPhysicalDeviceMemoryProperties2 g 1.1)
 
 		// VCX^X̐ݒ̍\
 		VkInstanceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;	// \̂̎
 		createInfo.pApplicationInfo = &appInfo;						// VkApplicationInfȍ
 
+		// ΉĂ郌C[Ɗg 1 x񋓂āAĝ߂
+		ScratchScope scratch;
+		ExtensionNegotiator negotiator = ExtensionNegotiator::forInstance(scratch);
+
 		// valkan̊g@\擾āAf[^ɒǉ
-		std::vector<const char*> extensions = getRequiredExtensions();
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
-		createInfo.ppEnabledExtensionNames = extensions.data();
+		requestInstanceExtensions(negotiator, headless);
 
 		if (enableValidationLayers) {
-			static const std::vector<const char*> validationLayers = {
-				"VK_LAYER_KHRONOS_validation"
-			};
-
 			// ؃C[̊mF
-			if (!checkValidationLayerSupport(validationLayers)) {
+			if (!negotiator.hasLayer("VK_LAYER_KHRONOS_validation")) {
 				throw std::runtime_error("validation layers requested, but not available!");
 			}
-
-			// CX^Xւ̐ݒ
-			createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
-			createInfo.ppEnabledLayerNames = validationLayers.data();
+			negotiator.enableLayer("VK_LAYER_KHRONOS_validation", ExtensionNegotiator::Requirement::Required);
 
 			// fobObZW[̌Ɉč쐬
-			VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo = populateDebugMessengerCreateInfo();
+			VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo = populateDebugMessengerCreateInfo(debugMessageHandlers);
 			createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*)&debugCreateInfo;
 		}
 
-		// CX^X̐
-		if (vkCreateInstance(&createInfo, nullptr, dest) != VK_SUCCESS) {
+		negotiator.negotiate();
+		createInfo.enabledExtensionCount = negotiator.extensionCount();
+		createInfo.ppEnabledExtensionNames = negotiator.extensionNames();
+		createInfo.enabledLayerCount = negotiator.layerCount();
+		createInfo.ppEnabledLayerNames = negotiator.layerNames();
+#ifdef _DEBUG
+		negotiator.report(std::cout, "instance extensions");
+#endif // _DEBUG
+
+		// CX^X̐(hCo[Ƃ VK_ERROR_INCOMPATIBLE_DRIVER ɂȂ)
+		VkResult result = vkCreateInstance(&createInfo, nullptr, dest);
+		if (result == VK_ERROR_INCOMPATIBLE_DRIVER) throw NoDeviceError("failed to find a Vulkan driver!");
+		if (result != VK_SUCCESS) {
 			throw std::runtime_error("failed to create instance!");
 		}
 	}
 
-	static std::vector<const char*> getRequiredExtensions()
+	static void requestInstanceExtensions(ExtensionNegotiator& negotiator, bool headless)
 	{
-		// ǧo
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
-
-		if (enableValidationLayers) {
-			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-		}
-
-#ifdef _DEBUG
-		// LȃGNXeV̕\
-		std::cout << "available extensions:" << std::endl;
-		for (const auto& extension : extensions) {
-			std::cout << "\t" << extension << std::endl;
+		// EBhEɕ\Ƃ GLFW KvƂg
+		if (!headless) {
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+			for (uint32_t i = 0; i < glfwExtensionCount; i++) {
+				negotiator.request(glfwExtensions[i], ExtensionNegotiator::Requirement::Required);
+			}
 		}
-#endif
 
-		return extensions;
-	}
-
-	// ؃C[ɑΉĂ邩mF
-	static bool checkValidationLayerSupport(const std::vector<const char*>& validationLayers)
-	{
-		// C[̃vpeB擾
-		uint32_t layerCount;
-		vkEnumerateInstanceLayerProperties(&layerCount, nullptr);				// C[̎擾
-		std::vector<VkLayerProperties> availableLayers(layerCount);
-		vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());// vpeB̂̎擾
-
-		// SẴC[؃C[ɑΉĂ邩mF
-		for (const char* layerName : validationLayers) {
-			if (![](const char* layerName, const auto& availableLayers) {
-				// C[؃C[̂ǂꂩĂ邩mF
-				for (const auto& layerProperties : availableLayers) {
-					if (strcmp(layerName, layerProperties.layerName) == 0) { return true; }
-				}
-				return false;
-				}(layerName, availableLayers)) {
-				return false;
-			}// ǂ̃C[validationLayers̃C[ɑΉĂȂ̂̓_
+		if (enableValidationLayers) {
+			negotiator.request(VK_EXT_DEBUG_UTILS_EXTENSION_NAME, ExtensionNegotiator::Requirement::Required);
 		}
-
-		return true;
 	}
 
 	/*** foCX̑I ***/
-	static VkPhysicalDevice pickPhysicalDevice(const VkInstance& instance)
+	// I񂾃foCX̔\͂Ԃ(foCXƂɕ@\ initializeDevice() Ŗ߂)
+	static DeviceCapabilities pickPhysicalDevice(const VkInstance& instance)
 	{
 		// foCX̎擾
 		uint32_t deviceCount = 0;
 		vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
-		if (deviceCount == 0) throw std::runtime_error("failed to find GPUs with Vulkan support!");
+		if (deviceCount == 0) throw NoDeviceError("failed to find GPUs with Vulkan support!");
 
 		// foCX̎擾
-		std::vector<VkPhysicalDevice> devices(deviceCount);
+		SmallVector<VkPhysicalDevice, 8> devices;
+		devices.resize(deviceCount);
 		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
 
 		// K؂ȃfoCXIo(ō_̃foCXgp)
-		VkPhysicalDevice best_device = VK_NULL_HANDLE;
+		DeviceCapabilities best_device;
 		int best_score = 0;
 		for (const auto& device : devices) {
-			int score = rateDeviceSuitability(device);
+			DeviceCapabilities capabilities;
+			int score = rateDeviceSuitability(PhysicalDeviceView(device), &capabilities);
 			if (best_score < score) {
-				best_device = device;
+				best_device = capabilities;
 				best_score = score;
 			}
 		}
 
 		// g镨foCXȂΑ
-		if (best_device == VK_NULL_HANDLE) throw std::runtime_error("failed to find a suitable GPU!");
+		if (best_device.physicalDevice == VK_NULL_HANDLE) throw NoDeviceError("failed to find a suitable GPU!");
 
 		return best_device;
 	}
@@ -214,19 +991,23 @@ private:
 	struct QueueFamilyIndices
 	{
 		std::optional<uint32_t> graphicsFamily;
+		std::optional<uint32_t> asyncComputeFamily;// Ă悢
 
 		bool isComplete() {
 			return graphicsFamily.has_value();// ́Ao^Ăok
 		}
 	};
 
-	static int rateDeviceSuitability(const VkPhysicalDevice device)
+	// ׂƂ capabilities ɋL^(I΂ꂽfoCX̂̂́Aȍ~͖₢킹Ȃ)
+	// device ̓XibvVbgł悢(̂Ƃ capabilities->physicalDevice  VK_NULL_HANDLE)
+	static int rateDeviceSuitability(const PhysicalDeviceView& device, DeviceCapabilities* capabilities)
 	{
 		// foCXɊւ擾
-		VkPhysicalDeviceProperties deviceProperties;
-		VkPhysicalDeviceFeatures deviceFeatures;
-		vkGetPhysicalDeviceProperties(device, &deviceProperties);
-		vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+		VkPhysicalDeviceProperties& deviceProperties = capabilities->properties;
+		VkPhysicalDeviceFeatures& deviceFeatures = capabilities->features;
+		capabilities->physicalDevice = device.handle();
+		device.getProperties(&deviceProperties);
+		device.getFeatures(&deviceFeatures);
 
 		int score = 0;
 
@@ -242,6 +1023,8 @@ private:
 		// Queue FamilẙmF
 		QueueFamilyIndices indices = findQueueFamilies(device);
 		if (!indices.isComplete()) return 0;
+		capabilities->graphicsFamily = indices.graphicsFamily;
+		capabilities->asyncComputeFamily = indices.asyncComputeFamily;
 
 #ifdef _DEBUG
 		// foCX̕\
@@ -251,14 +1034,15 @@ private:
 		return score;
 	}
 
-	static QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device)
+	static QueueFamilyIndices findQueueFamilies(const PhysicalDeviceView& device)
 	{
 		// L[t@~[̐擾
+		ScratchScope scratch;
 		uint32_t queueFamilyCount = 0;
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+		device.getQueueFamilyProperties(&queueFamilyCount, nullptr);
 		// L[t@~[擾
-		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+		ScratchArray<VkQueueFamilyProperties> queueFamilies = scratch.allocate<VkQueueFamilyProperties>(queueFamilyCount);
+		device.getQueueFamilyProperties(&queueFamilyCount, queueFamilies.data());
 
 #ifdef _DEBUG
 		std::cout << std::endl;
@@ -274,10 +1058,14 @@ private:
 
 			// L[t@~[ɃL[AOtBbNXL[ƂĎg邩ׂ
 			if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-				indices.graphicsFamily = i;
+				if (!indices.graphicsFamily.has_value()) indices.graphicsFamily = i;
+			}
+			// OtBbNXȂRs[g̃L[́AOtBbNXƕsē
+			else if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) {
+				if (!indices.asyncComputeFamily.has_value()) indices.asyncComputeFamily = i;
 			}
 
-			if (indices.isComplete()) {
+			if (indices.isComplete() && indices.asyncComputeFamily.has_value()) {
 				break;
 			}
 
@@ -287,21 +1075,151 @@ private:
 		return indices;
 	}
 
+	/*** _foCX̍쐬 ***/
+	// ΉĂ̂ŗLɂ@\(gƋ@\̍\)
+	struct EnabledDeviceFeatures
+	{
+		bool memoryBudget = false;		// VK_EXT_memory_budget
+		bool timelineSemaphore = false;	// VK_KHR_timeline_semaphore
+	};
+
+	// computeQueue ɂ͔񓯊Rs[g̃L[(L[t@~[ VK_NULL_HANDLE)
+	static VkDevice createLogicalDevice(const DeviceCapabilities& capabilities, VkQueue* graphicsQueue, VkQueue* computeQueue, EnabledDeviceFeatures* enabled)
+	{
+		VkPhysicalDevice physicalDevice = capabilities.physicalDevice;
+
+		// gpL[̐ݒ(OtBbNXƁAΔ񓯊Rs[g)
+		float queuePriority = 1.0f;
+		VkDeviceQueueCreateInfo queueCreateInfos[2] = {};
+		uint32_t queueCreateInfoCount = 0;
+		for (const std::optional<uint32_t>& family : { capabilities.graphicsFamily, capabilities.asyncComputeFamily }) {
+			if (!family.has_value()) continue;
+			VkDeviceQueueCreateInfo& queueCreateInfo = queueCreateInfos[queueCreateInfoCount++];
+			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueCreateInfo.queueFamilyIndex = family.value();
+			queueCreateInfo.queueCount = 1;
+			queueCreateInfo.pQueuePriorities = &queuePriority;
+		}
+
+		// gpfoCX̋@\(͓ɂȂ)
+		VkPhysicalDeviceFeatures deviceFeatures = {};
+
+		VkDeviceCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pQueueCreateInfos = queueCreateInfos;
+		createInfo.queueCreateInfoCount = queueCreateInfoCount;
+		createInfo.pEnabledFeatures = &deviceFeatures;
+
+		// ΉĂΎgg(@\̍\̂́AΉĂ̂ pNext Ɍq)
+		ScratchScope scratch;
+		ExtensionNegotiator negotiator = ExtensionNegotiator::forDevice(scratch, physicalDevice);
+		negotiator.request(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, ExtensionNegotiator::Requirement::Optional);
+
+		// ^CCZ}tH͊gĂ@\ƂđΉĂ邩mFĂLɂ
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+		negotiator.request(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, ExtensionNegotiator::Requirement::Optional, {},
+			&timelineFeatures, &VkPhysicalDeviceTimelineSemaphoreFeaturesKHR::timelineSemaphore);
+
+		negotiator.negotiate();
+		enabled->memoryBudget = negotiator.enabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		enabled->timelineSemaphore = negotiator.enabled(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+		createInfo.pNext = negotiator.featureChain();
+		createInfo.enabledExtensionCount = negotiator.extensionCount();
+		createInfo.ppEnabledExtensionNames = negotiator.extensionNames();
+#ifdef _DEBUG
+		negotiator.report(std::cout, "device extensions");
+#endif // _DEBUG
+
+		VkDevice device;
+		if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create logical device!");
+		}
+
+		vkGetDeviceQueue(device, capabilities.graphicsFamily.value(), 0, graphicsQueue);
+		*computeQueue = VK_NULL_HANDLE;
+		if (capabilities.hasAsyncCompute()) vkGetDeviceQueue(device, capabilities.asyncComputeFamily.value(), 0, computeQueue);
+
+		return device;
+	}
+
+	/*** pCvCLbV ***/
+	// Oۑf[^΁Alɂč쐬
+	static VkPipelineCache createPipelineCache(VkDevice device, VkPhysicalDevice physicalDevice)
+	{
+		std::vector<char> data;
+		std::ifstream file(PIPELINE_CACHE_FILE, std::ios::binary);
+		if (file) {
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+
+		// ʂGPUhCoŕۑꂽf[^͎gȂ̂Ŏ̂Ă
+		if (!isPipelineCacheCompatible(data, physicalDevice)) data.clear();
+
+		VkPipelineCacheCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		VkPipelineCache pipelineCache;
+		if (vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline cache!");
+		}
+		return pipelineCache;
+	}
+
+	// LbVf[^̃wb_[(VkPipelineCacheHeaderVersionOne)̃foCXƈv邩mF
+	static bool isPipelineCacheCompatible(const std::vector<char>& data, VkPhysicalDevice physicalDevice)
+	{
+		const size_t HEADER_SIZE = 16 + VK_UUID_SIZE;
+		if (data.size() < HEADER_SIZE) return false;
+
+		uint32_t header[4];// , o[W, x_[ID, foCXID
+		std::memcpy(header, data.data(), sizeof(header));
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		return header[0] == HEADER_SIZE
+			&& header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header[2] == properties.vendorID
+			&& header[3] == properties.deviceID
+			&& std::memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	// ̋NŎg悤Ƀt@C֕ۑ
+	static void savePipelineCache(VkDevice device, VkPipelineCache pipelineCache)
+	{
+		size_t size = 0;
+		if (vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0) return;
+
+		std::vector<char> data(size);
+		if (vkGetPipelineCacheData(device, pipelineCache, &size, data.data()) != VK_SUCCESS) return;
+
+		std::ofstream file(PIPELINE_CACHE_FILE, std::ios::binary);
+		file.write(data.data(), static_cast<std::streamsize>(size));
+	}
+
 	/*** debugMessenger ̏ ***/
 	// 
-	static void initializeDebugMessenger(VkInstance& instance, VkDebugUtilsMessengerEXT& debugMessenger)
+	static UniqueDebugMessenger initializeDebugMessenger(VkInstance instance, DebugMessageHandlers* debugMessageHandlers)
 	{
-		if (!enableValidationLayers) return;
+		if (!enableValidationLayers) return UniqueDebugMessenger();
 
-		VkDebugUtilsMessengerCreateInfoEXT createInfo = populateDebugMessengerCreateInfo();// ̍\z
+		VkDebugUtilsMessengerCreateInfoEXT createInfo = populateDebugMessengerCreateInfo(debugMessageHandlers);// ̍\z
 
+		VkDebugUtilsMessengerEXT debugMessenger;
 		if (CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS) {// 
 			throw std::runtime_error("failed to set up debug messenger!");
 		}
+
+		// j̊֐gȂ̂ŁAŎ擾ĈꏏɎ
+		auto destroy = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
+		return UniqueDebugMessenger(instance, debugMessenger, destroy);
 	}
 
-	// debugMessenger ̐̍쐬
-	static VkDebugUtilsMessengerCreateInfoEXT populateDebugMessengerCreateInfo()
+	// debugMessenger ̐̍쐬(debugMessageHandlers ̓R[obN pUserData Ƃēn)
+	static VkDebugUtilsMessengerCreateInfoEXT populateDebugMessengerCreateInfo(DebugMessageHandlers* debugMessageHandlers)
 	{
 		VkDebugUtilsMessengerCreateInfoEXT createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
@@ -318,10 +1236,35 @@ VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;								// 
 			const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
 			void* pUserData) -> VKAPI_ATTR VkBool32
 		{
+			// dvxƂ̃bZ[W𐔂
+			static const MetricsRegistry::Counter messageCounters[] = {
+				MetricsRegistry::instance().counter("vk_validation_messages_total", "Debug messenger messages.", "severity=\"verbose\""),
+				MetricsRegistry::instance().counter("vk_validation_messages_total", "Debug messenger messages.", "severity=\"info\""),
+				MetricsRegistry::instance().counter("vk_validation_messages_total", "Debug messenger messages.", "severity=\"warning\""),
+				MetricsRegistry::instance().counter("vk_validation_messages_total", "Debug messenger messages.", "severity=\"error\""),
+			};
+			if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) messageCounters[3].add();
+			else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) messageCounters[2].add();
+			else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) messageCounters[1].add();
+			else messageCounters[0].add();
+
+			auto handlers = static_cast<DebugMessageHandlers*>(pUserData);
+
+			// ptH[}Xx̓|[gɂ܂Ƃ߁AID Ƃɍŏ 1 񂾂\
+			if (messageType & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) {
+				if (!handlers->performanceLint.record(pCallbackData)) return VK_FALSE;
+				std::cerr << "performance warning: " << pCallbackData->pMessage << std::endl;
+				return VK_FALSE;
+			}
+
+			//  ID ̃bZ[W 1 t[ɉxo\Ȃ
+			if (!handlers->limiter.accept(messageSeverity, pCallbackData)) return VK_FALSE;
+
 			std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
 
 			return VK_FALSE;
 		};
+		createInfo.pUserData = debugMessageHandlers;
 
 		return createInfo;
 	}
@@ -339,13 +1282,14 @@ VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;								// 
 	}
 
 	// Еt
-	static void finalizeDebugMessenger(VkInstance& instance, VkDebugUtilsMessengerEXT& debugMessenger)
+	static void finalizeDebugMessenger(UniqueDebugMessenger& debugMessenger, DebugMessageHandlers& debugMessageHandlers)
 	{
 		if (!enableValidationLayers) return;
 
-		// vkCreateDebugUtilsMessengerEXTɑΉĂ邩mFĎs
-		auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
-		if (func == nullptr) return;
-		func(instance, debugMessenger, nullptr);
+		// bZ[W ID Ƃ̌\AptH[}Xx̃|[go
+		debugMessageHandlers.limiter.printSummary(std::cerr);
+		debugMessageHandlers.performanceLint.writeReport(PERFORMANCE_LINT_FILE);
+
+		debugMessenger.reset();
 	}
 };
\ No newline at end of file
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*** ptH[}Xx̎W ***/
+// VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT ̃bZ[W𑼂ƈꏏɕ\̂ł͂ȂA
+// ID Ƃɂ܂Ƃ߁A֌WIuWFNg̖O(vkSetDebugUtilsObjectNameEXT ŕt)
+// t[L^āA\|[gƂďoB
+// x[XC(m̌ẍꗗ)ƔׂĐVx΁ACI ŎsB
+
+class PerformanceLintCollector
+{
+private:
+	struct Warning
+	{
+		int32_t id = 0;
+		std::string message;		// ŏ̃bZ[W
+		uint64_t count = 0;
+		uint64_t firstFrame = 0;
+		uint64_t lastFrame = 0;
+		std::set<std::string> objects;// ֌WIuWFNg(Ô͌^ƃnh)
+	};
+
+	std::atomic<uint64_t> frame_{ 0 };
+	std::mutex mutex_;
+	std::map<std::string, Warning> warnings_;// L[ pMessageIdName(Δԍ)
+
+	static std::string objectLabel(const VkDebugUtilsObjectNameInfoEXT& object)
+	{
+		if (object.pObjectName != nullptr) return object.pObjectName;
+		return "type" + std::to_string(object.objectType) + ":0x" + toHex(object.objectHandle);
+	}
+
+	static std::string toHex(uint64_t value)
+	{
+		const char* DIGITS = "0123456789abcdef";
+		std::string result;
+		do {
+			result.insert(result.begin(), DIGITS[value & 0xf]);
+			value >>= 4;
+		} while (value != 0);
+		return result;
+	}
+
+	static std::string escapeJson(const std::string& text)
+	{
+		std::string result;
+		for (char c : text) {
+			switch (c) {
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) result += ' ';
+				else result += c;
+			}
+		}
+		return result;
+	}
+
+public:
+	// t[̏߂ɌĂŁAL^t[ԍXV
+	void setFrame(uint64_t frame) { frame_.store(frame, std::memory_order_relaxed); }
+
+	// ptH[}XxL^B ID ̏߂Ă̌xȂ true
+	bool record(const VkDebugUtilsMessengerCallbackDataEXT* data)
+	{
+		std::string key = data->pMessageIdName != nullptr ? data->pMessageIdName : std::to_string(data->messageIdNumber);
+		uint64_t frame = frame_.load(std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		Warning& warning = warnings_[key];
+		bool first = warning.count == 0;
+		if (first) {
+			warning.id = data->messageIdNumber;
+			warning.message = data->pMessage != nullptr ? data->pMessage : "";
+			warning.firstFrame = frame;
+		}
+		warning.count++;
+		warning.lastFrame = frame;
+		for (uint32_t i = 0; i < data->objectCount; i++) {
+			warning.objects.insert(objectLabel(data->pObjects[i]));
+		}
+		return first;
+	}
+
+	// JSON ̃|[go
+	bool writeReport(const std::string& path)
+	{
+		std::ofstream out(path, std::ios::trunc);
+		if (!out) return false;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		out << "{\n  \"frames\": " << frame_.load(std::memory_order_relaxed) << ",\n  \"warnings\": [";
+		bool firstWarning = true;
+		for (const auto& [name, warning] : warnings_) {
+			out << (firstWarning ? "\n" : ",\n");
+			firstWarning = false;
+			out << "    {\n"
+				<< "      \"name\": \"" << escapeJson(name) << "\",\n"
+				<< "      \"id\": " << warning.id << ",\n"
+				<< "      \"count\": " << warning.count << ",\n"
+				<< "      \"firstFrame\": " << warning.firstFrame << ",\n"
+				<< "      \"lastFrame\": " << warning.lastFrame << ",\n"
+				<< "      \"objects\": [";
+			bool firstObject = true;
+			for (const std::string& object : warning.objects) {
+				out << (firstObject ? "" : ", ") << "\"" << escapeJson(object) << "\"";
+				firstObject = false;
+			}
+			out << "],\n"
+				<< "      \"message\": \"" << escapeJson(warning.message) << "\"\n"
+				<< "    }";
+		}
+		out << "\n  ]\n}\n";
+		return true;
+	}
+
+	// x[XCɖx̖OԂ
+	// x[XC 1 s 1 x̖OeLXg('#' n܂s̓Rg)
+	// ǂ߂ȂΗO𓊂(SĂ̌xVƂ݂Ȃ̂łÂłȂAQ[gs)
+	std::vector<std::string> findNewWarnings(const std::string& baselinePath)
+	{
+		std::set<std::string> known;
+		std::ifstream in(baselinePath);
+		if (!in) throw std::runtime_error("failed to open performance baseline " + baselinePath + " !");
+		std::string line;
+		while (std::getline(in, line)) {
+			while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+			if (!line.empty() && line[0] != '#') known.insert(line);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::vector<std::string> result;
+		for (const auto& [name, warning] : warnings_) {
+			if (known.count(name) == 0) result.push_back(name);
+		}
+		return result;
+	}
+
+	size_t warningCount()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return warnings_.size();
+	}
+};
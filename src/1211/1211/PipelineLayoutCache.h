@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "DebugLabels.h"
+#include "SpirvReflection.h"
+#include "VulkanHandle.h"
+
+/*** pCvCCAEg̎ƋL ***/
+// VF[_[̃tNV(SpirvReflection.h)AgĂ̂̃fXNv^ZbgCAEg
+// vbV萔͈̔͂BẽCAEg 1 āApCvC̊ԂŋLB
+// LĂ̂ŁAōCAEg͔jȂ(LbVjƂɂ܂Ƃ߂Ĕj)B
+//   ShaderReflection reflection = SpirvReflector::reflect(vertexCode);
+//   reflection.merge(SpirvReflector::reflect(fragmentCode));
+//   const PipelineLayoutCache::Layout& layout = layouts.get(reflection);
+
+class PipelineLayoutCache
+{
+public:
+	struct Layout
+	{
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSetLayout> setLayouts;	// set ԍ̏(gĂȂ set ͋̃CAEg)
+		VkPushConstantRange pushConstantRange = {};		// size  0 ȂvbV萔͖
+	};
+
+private:
+	// oCfBO̓e(fXNv^ZbgCAEg̃L[)
+	using SetKey = std::vector<uint64_t>;
+	// ZbgCAEgƃvbV萔͈̔(pCvCCAEg̃L[)
+	using LayoutKey = std::vector<uint64_t>;
+
+	VkDevice device_ = VK_NULL_HANDLE;
+	std::map<SetKey, UniqueDescriptorSetLayout> setLayouts_;
+	std::map<LayoutKey, std::pair<UniquePipelineLayout, Layout>> layouts_;
+
+public:
+	void initialize(VkDevice device) { device_ = device; }
+
+	// CAEggpCvCSĔjĂĂԂ
+	void clear()
+	{
+		layouts_.clear();
+		setLayouts_.clear();
+	}
+
+	// reflection ɍCAEgԂ(΍)
+	const Layout& get(const ShaderReflection& reflection)
+	{
+		// set ƂɃoCfBO𕪂
+		uint32_t setCount = 0;
+		for (const ReflectedBinding& binding : reflection.bindings) setCount = std::max(setCount, binding.set + 1);
+		std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets(setCount);
+		for (const ReflectedBinding& binding : reflection.bindings) {
+			VkDescriptorSetLayoutBinding layoutBinding = {};
+			layoutBinding.binding = binding.binding;
+			layoutBinding.descriptorType = binding.descriptorType;
+			layoutBinding.descriptorCount = binding.descriptorCount;
+			layoutBinding.stageFlags = binding.stageFlags;
+			sets[binding.set].push_back(layoutBinding);
+		}
+
+		Layout layout;
+		LayoutKey layoutKey;
+		for (const std::vector<VkDescriptorSetLayoutBinding>& bindings : sets) {
+			VkDescriptorSetLayout setLayout = getSetLayout(bindings);
+			layout.setLayouts.push_back(setLayout);
+			layoutKey.push_back((uint64_t)(setLayout));
+		}
+		if (0 < reflection.pushConstantSize) {
+			layout.pushConstantRange = { reflection.stageFlags, 0, reflection.pushConstantSize };
+		}
+		layoutKey.push_back(layout.pushConstantRange.stageFlags);
+		layoutKey.push_back(layout.pushConstantRange.size);
+
+		auto found = layouts_.find(layoutKey);
+		if (found != layouts_.end()) return found->second.second;
+
+		VkPipelineLayoutCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		createInfo.setLayoutCount = static_cast<uint32_t>(layout.setLayouts.size());
+		createInfo.pSetLayouts = layout.setLayouts.data();
+		createInfo.pushConstantRangeCount = layout.pushConstantRange.size == 0 ? 0 : 1;
+		createInfo.pPushConstantRanges = &layout.pushConstantRange;
+
+		VkPipelineLayout pipelineLayout;
+		if (vkCreatePipelineLayout(device_, &createInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+		layout.pipelineLayout = pipelineLayout;
+		DEBUG_NAME(device_, pipelineLayout, "reflected pipeline layout");
+
+		auto& entry = layouts_[layoutKey];
+		entry.first = UniquePipelineLayout(device_, pipelineLayout, vkDestroyPipelineLayout);
+		entry.second = std::move(layout);
+		return entry.second;
+	}
+
+	size_t setLayoutCount() const { return setLayouts_.size(); }
+	size_t pipelineLayoutCount() const { return layouts_.size(); }
+
+private:
+	VkDescriptorSetLayout getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	{
+		SetKey key;
+		for (const VkDescriptorSetLayoutBinding& binding : bindings) {
+			key.push_back((uint64_t(binding.binding) << 32) | uint32_t(binding.descriptorType));
+			key.push_back((uint64_t(binding.descriptorCount) << 32) | binding.stageFlags);
+		}
+
+		auto found = setLayouts_.find(key);
+		if (found != setLayouts_.end()) return found->second.get();
+
+		VkDescriptorSetLayoutCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		createInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout setLayout;
+		if (vkCreateDescriptorSetLayout(device_, &createInfo, nullptr, &setLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create descriptor set layout!");
+		}
+		setLayouts_[key] = UniqueDescriptorSetLayout(device_, setLayout, vkDestroyDescriptorSetLayout);
+		DEBUG_NAME(device_, setLayout, "reflected descriptor set layout");
+		return setLayout;
+	}
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "GpuTimeline.h"
+#include "VulkanHandle.h"
+
+/*** VF[_[̃p[~e[V(ꉻ萔ɂhpCvC)̊Ǘ ***/
+// vvZbTŃVF[_[𕪊򂳂ƁAgݍ킹̐ SPIR-V łĂ܂B
+// ł 1  SPIR-V  VkSpecializationInfo œꉻAKvɂȂgݍ킹
+// pCvC쐬(GpuCompute  LightClusterer ̓[NO[v̌`Ō߂)B
+
+// ꉻ萔 1 Ԃ̒`(VF[_[ constant_id ƌ^)
+template <uint32_t ID, typename T>
+struct SpecConstant
+{
+	static_assert(sizeof(T) == 4 || sizeof(T) == 8, "specialization constants must be 32 or 64 bit");
+	static_assert(std::is_trivially_copyable_v<T>, "specialization constants must be trivially copyable");
+
+	static constexpr uint32_t id = ID;
+	using type = T;
+};
+
+// ꉻ萔̑gݍ킹\L[(^Œ萔̕тRpCɌ߂)
+template <typename... Constants>
+class PermutationKey
+{
+public:
+	static constexpr size_t COUNT = sizeof...(Constants);
+	static constexpr size_t DATA_SIZE = (sizeof(typename Constants::type) + ... + 0);
+
+private:
+	// e萔̃f[^ł̃ItZbg
+	static constexpr std::array<uint32_t, COUNT> offsets()
+	{
+		std::array<uint32_t, COUNT> result = {};
+		constexpr size_t sizes[] = { sizeof(typename Constants::type)..., 0 };
+		uint32_t offset = 0;
+		for (size_t i = 0; i < COUNT; i++) {
+			result[i] = offset;
+			offset += static_cast<uint32_t>(sizes[i]);
+		}
+		return result;
+	}
+
+	// 萔̌^ev[g̈ʒu߂
+	template <typename C>
+	static constexpr size_t indexOf()
+	{
+		constexpr bool matches[] = { std::is_same_v<C, Constants>..., false };
+		for (size_t i = 0; i < COUNT; i++) {
+			if (matches[i]) return i;
+		}
+		return COUNT;
+	}
+
+	static inline const std::array<VkSpecializationMapEntry, COUNT> mapEntries_ = [] {
+		constexpr auto offs = offsets();
+		constexpr uint32_t ids[] = { Constants::id..., 0 };
+		constexpr size_t sizes[] = { sizeof(typename Constants::type)..., 0 };
+		std::array<VkSpecializationMapEntry, COUNT> entries = {};
+		for (size_t i = 0; i < COUNT; i++) {
+			entries[i] = { ids[i], offs[i], sizes[i] };
+		}
+		return entries;
+	}();
+
+	std::array<unsigned char, DATA_SIZE> data_ = {};
+
+public:
+	template <typename C>
+	PermutationKey& set(typename C::type value)
+	{
+		constexpr size_t index = indexOf<C>();
+		static_assert(index < COUNT, "constant is not part of this permutation key");
+		std::memcpy(data_.data() + offsets()[index], &value, sizeof(value));
+		return *this;
+	}
+
+	template <typename C>
+	typename C::type get() const
+	{
+		constexpr size_t index = indexOf<C>();
+		static_assert(index < COUNT, "constant is not part of this permutation key");
+		typename C::type value;
+		std::memcpy(&value, data_.data() + offsets()[index], sizeof(value));
+		return value;
+	}
+
+	// pCvC쐬ɓnꉻ(L[ĂԂL)
+	VkSpecializationInfo specializationInfo() const
+	{
+		VkSpecializationInfo info = {};
+		info.mapEntryCount = static_cast<uint32_t>(COUNT);
+		info.pMapEntries = mapEntries_.data();
+		info.dataSize = DATA_SIZE;
+		info.pData = data_.data();
+		return info;
+	}
+
+	// FNV-1a Ńf[^nbV
+	size_t hash() const
+	{
+		uint64_t h = 14695981039346656037ull;
+		for (unsigned char c : data_) {
+			h ^= c;
+			h *= 1099511628211ull;
+		}
+		return static_cast<size_t>(h);
+	}
+
+	bool operator==(const PermutationKey& other) const { return data_ == other.data_; }
+	bool operator!=(const PermutationKey& other) const { return !(*this == other); }
+};
+
+// p[~e[VƂ̃pCvCKvɉč쐬AgȂȂ̂ LRU Ŕj
+// ǂopCvĆAL^̂̂܂߂ timeline ɑI܂ DeletionQueue ŗaĂj
+template <typename Key>
+class PipelinePermutationCache
+{
+public:
+	// ꉻ񂩂pCvC쐬֐(nꂽpCvCLbVgč쐬邱)
+	using Factory = std::function<VkPipeline(VkDevice, VkPipelineCache, const VkSpecializationInfo&)>;
+
+private:
+	struct Entry
+	{
+		Key key;
+		UniquePipeline pipeline;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const { return key.hash(); }
+	};
+
+	VkDevice device_ = VK_NULL_HANDLE;
+	VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+	QueueTimeline* timeline_ = nullptr;// pCvCg𑗂L[̂
+	Factory factory_;
+
+	size_t capacity_;// ێpCvC̏(łgĂȂ̂ǂo)
+
+	std::list<Entry> entries_;// 擪قǍŋߎgꂽ
+	std::unordered_map<Key, typename std::list<Entry>::iterator, KeyHash> index_;
+	DeletionQueue retired_;// ǂo(timeline_ ̒lŊǗ)
+
+public:
+	explicit PipelinePermutationCache(size_t capacity) : capacity_(capacity) {}
+	~PipelinePermutationCache() { clear(); }
+
+	PipelinePermutationCache(const PipelinePermutationCache&) = delete;
+	PipelinePermutationCache& operator=(const PipelinePermutationCache&) = delete;
+
+	void initialize(VkDevice device, VkPipelineCache pipelineCache, QueueTimeline* timeline, Factory factory)
+	{
+		device_ = device;
+		pipelineCache_ = pipelineCache;
+		timeline_ = timeline;
+		factory_ = std::move(factory);
+	}
+
+	// pCvC̎擾(΍쐬A𒴂Â̂ǂo)
+	VkPipeline get(const Key& key)
+	{
+		if (0 < retired_.size()) retired_.collect(timeline_->completedValue());
+
+		auto found = index_.find(key);
+		if (found != index_.end()) {
+			entries_.splice(entries_.begin(), entries_, found->second);// 擪ֈړ
+			return found->second->pipeline.get();
+		}
+
+		VkSpecializationInfo specialization = key.specializationInfo();
+		VkPipeline pipeline = factory_(device_, pipelineCache_, specialization);
+		if (pipeline == VK_NULL_HANDLE) {
+			throw std::runtime_error("failed to create pipeline permutation!");
+		}
+
+		entries_.push_front({ key, UniquePipeline(device_, pipeline, vkDestroyPipeline) });
+		index_.emplace(key, entries_.begin());
+		while (capacity_ < entries_.size()) {
+			// L^̃R}hobt@ŎgĂ邩Ȃ̂ŁAɑ鏈I܂ő҂
+			retired_.defer(timeline_->submittedValue() + 1, std::move(entries_.back().pipeline));
+			index_.erase(entries_.back().key);
+			entries_.pop_back();
+		}
+		return pipeline;
+	}
+
+	// factory ւAĂpCvC͑S queue ɗa retireValue ܂Őiłj(VF[_[蒼ƂȂ)
+	// key ̂̂V factory Őɍ̂ŁAȂΉςɗO𓊂
+	void reload(Factory factory, const Key& key, DeletionQueue& queue, uint64_t retireValue)
+	{
+		VkSpecializationInfo specialization = key.specializationInfo();
+		VkPipeline pipeline = factory(device_, pipelineCache_, specialization);
+		if (pipeline == VK_NULL_HANDLE) {
+			throw std::runtime_error("failed to create pipeline permutation!");
+		}
+		UniquePipeline created(device_, pipeline, vkDestroyPipeline);
+
+		for (Entry& entry : entries_) queue.defer(retireValue, std::move(entry.pipeline));
+		index_.clear();
+		entries_.clear();
+		factory_ = std::move(factory);
+		entries_.push_front({ key, std::move(created) });
+		index_.emplace(key, entries_.begin());
+	}
+
+	// SĔj(GPU ̏IĂĂԂ)
+	void clear()
+	{
+		retired_.flush();
+		index_.clear();
+		entries_.clear();
+	}
+
+	size_t size() const { return entries_.size(); }
+};
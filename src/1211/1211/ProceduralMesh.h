@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/*** vZō郁bV ***/
+// AZbgǂݍގdg݂ł܂ŁALOD Xg[~O߂ɎgB
+//   MeshVertex* vertices = ...; uint32_t* indices = ...;
+//   ProceduralMesh::sphere(32, 0.5f, vertices, indices);
+
+struct MeshVertex
+{
+	float position[3];
+	float normal[3];
+};
+
+namespace ProceduralMesh
+{
+	// ox segmentsAܓx segments / 2 ɕ
+	inline uint32_t sphereVertexCount(uint32_t segments) { return (segments + 1) * (segments / 2 + 1); }
+	inline uint32_t sphereIndexCount(uint32_t segments) { return segments * (segments / 2) * 6; }
+
+	// p`ŋߎƂ́A{̋ʂ̍ő̂(ӂ̒_܂ł̋̍)
+	inline float sphereError(uint32_t segments, float radius) { return radius * (1.0f - std::cos(3.14159265f / segments)); }
+
+	inline void sphere(uint32_t segments, float radius, MeshVertex* vertices, uint32_t* indices)
+	{
+		const float PI = 3.14159265f;
+		uint32_t rings = segments / 2;
+		for (uint32_t ring = 0; ring <= rings; ring++) {
+			float phi = PI * ring / rings;
+			for (uint32_t segment = 0; segment <= segments; segment++) {
+				float theta = 2.0f * PI * segment / segments;
+				float normal[3] = { std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta) };
+				MeshVertex& vertex = *vertices++;
+				for (int i = 0; i < 3; i++) {
+					vertex.position[i] = normal[i] * radius;
+					vertex.normal[i] = normal[i];
+				}
+			}
+		}
+		for (uint32_t ring = 0; ring < rings; ring++) {
+			for (uint32_t segment = 0; segment < segments; segment++) {
+				uint32_t a = ring * (segments + 1) + segment;
+				uint32_t b = a + segments + 1;
+				uint32_t quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+				for (uint32_t index : quad) *indices++ = index;
+			}
+		}
+	}
+}
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/*** ꎞIȃ̊m ***/
+// ScratchAllocator ̓XbhƂ̐`AP[^Bmۂ͐擪炷ŁA ScratchScope 𔲂Ƃ
+// ܂Ƃ߂Ċ߂Bt[̏N̗񋓂ȂǁA֐̒ŎgzɎgB
+// ̈悪ȂȂq[vǉŊmۂASĊ߂ƂɎ͂̕傫ɂ
+// (Ȃ̂œJԂĂ΁A2 ڂ̓q[vgȂ)B
+//   ScratchScope scratch;
+//   ScratchArray<VkQueueFamilyProperties> families = scratch.allocate<VkQueueFamilyProperties>(count);
+//
+// SmallVector ́AN ܂ł͎̒ɎA𒴂Ƃq[vgz(߂lɂg)B
+// ǂfXgN^Ă΂Ȃ̂ŁAVulkan ̍\̂nĥ悤ȁÂ܂܃Rs[ł^B
+
+class ScratchAllocator
+{
+private:
+	static constexpr size_t INITIAL_CAPACITY = 256 * 1024;
+
+	std::unique_ptr<unsigned char[]> block_;
+	size_t capacity_ = 0;
+	size_t used_ = 0;
+	std::vector<std::unique_ptr<unsigned char[]>> overflow_;// block_ ɓ肫Ȃ
+	size_t overflowBytes_ = 0;
+
+public:
+	// ĂяoXbh̃AP[^
+	static ScratchAllocator& forThread()
+	{
+		thread_local ScratchAllocator allocator;
+		return allocator;
+	}
+
+	ScratchAllocator() = default;
+	ScratchAllocator(const ScratchAllocator&) = delete;
+	ScratchAllocator& operator=(const ScratchAllocator&) = delete;
+
+	struct Marker
+	{
+		size_t used;
+		size_t overflowCount;
+	};
+
+	Marker mark() const { return { used_, overflow_.size() }; }
+
+	void rewind(const Marker& marker)
+	{
+		used_ = marker.used;
+		if (marker.overflowCount < overflow_.size()) overflow_.resize(marker.overflowCount);
+
+		// SĊ߂Aꂽ悤ɍLĂ
+		if (used_ == 0 && overflow_.empty() && 0 < overflowBytes_) {
+			reserve(capacity_ + overflowBytes_);
+			overflowBytes_ = 0;
+		}
+	}
+
+	void* allocate(size_t size, size_t alignment)
+	{
+		if (!block_) reserve(INITIAL_CAPACITY);
+
+		size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+		if (offset + size <= capacity_) {
+			used_ = offset + size;
+			return block_.get() + offset;
+		}
+
+		// Ȃ̓q[vmۂ(new[]  max_align_t ܂łȂ̂ŁA̕]Ɏ)
+		size_t padding = alignment <= alignof(std::max_align_t) ? 0 : alignment;
+		overflow_.push_back(std::make_unique<unsigned char[]>(size + padding));
+		overflowBytes_ += size + alignment;
+		void* pointer = overflow_.back().get();
+		size_t space = size + padding;
+		return std::align(alignment, size, pointer, space);
+	}
+
+	size_t used() const { return used_; }
+	size_t capacity() const { return capacity_; }
+
+private:
+	void reserve(size_t capacity)
+	{
+		if (capacity <= capacity_) return;
+		if (used_ != 0) throw std::runtime_error("scratch allocator cannot grow while in use!");
+		block_ = std::make_unique<unsigned char[]>(capacity);
+		capacity_ = capacity;
+	}
+};
+
+// ScratchScope Ŋmۂz(XR[v𔲂ƖɂȂ)
+template <typename T>
+class ScratchArray
+{
+private:
+	T* data_ = nullptr;
+	size_t size_ = 0;
+
+public:
+	ScratchArray() = default;
+	ScratchArray(T* data, size_t size) : data_(data), size_(size) {}
+
+	T* data() { return data_; }
+	const T* data() const { return data_; }
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	T& operator[](size_t index) { return data_[index]; }
+	const T& operator[](size_t index) const { return data_[index]; }
+
+	T* begin() { return data_; }
+	T* end() { return data_ + size_; }
+	const T* begin() const { return data_; }
+	const T* end() const { return data_ + size_; }
+};
+
+// Ă󂷂܂ł̊ԂɊmۂ̂A܂Ƃ߂ĉ
+class ScratchScope
+{
+private:
+	ScratchAllocator& allocator_;
+	ScratchAllocator::Marker marker_;
+
+public:
+	explicit ScratchScope(ScratchAllocator& allocator = ScratchAllocator::forThread())
+		: allocator_(allocator), marker_(allocator.mark()) {}
+	~ScratchScope() { allocator_.rewind(marker_); }
+
+	ScratchScope(const ScratchScope&) = delete;
+	ScratchScope& operator=(const ScratchScope&) = delete;
+
+	// 0 ŏ count ̔z
+	template <typename T>
+	ScratchArray<T> allocate(size_t count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+			"scratch arrays only hold trivially copyable types");
+		if (count == 0) return ScratchArray<T>();
+		void* memory = allocator_.allocate(sizeof(T) * count, alignof(T));
+		std::memset(memory, 0, sizeof(T) * count);
+		return ScratchArray<T>(static_cast<T*>(memory), count);
+	}
+};
+
+template <typename T, size_t N>
+class SmallVector
+{
+	static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+		"SmallVector only holds trivially copyable types");
+
+private:
+	alignas(T) unsigned char inline_[sizeof(T) * N];
+	std::unique_ptr<T[]> heap_;
+	T* data_ = reinterpret_cast<T*>(inline_);
+	size_t size_ = 0;
+	size_t capacity_ = N;
+
+public:
+	SmallVector() = default;
+	SmallVector(std::initializer_list<T> values)
+	{
+		reserve(values.size());
+		for (const T& value : values) data_[size_++] = value;
+	}
+
+	SmallVector(const SmallVector& other) { *this = other; }
+	SmallVector& operator=(const SmallVector& other)
+	{
+		if (this == &other) return *this;
+		size_ = 0;
+		reserve(other.size_);
+		std::memcpy(static_cast<void*>(data_), other.data_, sizeof(T) * other.size_);
+		size_ = other.size_;
+		return *this;
+	}
+
+	SmallVector(SmallVector&& other) noexcept { *this = std::move(other); }
+	SmallVector& operator=(SmallVector&& other) noexcept
+	{
+		if (this == &other) return *this;
+		if (other.heap_) {
+			heap_ = std::move(other.heap_);
+			data_ = heap_.get();
+			capacity_ = other.capacity_;
+		}
+		else {
+			heap_.reset();
+			data_ = reinterpret_cast<T*>(inline_);
+			capacity_ = N;
+			std::memcpy(static_cast<void*>(data_), other.data_, sizeof(T) * other.size_);
+		}
+		size_ = other.size_;
+		other.data_ = reinterpret_cast<T*>(other.inline_);
+		other.size_ = 0;
+		other.capacity_ = N;
+		return *this;
+	}
+
+	T* data() { return data_; }
+	const T* data() const { return data_; }
+	size_t size() const { return size_; }
+	size_t capacity() const { return capacity_; }
+	bool empty() const { return size_ == 0; }
+
+	T& operator[](size_t index) { return data_[index]; }
+	const T& operator[](size_t index) const { return data_[index]; }
+	T& back() { return data_[size_ - 1]; }
+
+	T* begin() { return data_; }
+	T* end() { return data_ + size_; }
+	const T* begin() const { return data_; }
+	const T* end() const { return data_ + size_; }
+
+	void push_back(const T& value)
+	{
+		if (size_ == capacity_) reserve(capacity_ * 2);
+		data_[size_++] = value;
+	}
+
+	//  0 ŏ
+	void resize(size_t size)
+	{
+		reserve(size);
+		if (size_ < size) std::memset(static_cast<void*>(data_ + size_), 0, sizeof(T) * (size - size_));
+		size_ = size;
+	}
+
+	void clear() { size_ = 0; }
+
+	void reserve(size_t capacity)
+	{
+		if (capacity <= capacity_) return;
+		std::unique_ptr<T[]> heap(new T[capacity]);
+		std::memcpy(static_cast<void*>(heap.get()), data_, sizeof(T) * size_);
+		heap_ = std::move(heap);
+		data_ = heap_.get();
+		capacity_ = capacity;
+	}
+};
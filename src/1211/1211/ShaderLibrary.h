@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "VulkanHandle.h"
+
+/*** RpCς݃VF[_[̓ǂݍ ***/
+// VF[_[̓rhO compile_shaders.py  shaders/  shaders/bin/<O>.<Xe[W>.spv ɃRpCĂ
+// (1211.vcxproj ̃rhOCxgŎsĂ)B
+// sɃVF[_[𒼂Ƃ compile() œXNvgĂŃRpCB
+// LbV̂ŁAςVF[_[RpCB
+//   ShaderLibrary shaders("shaders", "shaders/bin");
+//   UniqueShaderModule module = shaders.createModule(device, "blur.comp");
+
+class ShaderLibrary
+{
+private:
+	std::filesystem::path sourceDirectory_;
+	std::filesystem::path binaryDirectory_;
+	std::filesystem::file_time_type lastChange_{};// ŌɒׂƂ́AVF[_[̈ԐVXV
+
+public:
+	ShaderLibrary(const std::filesystem::path& sourceDirectory, const std::filesystem::path& binaryDirectory)
+		: sourceDirectory_(sourceDirectory), binaryDirectory_(binaryDirectory)
+	{
+		lastChange_ = newestSourceTime();
+	}
+
+	// name ͊gq(.spv)O(: "blur.comp")
+	std::vector<uint32_t> loadSpirv(const std::string& name) const
+	{
+		std::filesystem::path path = binaryDirectory_ / (name + ".spv");
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file) {
+			throw std::runtime_error("failed to open shader " + path.string() + " !");
+		}
+
+		std::streamsize size = file.tellg();
+		if (size <= 0 || size % sizeof(uint32_t) != 0) {
+			throw std::runtime_error("invalid SPIR-V file " + path.string() + " !");
+		}
+		std::vector<uint32_t> code(static_cast<size_t>(size) / sizeof(uint32_t));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(code.data()), size);
+		return code;
+	}
+
+	UniqueShaderModule createModule(VkDevice device, const std::string& name) const
+	{
+		return createModule(device, loadSpirv(name));
+	}
+
+	// ǂݍݍς݂ SPIR-V (tNVɂgƂȂ)
+	static UniqueShaderModule createModule(VkDevice device, const std::vector<uint32_t>& code)
+	{
+		VkShaderModuleCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.size() * sizeof(uint32_t);
+		createInfo.pCode = code.data();
+
+		VkShaderModule module;
+		if (vkCreateShaderModule(device, &createInfo, nullptr, &module) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shader module!");
+		}
+		return UniqueShaderModule(device, module, vkDestroyShaderModule);
+	}
+
+	// O񒲂ׂƂVF[_[̃\[XςĂ true(zbg[hp)
+	bool sourcesChanged()
+	{
+		std::filesystem::file_time_type newest = newestSourceTime();
+		if (newest <= lastChange_) return false;
+		lastChange_ = newest;
+		return true;
+	}
+
+	// compile_shaders.py săRpC(s falseBG[͕WG[o͂ɏo)
+	bool compile(bool debug) const
+	{
+#ifdef _WIN32
+		std::string python = "py -3";
+#else
+		std::string python = "python3";
+#endif
+		std::string command = python + " compile_shaders.py \"" + sourceDirectory_.string() + "\" \"" + binaryDirectory_.string() + "\"";
+		if (debug) command += " --debug";
+		return std::system(command.c_str()) == 0;
+	}
+
+private:
+	std::filesystem::file_time_type newestSourceTime() const
+	{
+		std::filesystem::file_time_type newest{};
+		std::error_code error;
+		if (!std::filesystem::is_directory(sourceDirectory_, error)) return newest;
+
+		for (auto it = std::filesystem::recursive_directory_iterator(sourceDirectory_, error);
+			it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+			if (error) break;
+			std::string name = it->path().filename().string();
+			if (it->is_directory(error) && (name == "bin" || name[0] == '.')) {
+				it.disable_recursion_pending();// o͂ƃLbV͌Ȃ
+				continue;
+			}
+			if (it->is_regular_file(error)) {
+				std::filesystem::file_time_type time = it->last_write_time(error);
+				if (!error && newest < time) newest = time;
+			}
+		}
+		return newest;
+	}
+};
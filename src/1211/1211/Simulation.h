@@ -0,0 +1,143 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "FramePacket.h"
+#include "Input.h"
+
+/*** V~[V ***/
+// V[̏(́ECgEJ)A͂ƌoߎԂ 1 Xebvi߂ FramePacket ɏoB
+// `XbhƂ FramePacket ł肵Ȃ̂ŁAVulkan ̃IuWFNgɂ͐GȂB
+//   Simulation simulation;
+//   simulation.update(deltaSeconds, inputState);
+//   simulation.writePacket(*packet);
+
+class Simulation
+{
+private:
+	struct Object
+	{
+		Float3 position;
+		float angle;			// Y ܂(WA)
+		float angularVelocity;	// WA/b
+		uint32_t mesh;
+		uint32_t material;
+	};
+
+	// ̂̏𐅕ɉ郉Cg
+	struct Light
+	{
+		Float3 center;
+		float orbitRadius;
+		float phase;		// WA
+		float speed;		// WA/b
+		float radius;		// ͂
+		Float3 color;
+	};
+
+	constexpr static float MOVE_SPEED = 4.0f;	// P/b
+	constexpr static float LOOK_SPEED = 0.005f;	// WA/sNZ
+	constexpr static double MAX_STEP = 0.1;		// ~܂Ăɑ傫i݂Ȃ悤ɂ(b)
+
+	std::vector<Object> objects_;
+	std::vector<Light> lights_;
+	Camera camera_{ { 0.0f, 2.0f, -10.0f }, 0.0f, 0.0f, 1.0f, 800.0f / 600.0f, 0.1f, 1000.0f };
+	uint64_t frame_ = 0;
+	double time_ = 0.0;
+
+	// }EXŌ񂷂Ƃ̑ÕJ[\ʒu
+	bool looking_ = false;
+	double lookX_ = 0.0;
+	double lookY_ = 0.0;
+
+public:
+	// ̂ XZ ʂ̊iqɕׂ(bVƃ}eA͐ނɎg)
+	// Cĝ͕̊iq̏ɎU΂点
+	explicit Simulation(uint32_t objectCount = 16384, uint32_t meshCount = 4, uint32_t materialCount = 8, uint32_t lightCount = 1024)
+	{
+		uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+		objects_.reserve(objectCount);
+		for (uint32_t i = 0; i < objectCount; i++) {
+			float x = (static_cast<float>(i % side) - side * 0.5f) * 2.0f;
+			float z = static_cast<float>(i / side) * 2.0f;
+			objects_.push_back({ { x, 0.0f, z }, 0.0f, 0.5f + 0.1f * (i % 7), i % meshCount, i % materialCount });
+		}
+
+		// ̑ɉŎU΂点(񓯂zuɂȂ)
+		const float GOLDEN = 0.618034f;
+		float width = side * 2.0f;
+		lights_.reserve(lightCount);
+		for (uint32_t i = 0; i < lightCount; i++) {
+			float u = std::fmod(i * GOLDEN, 1.0f);
+			float v = (i + 0.5f) / lightCount;
+			Float3 color = { 0.5f + 0.5f * std::cos(6.2831853f * u), 0.5f + 0.5f * std::cos(6.2831853f * (u + 0.33f)),
+				0.5f + 0.5f * std::cos(6.2831853f * (u + 0.67f)) };
+			lights_.push_back({ { (u - 0.5f) * width, 1.0f + (i % 3), v * width }, 1.0f + (i % 5) * 0.5f,
+				6.2831853f * v, 0.2f + 0.1f * (i % 4), 3.0f + (i % 4), color });
+		}
+	}
+
+	uint64_t frame() const { return frame_; }
+
+	void update(double deltaSeconds, const InputState& input)
+	{
+		float dt = static_cast<float>(deltaSeconds < MAX_STEP ? deltaSeconds : MAX_STEP);
+
+		// E{^ĂԂ̓}EXŌς
+		if (input.mouseButtonDown(GLFW_MOUSE_BUTTON_RIGHT)) {
+			if (looking_) {
+				camera_.yaw += static_cast<float>(input.cursorX - lookX_) * LOOK_SPEED;
+				camera_.pitch += static_cast<float>(input.cursorY - lookY_) * LOOK_SPEED;
+				camera_.pitch = std::fmax(-1.5f, std::fmin(1.5f, camera_.pitch));
+			}
+			lookX_ = input.cursorX;
+			lookY_ = input.cursorY;
+		}
+		looking_ = input.mouseButtonDown(GLFW_MOUSE_BUTTON_RIGHT);
+
+		// WASD ŐɈړ
+		float forward = (input.keyDown(GLFW_KEY_W) ? 1.0f : 0.0f) - (input.keyDown(GLFW_KEY_S) ? 1.0f : 0.0f);
+		float right = (input.keyDown(GLFW_KEY_D) ? 1.0f : 0.0f) - (input.keyDown(GLFW_KEY_A) ? 1.0f : 0.0f);
+		float s = std::sin(camera_.yaw);
+		float c = std::cos(camera_.yaw);
+		camera_.position.x += (forward * s + right * c) * MOVE_SPEED * dt;
+		camera_.position.z += (forward * c - right * s) * MOVE_SPEED * dt;
+
+		for (Object& object : objects_) {
+			object.angle = std::fmod(object.angle + object.angularVelocity * dt, 6.2831853f);
+		}
+		for (Light& light : lights_) {
+			light.phase = std::fmod(light.phase + light.speed * dt, 6.2831853f);
+		}
+
+		time_ += dt;
+		frame_++;
+	}
+
+	// ̏Ԃo(Ȃ̂ƃCg͕`Ȃ)
+	void writePacket(FramePacket& packet) const
+	{
+		packet.simulationFrame = frame_;
+		packet.simulationTime = time_;
+		packet.camera = camera_;
+		for (const Object& object : objects_) {
+			float s = std::sin(object.angle);
+			float c = std::cos(object.angle);
+			uint32_t transform = packet.addTransform({ {
+				{ c, 0.0f, s, object.position.x },
+				{ 0.0f, 1.0f, 0.0f, object.position.y },
+				{ -s, 0.0f, c, object.position.z },
+			} });
+			if (transform == UINT32_MAX || !packet.addDraw(object.mesh, object.material, transform)) break;
+		}
+		for (const Light& light : lights_) {
+			Float3 position = { light.center.x + light.orbitRadius * std::cos(light.phase), light.center.y,
+				light.center.z + light.orbitRadius * std::sin(light.phase) };
+			if (!packet.addLight({ position, light.radius, light.color, 1.0f })) break;
+		}
+	}
+};
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*** SPIR-V ̃tNV ***/
+// VF[_[ SPIR-V ǂŁAgĂfXNv^(set, binding, , )ƃvbV萔̑傫𒲂ׂB
+// pCvCCAEgŏɁAŒׂeKvŏ̂̂(PipelineLayoutCache.h)B
+// ΉĂ̂̓pCvCCAEgɕKvȖ߂ŁASPIR-V ̌؂͂ȂB
+
+struct ReflectedBinding
+{
+	uint32_t set = 0;
+	uint32_t binding = 0;
+	VkDescriptorType descriptorType = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+	uint32_t descriptorCount = 1;
+	VkShaderStageFlags stageFlags = 0;
+
+	bool operator<(const ReflectedBinding& other) const
+	{
+		return set != other.set ? set < other.set : binding < other.binding;
+	}
+};
+
+struct ShaderReflection
+{
+	VkShaderStageFlags stageFlags = 0;
+	std::vector<ReflectedBinding> bindings;	// set, binding ̏ɕł
+	uint32_t pushConstantSize = 0;			// 0 ȂvbV萔͎gĂȂ
+	uint32_t localSize[3] = { 1, 1, 1 };	// Rs[gVF[_[̃[NO[v̑傫(LocalSize Ŏw肵Ƃ)
+
+	// ʂ̃Xe[W̃VF[_[Ƃ܂Ƃ߂( set, binding ŎނႦ΃G[)
+	void merge(const ShaderReflection& other)
+	{
+		stageFlags |= other.stageFlags;
+		pushConstantSize = std::max(pushConstantSize, other.pushConstantSize);
+		for (const ReflectedBinding& binding : other.bindings) {
+			auto it = std::lower_bound(bindings.begin(), bindings.end(), binding);
+			if (it != bindings.end() && it->set == binding.set && it->binding == binding.binding) {
+				if (it->descriptorType != binding.descriptorType) {
+					throw std::runtime_error("descriptor type mismatch at set " + std::to_string(binding.set)
+						+ " binding " + std::to_string(binding.binding) + " !");
+				}
+				it->descriptorCount = std::max(it->descriptorCount, binding.descriptorCount);
+				it->stageFlags |= binding.stageFlags;
+			}
+			else {
+				bindings.insert(it, binding);
+			}
+		}
+	}
+};
+
+class SpirvReflector
+{
+private:
+	// g߂ƒl(SPIR-V ̎dl̔ԍ)
+	enum Op : uint32_t {
+		OpEntryPoint = 15, OpExecutionMode = 16,
+		OpTypeInt = 21, OpTypeFloat = 22, OpTypeVector = 23, OpTypeMatrix = 24, OpTypeImage = 25, OpTypeSampler = 26,
+		OpTypeSampledImage = 27, OpTypeArray = 28, OpTypeRuntimeArray = 29, OpTypeStruct = 30, OpTypePointer = 32,
+		OpConstant = 43, OpVariable = 59, OpDecorate = 71, OpMemberDecorate = 72,
+		OpTypeAccelerationStructureKHR = 5341,
+	};
+	enum Decoration : uint32_t { Block = 2, BufferBlock = 3, ArrayStride = 6, MatrixStride = 7, Binding = 33, DescriptorSet = 34, Offset = 35 };
+	enum StorageClass : uint32_t { UniformConstant = 0, Uniform = 2, PushConstant = 9, StorageBuffer = 12 };
+	enum Dim : uint32_t { DimBuffer = 5, DimSubpassData = 6 };
+	static constexpr uint32_t MAGIC = 0x07230203;
+	static constexpr uint32_t ExecutionModeLocalSize = 17;
+
+	struct Id
+	{
+		uint32_t opcode = 0;
+		std::vector<uint32_t> operands;// ʂ ID ̌̃Iyh
+		uint32_t set = UINT32_MAX;
+		uint32_t binding = UINT32_MAX;
+		uint32_t arrayStride = 0;
+		bool block = false;
+		bool bufferBlock = false;
+		std::vector<uint32_t> memberOffsets;
+		std::vector<uint32_t> memberMatrixStrides;
+	};
+
+	std::unordered_map<uint32_t, Id> ids_;
+
+	// `ĂȂ ID ͋̂̂Ԃ(ids_ ɒǉȂ̂ŁAQƂɂȂȂ)
+	const Id& lookup(uint32_t id) const
+	{
+		static const Id EMPTY;
+		auto it = ids_.find(id);
+		return it != ids_.end() ? it->second : EMPTY;
+	}
+
+public:
+	static ShaderReflection reflect(const std::vector<uint32_t>& code)
+	{
+		return reflect(code.data(), code.size());
+	}
+
+	static ShaderReflection reflect(const uint32_t* code, size_t wordCount)
+	{
+		SpirvReflector reflector;
+		return reflector.run(code, wordCount);
+	}
+
+private:
+	ShaderReflection run(const uint32_t* code, size_t wordCount)
+	{
+		if (wordCount < 5 || code[0] != MAGIC) throw std::runtime_error("not a SPIR-V module!");
+
+		ShaderReflection result;
+		std::vector<uint32_t> variables;
+
+		for (size_t i = 5; i < wordCount;) {
+			uint32_t length = code[i] >> 16;
+			uint32_t opcode = code[i] & 0xffff;
+			if (length == 0 || wordCount < i + length) throw std::runtime_error("broken SPIR-V module!");
+			const uint32_t* words = code + i + 1;
+			uint32_t count = length - 1;
+
+			switch (opcode) {
+			case OpEntryPoint:
+				result.stageFlags |= stageFromExecutionModel(words[0]);
+				break;
+			case OpExecutionMode:
+				if (4 <= count && words[1] == ExecutionModeLocalSize) {
+					result.localSize[0] = words[2];
+					result.localSize[1] = words[3];
+					result.localSize[2] = words[4];
+				}
+				break;
+			case OpDecorate:
+				decorate(ids_[words[0]], words[1], 3 <= count ? words[2] : 0);
+				break;
+			case OpMemberDecorate:
+				if (4 <= count) memberDecorate(ids_[words[0]], words[1], words[2], words[3]);
+				break;
+			case OpTypeInt: case OpTypeFloat: case OpTypeVector: case OpTypeMatrix: case OpTypeImage: case OpTypeSampler:
+			case OpTypeSampledImage: case OpTypeArray: case OpTypeRuntimeArray: case OpTypeStruct: case OpTypePointer:
+			case OpTypeAccelerationStructureKHR:
+				if (1 <= count) define(words[0], opcode, words + 1, count - 1);
+				break;
+			case OpConstant:// ʂ̌^, ʂ ID, l
+				if (3 <= count) define(words[1], opcode, words + 2, count - 2);
+				break;
+			case OpVariable:// ʂ̌^, ʂ ID, Xg[WNX
+				if (3 <= count) {
+					define(words[1], opcode, words, 1);
+					ids_[words[1]].operands.push_back(words[2]);
+					variables.push_back(words[1]);
+				}
+				break;
+			}
+			i += length;
+		}
+
+		// \[X̕ϐoCfBO
+		for (uint32_t variable : variables) {
+			const Id& id = lookup(variable);
+			uint32_t storageClass = id.operands[1];
+			const Id& pointer = lookup(id.operands[0]);
+			if (pointer.opcode != OpTypePointer || pointer.operands.size() < 2) continue;
+			uint32_t typeId = pointer.operands[1];
+
+			if (storageClass == PushConstant) {
+				result.pushConstantSize = std::max(result.pushConstantSize, sizeOf(typeId));
+				continue;
+			}
+			if (storageClass != UniformConstant && storageClass != Uniform && storageClass != StorageBuffer) continue;
+			if (id.set == UINT32_MAX || id.binding == UINT32_MAX) continue;
+
+			ReflectedBinding binding;
+			binding.set = id.set;
+			binding.binding = id.binding;
+			binding.descriptorCount = 1;
+
+			// zȂ炻̐fXNv^g
+			const Id* type = &lookup(typeId);
+			while (type->opcode == OpTypeArray || type->opcode == OpTypeRuntimeArray) {
+				if (type->opcode == OpTypeRuntimeArray) {
+					throw std::runtime_error("runtime descriptor arrays are not supported by reflection!");
+				}
+				binding.descriptorCount *= constantValue(type->operands[1]);
+				type = &lookup(type->operands[0]);
+			}
+			binding.descriptorType = descriptorType(*type, storageClass);
+			if (binding.descriptorType == VK_DESCRIPTOR_TYPE_MAX_ENUM) continue;
+
+			result.bindings.push_back(binding);
+		}
+		for (ReflectedBinding& binding : result.bindings) binding.stageFlags = result.stageFlags;// ̃VF[_[̃Xe[WŎg
+		std::sort(result.bindings.begin(), result.bindings.end());
+
+		return result;
+	}
+
+	void define(uint32_t resultId, uint32_t opcode, const uint32_t* operands, uint32_t count)
+	{
+		Id& id = ids_[resultId];
+		id.opcode = opcode;
+		id.operands.assign(operands, operands + count);
+	}
+
+	static void decorate(Id& id, uint32_t decoration, uint32_t value)
+	{
+		switch (decoration) {
+		case Block: id.block = true; break;
+		case BufferBlock: id.bufferBlock = true; break;
+		case ArrayStride: id.arrayStride = value; break;
+		case Binding: id.binding = value; break;
+		case DescriptorSet: id.set = value; break;
+		}
+	}
+
+	static void memberDecorate(Id& id, uint32_t member, uint32_t decoration, uint32_t value)
+	{
+		if (decoration == Offset) {
+			if (id.memberOffsets.size() <= member) id.memberOffsets.resize(member + 1, 0);
+			id.memberOffsets[member] = value;
+		}
+		else if (decoration == MatrixStride) {
+			if (id.memberMatrixStrides.size() <= member) id.memberMatrixStrides.resize(member + 1, 0);
+			id.memberMatrixStrides[member] = value;
+		}
+	}
+
+	uint32_t constantValue(uint32_t constantId) const
+	{
+		const Id& id = lookup(constantId);
+		if (id.opcode != OpConstant || id.operands.empty()) throw std::runtime_error("array length is not a constant!");
+		return id.operands[0];// z̒Ȃ̂ŉ 32bit ő
+	}
+
+	// ^̑傫(vbV萔̃ubN̑傫𒲂ׂ邽߁Bzƍs̓XgChg)
+	uint32_t sizeOf(uint32_t typeId, uint32_t matrixStride = 0) const
+	{
+		const Id& id = lookup(typeId);
+		switch (id.opcode) {
+		case OpTypeInt:
+		case OpTypeFloat:
+			return id.operands[0] / 8;
+		case OpTypeVector:
+			return sizeOf(id.operands[0]) * id.operands[1];
+		case OpTypeMatrix:
+			return (matrixStride != 0 ? matrixStride : sizeOf(id.operands[0])) * id.operands[1];
+		case OpTypeArray: {
+			uint32_t stride = id.arrayStride != 0 ? id.arrayStride : sizeOf(id.operands[0], matrixStride);
+			return stride * constantValue(id.operands[1]);
+		}
+		case OpTypeStruct: {
+			uint32_t size = 0;
+			for (uint32_t member = 0; member < id.operands.size(); member++) {
+				uint32_t offset = member < id.memberOffsets.size() ? id.memberOffsets[member] : size;
+				uint32_t stride = member < id.memberMatrixStrides.size() ? id.memberMatrixStrides[member] : 0;
+				size = std::max(size, offset + sizeOf(id.operands[member], stride));
+			}
+			return size;
+		}
+		}
+		throw std::runtime_error("unsupported type in push constant block!");
+	}
+
+	static VkDescriptorType descriptorType(const Id& type, uint32_t storageClass)
+	{
+		switch (type.opcode) {
+		case OpTypeSampler:
+			return VK_DESCRIPTOR_TYPE_SAMPLER;
+		case OpTypeSampledImage:
+			return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case OpTypeImage: {// ^, Dim, Depth, Arrayed, MS, Sampled, Format
+			uint32_t dim = type.operands[1];
+			uint32_t sampled = type.operands[5];
+			if (dim == DimSubpassData) return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			if (dim == DimBuffer) return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+		case OpTypeStruct:
+			if (storageClass == StorageBuffer || type.bufferBlock) return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			if (storageClass == Uniform) return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			break;
+		}
+		return VK_DESCRIPTOR_TYPE_MAX_ENUM;// ΉĂȂ(CAEgɂ͊܂߂Ȃ)
+	}
+
+	static VkShaderStageFlags stageFromExecutionModel(uint32_t model)
+	{
+		switch (model) {
+		case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+		return 0;
+	}
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/*** 1  1 ̃bNt[ȃL[ ***/
+// ރXbhƓǂݏoXbhꂼ 1 ̂ƂɎgOobt@B
+// Œ蒷Ȃ̂Ŋmۂ͂Aς̂Ƃ push() ͎s(҂Ȃ)B
+//   SpscQueue<InputEvent, 1024> queue;
+//   queue.push(event);                // ރXbh
+//   InputEvent event;
+//   while (queue.pop(&event)) { ... } // ǂݏoXbh
+
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SpscQueue only holds trivially copyable types");
+	static_assert(0 < Capacity && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+private:
+	static constexpr size_t CACHE_LINE = 64;
+
+	// ޑƓǂݏoLbVC荇Ȃ悤ɗ
+	alignas(CACHE_LINE) std::atomic<uint64_t> head_{ 0 };// ɓǂݏoʒu(ǂݏo)
+	alignas(CACHE_LINE) std::atomic<uint64_t> tail_{ 0 };// ɏވʒu(ޑ)
+	alignas(CACHE_LINE) T items_[Capacity];
+
+public:
+	// ރXbhĂԁBςȂ false
+	bool push(const T& item)
+	{
+		uint64_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) == Capacity) return false;
+		items_[tail & (Capacity - 1)] = item;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// ǂݏoXbhĂԁBȂ false
+	bool pop(T* item)
+	{
+		uint64_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire)) return false;
+		*item = items_[head & (Capacity - 1)];
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// ǂݏoXbhĂԁB擪oɌ(Ȃ nullptr)
+	const T* peek() const
+	{
+		uint64_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire)) return nullptr;
+		return &items_[head & (Capacity - 1)];
+	}
+
+	// ǂ̃XbhĂł悢AĂ񂾌ɕςĂ邩Ȃ
+	size_t size() const
+	{
+		return static_cast<size_t>(tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire));
+	}
+
+	bool empty() const { return size() == 0; }
+
+	static constexpr size_t capacity() { return Capacity; }
+};
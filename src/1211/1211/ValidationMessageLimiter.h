@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*** ؃C[̃bZ[W̊Ԉ ***/
+// xt[ʂɏoƁA\Ńt[[gĂ܂B
+// messageIdNumber Ƃ 1 t[ɕ\鐔𐧌A𐔂ĂāA
+// Iɂ܂Ƃ߂ĕ\BR[obN͂ǂ̃XbhĂ΂ꂤ̂ŃbNB
+
+class ValidationMessageLimiter
+{
+private:
+	struct MessageStats
+	{
+		std::string idName;
+		VkDebugUtilsMessageSeverityFlagBitsEXT severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+		uint64_t total = 0;			// ܂ł̌
+		uint64_t suppressed = 0;	// \Ȃ
+		uint32_t thisFrame = 0;		// ̃t[ł̌
+		uint32_t peakPerFrame = 0;	// 1 t[ł̍ő匏
+		uint64_t framesSeen = 0;	// ot[̐
+	};
+
+	uint32_t maxPerFrame_;			// 1  ID ɂ 1 t[ɕ\鐔
+	uint64_t frame_ = 0;
+	uint64_t suppressedThisFrame_ = 0;
+
+	std::mutex mutex_;
+	std::unordered_map<int32_t, MessageStats> stats_;
+
+public:
+	explicit ValidationMessageLimiter(uint32_t maxPerFrame = 3) : maxPerFrame_(maxPerFrame) {}
+
+	// bZ[W𐔂A\Ă悢Ԃ
+	bool accept(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT* data)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		MessageStats& stats = stats_[data->messageIdNumber];
+		if (stats.total == 0 && data->pMessageIdName != nullptr) stats.idName = data->pMessageIdName;
+		stats.severity = std::max(stats.severity, severity);
+		stats.total++;
+		if (stats.thisFrame++ == 0) stats.framesSeen++;
+		stats.peakPerFrame = std::max(stats.peakPerFrame, stats.thisFrame);
+
+		if (maxPerFrame_ < stats.thisFrame) {
+			stats.suppressed++;
+			suppressedThisFrame_++;
+			return false;
+		}
+		return true;
+	}
+
+	// t[̏IɌĂԁBԈ 1 s񍐂
+	void endFrame(std::ostream& out)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (0 < suppressedThisFrame_) {
+			out << "validation layer: " << suppressedThisFrame_ << " repeated message(s) suppressed in frame " << frame_ << std::endl;
+		}
+		for (auto& [id, stats] : stats_) stats.thisFrame = 0;
+		suppressedThisFrame_ = 0;
+		frame_++;
+	}
+
+	// ID Ƃ𑽂̌ɕ\
+	void printSummary(std::ostream& out)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (stats_.empty()) return;
+
+		std::vector<std::pair<int32_t, const MessageStats*>> sorted;
+		for (const auto& [id, stats] : stats_) sorted.emplace_back(id, &stats);
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return b.second->total < a.second->total; });
+
+		out << "validation message summary (" << frame_ << " frames)" << std::endl;
+		out << "        id      total suppressed  peak/frame     frames  name" << std::endl;
+		for (const auto& [id, stats] : sorted) {
+			out << std::setw(10) << id
+				<< std::setw(11) << stats->total
+				<< std::setw(11) << stats->suppressed
+				<< std::setw(12) << stats->peakPerFrame
+				<< std::setw(11) << stats->framesSeen
+				<< "  " << (stats->idName.empty() ? "-" : stats->idName) << std::endl;
+		}
+	}
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <functional>
+#include <utility>
+
+/*** nh̏L ***/
+// vkCreate* ōnhAXR[v𔲂Ƃɔj(Rs[͂łA[uł)B
+// j֐(vkDestroyBuffer Ȃ)͍쐬ɓnBg̊֐(vkGetInstanceProcAddr Ŏ擾)nB
+//   UniqueHandle<VkDevice, VkBuffer> buffer(device, handle, vkDestroyBuffer);
+
+// foCXCX^Xɑnh
+template <typename Owner, typename Handle>
+class UniqueHandle
+{
+public:
+	using DestroyFunction = void (VKAPI_PTR*)(Owner, Handle, const VkAllocationCallbacks*);
+
+private:
+	Owner owner_ = VK_NULL_HANDLE;
+	Handle handle_ = VK_NULL_HANDLE;
+	DestroyFunction destroy_ = nullptr;
+
+public:
+	UniqueHandle() = default;
+	UniqueHandle(Owner owner, Handle handle, DestroyFunction destroy) : owner_(owner), handle_(handle), destroy_(destroy) {}
+	~UniqueHandle() { reset(); }
+
+	UniqueHandle(const UniqueHandle&) = delete;
+	UniqueHandle& operator=(const UniqueHandle&) = delete;
+
+	UniqueHandle(UniqueHandle&& other) noexcept
+		: owner_(other.owner_), handle_(other.release()), destroy_(other.destroy_) {}
+
+	UniqueHandle& operator=(UniqueHandle&& other) noexcept
+	{
+		if (this != &other) {
+			reset();
+			owner_ = other.owner_;
+			destroy_ = other.destroy_;
+			handle_ = other.release();
+		}
+		return *this;
+	}
+
+	Handle get() const { return handle_; }
+	Owner owner() const { return owner_; }
+	DestroyFunction destroyFunction() const { return destroy_; }
+	explicit operator bool() const { return handle_ != VK_NULL_HANDLE; }
+
+	// L(j͌Ăяo̐ӔCɂȂ)
+	Handle release()
+	{
+		Handle handle = handle_;
+		handle_ = VK_NULL_HANDLE;
+		return handle;
+	}
+
+	// ɔj(GPU gĂȂƂmȂƂBłȂ DeletionQueue ɓn)
+	void reset()
+	{
+		if (handle_ != VK_NULL_HANDLE && destroy_ != nullptr) destroy_(owner_, handle_, nullptr);
+		handle_ = VK_NULL_HANDLE;
+	}
+};
+
+// eȂnh(VkInstance, VkDevice)
+template <typename Handle>
+class UniqueRootHandle
+{
+public:
+	using DestroyFunction = void (VKAPI_PTR*)(Handle, const VkAllocationCallbacks*);
+
+private:
+	Handle handle_ = VK_NULL_HANDLE;
+	DestroyFunction destroy_ = nullptr;
+
+public:
+	UniqueRootHandle() = default;
+	UniqueRootHandle(Handle handle, DestroyFunction destroy) : handle_(handle), destroy_(destroy) {}
+	~UniqueRootHandle() { reset(); }
+
+	UniqueRootHandle(const UniqueRootHandle&) = delete;
+	UniqueRootHandle& operator=(const UniqueRootHandle&) = delete;
+
+	UniqueRootHandle(UniqueRootHandle&& other) noexcept : handle_(other.release()), destroy_(other.destroy_) {}
+
+	UniqueRootHandle& operator=(UniqueRootHandle&& other) noexcept
+	{
+		if (this != &other) {
+			reset();
+			destroy_ = other.destroy_;
+			handle_ = other.release();
+		}
+		return *this;
+	}
+
+	Handle get() const { return handle_; }
+	explicit operator bool() const { return handle_ != VK_NULL_HANDLE; }
+
+	Handle release()
+	{
+		Handle handle = handle_;
+		handle_ = VK_NULL_HANDLE;
+		return handle;
+	}
+
+	void reset()
+	{
+		if (handle_ != VK_NULL_HANDLE && destroy_ != nullptr) destroy_(handle_, nullptr);
+		handle_ = VK_NULL_HANDLE;
+	}
+};
+
+using UniqueInstance = UniqueRootHandle<VkInstance>;
+using UniqueDevice = UniqueRootHandle<VkDevice>;
+using UniqueDebugMessenger = UniqueHandle<VkInstance, VkDebugUtilsMessengerEXT>;
+using UniquePipelineCache = UniqueHandle<VkDevice, VkPipelineCache>;
+using UniquePipeline = UniqueHandle<VkDevice, VkPipeline>;
+using UniquePipelineLayout = UniqueHandle<VkDevice, VkPipelineLayout>;
+using UniqueDescriptorSetLayout = UniqueHandle<VkDevice, VkDescriptorSetLayout>;
+using UniqueDescriptorPool = UniqueHandle<VkDevice, VkDescriptorPool>;
+using UniqueShaderModule = UniqueHandle<VkDevice, VkShaderModule>;
+using UniqueBuffer = UniqueHandle<VkDevice, VkBuffer>;
+using UniqueImage = UniqueHandle<VkDevice, VkImage>;
+using UniqueImageView = UniqueHandle<VkDevice, VkImageView>;
+using UniqueDeviceMemory = UniqueHandle<VkDevice, VkDeviceMemory>;// j֐ vkFreeMemory
+using UniqueCommandPool = UniqueHandle<VkDevice, VkCommandPool>;
+using UniqueSemaphore = UniqueHandle<VkDevice, VkSemaphore>;
+using UniqueFence = UniqueHandle<VkDevice, VkFence>;
+
+/*** xjL[ ***/
+// GPU gĂ邩ȂIuWFNgȀIƂ킩܂ŔjɗaB
+// aƂɁu̒l܂ GPU ̏i߂ΔjĂ悢vƂl(t[ԍ^CC̒l)tA
+// collect() ɊlnƁA܂ł̂̂jBvkDeviceWaitIdle Ńt[~߂KvȂB
+// l͑ĂɗaO(ԂOサꍇ́AÔ̂jł܂Ō̂̂҂̂ŁAjɂ͂ȂȂ)B
+class DeletionQueue
+{
+private:
+	struct Entry
+	{
+		uint64_t retireValue;
+		std::function<void()> destroy;
+	};
+
+	std::deque<Entry> entries_;
+
+public:
+	DeletionQueue() = default;
+	~DeletionQueue() { flush(); }// 傪 GPU ̊҂Ăj邱
+
+	DeletionQueue(const DeletionQueue&) = delete;
+	DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+	// retireValue ܂ŏi񂾂 destroy Ă
+	void defer(uint64_t retireValue, std::function<void()> destroy)
+	{
+		entries_.push_back({ retireValue, std::move(destroy) });
+	}
+
+	template <typename Owner, typename Handle>
+	void defer(uint64_t retireValue, UniqueHandle<Owner, Handle>&& handle)
+	{
+		if (!handle) return;
+		Owner owner = handle.owner();
+		auto destroy = handle.destroyFunction();
+		Handle raw = handle.release();
+		defer(retireValue, [owner, raw, destroy]() { destroy(owner, raw, nullptr); });
+	}
+
+	// completedValue ܂ŏÎjAjԂ
+	size_t collect(uint64_t completedValue)
+	{
+		size_t count = 0;
+		while (!entries_.empty() && entries_.front().retireValue <= completedValue) {
+			Entry entry = std::move(entries_.front());
+			entries_.pop_front();
+			entry.destroy();
+			count++;
+		}
+		return count;
+	}
+
+	// SĔj(vkDeviceWaitIdle ̌ȂǁAGPU gĂȂƂɌĂ)
+	void flush()
+	{
+		while (!entries_.empty()) {
+			Entry entry = std::move(entries_.front());
+			entries_.pop_front();
+			entry.destroy();
+		}
+	}
+
+	size_t size() const { return entries_.size(); }
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*** 풓郏[J[Xbh ***/
+// run() ɓn taskCount ̃^XNA[J[ƌĂяoXbhŕĎsASďI܂ő҂B
+// Xbh͍ŏɍ̂g(ĂԂтɍƁAׂł͂̎Ԃ̕傫Ȃ)B
+// ^XNÓAŏ 1  run() 瓊Brun() ͓ 1 ̃Xbh炾ĂԂƁB
+//   pool.run(chunkCount, [&](size_t chunk) { ... });
+
+class WorkerPool
+{
+private:
+	std::vector<std::thread> workers_;
+
+	std::mutex mutex_;
+	std::condition_variable started_;
+	std::condition_variable finished_;
+	uint64_t generation_ = 0;		// run() ̂тɑ₵ă[J[N
+	bool stopping_ = false;
+	size_t activeWorkers_ = 0;		//  run() ̃^XNɗĂāA܂߂ĂȂ[J[
+
+	const std::function<void(size_t)>* task_ = nullptr;
+	size_t taskCount_ = 0;
+	std::atomic<size_t> nextTask_{ 0 };
+	std::exception_ptr error_;
+
+public:
+	// threadCount ͌ĂяoXbh܂߂(0 Ȃn[hEFÃXbh)
+	explicit WorkerPool(size_t threadCount = 0)
+	{
+		if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+		for (size_t i = 1; i < threadCount; i++) {
+			workers_.emplace_back([this]() { work(); });
+		}
+	}
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		started_.notify_all();
+		for (std::thread& worker : workers_) worker.join();
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	size_t threadCount() const { return workers_.size() + 1; }
+
+	void run(size_t taskCount, const std::function<void(size_t)>& task)
+	{
+		if (taskCount == 0) return;
+		// 1 ȂXbhN܂łȂ
+		if (taskCount == 1 || workers_.empty()) {
+			for (size_t i = 0; i < taskCount; i++) task(i);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			task_ = &task;
+			taskCount_ = taskCount;
+			nextTask_ = 0;
+			error_ = nullptr;
+			generation_++;
+		}
+		started_.notify_all();
+
+		execute();
+
+		std::exception_ptr error;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			finished_.wait(lock, [this]() { return activeWorkers_ == 0; });
+			task_ = nullptr;
+			error = error_;
+		}
+		if (error) std::rethrow_exception(error);
+	}
+
+private:
+	void work()
+	{
+		uint64_t seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				started_.wait(lock, [&]() { return stopping_ || generation_ != seen; });
+				if (stopping_) return;
+				seen = generation_;
+				activeWorkers_++;
+			}
+
+			execute();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				activeWorkers_--;
+			}
+			finished_.notify_one();
+		}
+	}
+
+	// ^XNȂ܂ŎĎs
+	void execute()
+	{
+		for (;;) {
+			size_t index = nextTask_.fetch_add(1);
+			if (taskCount_ <= index) return;
+			try {
+				(*task_)(index);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (!error_) error_ = std::current_exception();
+			}
+		}
+	}
+};
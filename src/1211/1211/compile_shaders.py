@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""シェーダー(GLSL / HLSL)を SPIR-V にコンパイルする。
+
+    python compile_shaders.py <シェーダーのフォルダ> <出力フォルダ> [--debug] [--jobs N]
+
+- GLSL は拡張子でステージを決める(.vert .frag .comp .geom .tesc .tese)。
+  HLSL は <名前>.<ステージ>.hlsl とする(例: blur.comp.hlsl)。エントリーポイントは main。
+  出力は <出力フォルダ>/<名前>.<ステージ>.spv(同じ名前の GLSL と HLSL は置かないこと)。
+- シェーダーに「// variant: <派生名> <マクロ>[=<値>] ...」の行があれば、マクロを定義した派生版も
+  <名前>.<派生名>.<ステージ>.spv にコンパイルする(特殊化定数では切り替えられない機能の有無に使う)。
+- #include をたどって依存ファイルを集め、全ての内容とコンパイラ・オプションからハッシュを作る。
+  同じハッシュの結果がキャッシュ(<シェーダーのフォルダ>/.cache)にあればコンパイルしない。
+- --debug でなければ spirv-opt -O で最適化する(spirv-opt が無ければしない)。
+- 複数のシェーダーは CPU のコア数だけ並列にコンパイルする。
+- コンパイラは環境変数 GLSLANG_VALIDATOR / SPIRV_OPT、VULKAN_SDK の Bin、PATH の順に探す。
+"""
+
+import argparse
+import concurrent.futures
+import hashlib
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+GLSL_STAGES = {".vert": "vert", ".frag": "frag", ".comp": "comp", ".geom": "geom", ".tesc": "tesc", ".tese": "tese"}
+INCLUDE_PATTERN = re.compile(r'^\s*#\s*include\s+["<]([^">]+)[">]', re.MULTILINE)
+VARIANT_PATTERN = re.compile(r'^\s*//\s*variant:\s*(\w+)((?:[ \t]+\w+(?:=\S+)?)*)[ \t]*$', re.MULTILINE)
+CACHE_VERSION = "1"  # キャッシュの形式を変えたら上げる
+
+
+def find_tool(name, env_name):
+    path = os.environ.get(env_name)
+    if path:
+        return path
+    sdk = os.environ.get("VULKAN_SDK")
+    if sdk:
+        for directory in ("Bin", "bin"):
+            for candidate in (name + ".exe", name):
+                path = os.path.join(sdk, directory, candidate)
+                if os.path.isfile(path):
+                    return path
+    return shutil.which(name)
+
+
+def tool_version(tool):
+    if tool is None:
+        return "none"
+    try:
+        result = subprocess.run([tool, "--version"], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, timeout=30)
+        return result.stdout.decode("utf-8", "replace").strip()
+    except (OSError, subprocess.SubprocessError):
+        return tool
+
+
+def shader_stage(path):
+    name = os.path.basename(path)
+    root, ext = os.path.splitext(name)
+    if ext in GLSL_STAGES:
+        return GLSL_STAGES[ext], False
+    if ext == ".hlsl":
+        stage = os.path.splitext(root)[1]
+        if stage in GLSL_STAGES:
+            return GLSL_STAGES[stage], True
+    return None, False
+
+
+def find_sources(source_dir):
+    sources = []
+    for directory, subdirectories, files in os.walk(source_dir):
+        subdirectories[:] = [d for d in subdirectories if not d.startswith(".") and d != "bin"]
+        for name in files:
+            path = os.path.join(directory, name)
+            if shader_stage(path)[0] is not None:
+                sources.append(path)
+    return sorted(sources)
+
+
+def find_variants(path):
+    """(派生名, マクロの一覧) の一覧を返す。派生の無い元のシェーダーは (None, [])。"""
+    with open(path, "rb") as file:
+        text = file.read().decode("utf-8", "replace")
+    variants = [(None, [])]
+    for name, defines in VARIANT_PATTERN.findall(text):
+        variants.append((name, defines.split()))
+    return variants
+
+
+def collect_dependencies(path, include_dirs):
+    """path と、#include でたどれる全てのファイルを返す。見つからない include は例外にする。"""
+    found = []
+    visited = set()
+    stack = [os.path.abspath(path)]
+    while stack:
+        current = stack.pop()
+        if current in visited:
+            continue
+        visited.add(current)
+        found.append(current)
+        with open(current, "rb") as file:
+            text = file.read().decode("utf-8", "replace")
+        for name in INCLUDE_PATTERN.findall(text):
+            for directory in [os.path.dirname(current)] + include_dirs:
+                candidate = os.path.abspath(os.path.join(directory, name))
+                if os.path.isfile(candidate):
+                    stack.append(candidate)
+                    break
+            else:
+                raise RuntimeError("%s: cannot find include file '%s'" % (current, name))
+    return sorted(found)
+
+
+def cache_key(dependencies, options, source_dir):
+    digest = hashlib.sha256()
+    digest.update(CACHE_VERSION.encode())
+    for option in options:
+        digest.update(b"\0" + option.encode())
+    for dependency in dependencies:
+        digest.update(b"\0" + os.path.relpath(dependency, source_dir).replace("\\", "/").encode())
+        with open(dependency, "rb") as file:
+            digest.update(hashlib.sha256(file.read()).digest())
+    return digest.hexdigest()
+
+
+def replace_file(source, destination):
+    """destination を途中の状態で読まれないように、一時ファイルから置き換える。"""
+    directory = os.path.dirname(destination)
+    handle, temporary = tempfile.mkstemp(dir=directory, suffix=".tmp")
+    os.close(handle)
+    shutil.copyfile(source, temporary)
+    os.replace(temporary, destination)
+
+
+def compile_shader(path, variant, defines, args, tools, include_dirs):
+    stage, hlsl = shader_stage(path)
+    relative = os.path.relpath(path, args.source_dir)
+    # 出力は <名前>.<ステージ>.spv(blur.comp → blur.comp.spv, blur.comp.hlsl → blur.comp.spv)
+    # 派生は <名前>.<派生名>.<ステージ>.spv(blur.comp → blur.subgroup.comp.spv)
+    relative = os.path.splitext(relative)[0] if hlsl else relative
+    if variant is not None:
+        root, ext = os.path.splitext(relative)
+        relative = "%s.%s%s" % (root, variant, ext)
+    output = os.path.join(args.output_dir, relative + ".spv")
+
+    command = [tools["glslang"], "-V", "--target-env", "vulkan1.1", "-S", stage]
+    if hlsl:
+        command += ["-D", "-e", "main"]
+    command += ["-D" + define for define in defines]
+    if args.debug:
+        command += ["-g"]
+    command += ["-I" + directory for directory in include_dirs]
+    optimize = not args.debug and tools["spirv-opt"] is not None
+
+    dependencies = collect_dependencies(path, include_dirs)
+    options = [tools["glslang-version"], tools["spirv-opt-version"] if optimize else "no-opt"] + command[1:]
+    key = cache_key(dependencies, options, args.source_dir)
+    cached = os.path.join(args.cache_dir, key + ".spv")
+
+    os.makedirs(os.path.dirname(output), exist_ok=True)
+    if os.path.isfile(cached):
+        if not os.path.isfile(output) or not same_content(cached, output):
+            replace_file(cached, output)
+        return relative, "cached", ""
+
+    with tempfile.TemporaryDirectory() as work:
+        compiled = os.path.join(work, "out.spv")
+        result = subprocess.run(command + ["-o", compiled, path], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        if result.returncode != 0:
+            return relative, "failed", result.stdout.decode("utf-8", "replace")
+
+        if optimize:
+            optimized = os.path.join(work, "opt.spv")
+            result = subprocess.run([tools["spirv-opt"], "-O", compiled, "-o", optimized], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+            if result.returncode != 0:
+                return relative, "failed", result.stdout.decode("utf-8", "replace")
+            compiled = optimized
+
+        replace_file(compiled, cached)
+        replace_file(compiled, output)
+    return relative, "compiled", ""
+
+
+def same_content(a, b):
+    with open(a, "rb") as file_a, open(b, "rb") as file_b:
+        return file_a.read() == file_b.read()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile GLSL/HLSL shaders to SPIR-V with a content-addressed cache.")
+    parser.add_argument("source_dir")
+    parser.add_argument("output_dir")
+    parser.add_argument("--debug", action="store_true", help="keep debug info and skip spirv-opt")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1)
+    parser.add_argument("--cache-dir", default=None)
+    args = parser.parse_args()
+
+    args.source_dir = os.path.abspath(args.source_dir)
+    args.output_dir = os.path.abspath(args.output_dir)
+    args.cache_dir = os.path.abspath(args.cache_dir or os.path.join(args.source_dir, ".cache"))
+
+    sources = find_sources(args.source_dir) if os.path.isdir(args.source_dir) else []
+    if not sources:
+        return 0
+
+    tools = {
+        "glslang": find_tool("glslangValidator", "GLSLANG_VALIDATOR"),
+        "spirv-opt": find_tool("spirv-opt", "SPIRV_OPT"),
+    }
+    if tools["glslang"] is None:
+        print("error: glslangValidator not found (set VULKAN_SDK or GLSLANG_VALIDATOR)", file=sys.stderr)
+        return 1
+    tools["glslang-version"] = tool_version(tools["glslang"])
+    tools["spirv-opt-version"] = tool_version(tools["spirv-opt"])
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    os.makedirs(args.cache_dir, exist_ok=True)
+    include_dirs = [os.path.join(args.source_dir, "include")]
+
+    failed = 0
+    with concurrent.futures.ThreadPoolExecutor(max_workers=max(1, args.jobs)) as executor:
+        futures = []
+        for path in sources:
+            try:
+                variants = find_variants(path)
+            except OSError as error:
+                print("error: %s" % error, file=sys.stderr)
+                failed += 1
+                continue
+            for variant, defines in variants:
+                futures.append(executor.submit(compile_shader, path, variant, defines, args, tools, include_dirs))
+        for future in futures:
+            try:
+                name, status, log = future.result()
+            except (OSError, RuntimeError) as error:
+                print("error: %s" % error, file=sys.stderr)
+                failed += 1
+                continue
+            if status == "failed":
+                print("error: %s\n%s" % (name, log), file=sys.stderr)
+                failed += 1
+            elif status == "compiled":
+                print("shader: %s" % name)
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,14 +1,80 @@
 #include <iostream>
+#include <cstring>
+#include <string>
+#define ALLOCATION_COUNTER_IMPLEMENTATION// u operator new ̖͂|PʂŒ`
+#include "AllocationCounter.h"
 #include "MyApplication.h"
+#include "FrameReplay.h"
 
-int main()
+// Lv`t[EBhEȂōĎsAR}hƂ̎Ԃ\
+static int replay(const char* path)
+{
+	FrameCaptureReader capture;
+	capture.load(path);
+
+	FrameReplayer replayer;
+	replayer.replay(capture);
+	replayer.printReport(std::cout);
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
 {
 
 	MyApplication app;
 
 	try 
 	{
+		// g:
+		//   --replay <file>                   Lv`̍Ďs
+		//   --capture <file> <first> <count>  first t[ڂ count t[L^
+		//   --perf-baseline <file>            x[XCɖptH[}Xxo玸sɂ
+		//   --bench-compute [count]           vZv~eBuƃCg̐U蕪̃x`}[N(EBhEȂ)
+		//   --alloc-check <frames>            frames t[̊ԁA`悩V~[ṼXbhq[vmۂ玸sɂ
+		//   --dump-devices <file>             SĂ̕foCX̏ JSON ɏo
+		//   --replay-devices <file>           oŃfoCX̑IƐݒ̌(GPU sv)
+		//   --fast-start                      ŏ̃t[𑁂o(foCX̗pӂEBhEƕsApCvC͗ō)
+		if (argc == 3 && strcmp(argv[1], "--replay") == 0) {
+			return replay(argv[2]);
+		}
+		if (argc == 3 && strcmp(argv[1], "--dump-devices") == 0) {
+			app.dumpDeviceSnapshots(argv[2]);
+			return EXIT_SUCCESS;
+		}
+		if (argc == 3 && strcmp(argv[1], "--replay-devices") == 0) {
+			return MyApplication::replayDeviceSnapshots(argv[2], std::cout) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		if (2 <= argc && argc <= 3 && strcmp(argv[1], "--bench-compute") == 0) {
+			size_t count = argc == 3 ? std::stoull(argv[2]) : 1 << 22;
+			if (count == 0) throw std::runtime_error("element count must be positive!");
+			return app.runComputeBenchmark(count, 10) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		for (int i = 1; i < argc; i++) {
+			if (strcmp(argv[i], "--capture") == 0 && i + 3 < argc) {
+				app.enableCapture(argv[i + 1], std::stoull(argv[i + 2]), std::stoull(argv[i + 3]));
+				i += 3;
+			}
+			else if (strcmp(argv[i], "--perf-baseline") == 0 && i + 1 < argc) {
+				app.enablePerformanceGate(argv[i + 1]);
+				i += 1;
+			}
+			else if (strcmp(argv[i], "--alloc-check") == 0 && i + 1 < argc) {
+				app.enableAllocationCheck(std::stoull(argv[i + 1]));
+				i += 1;
+			}
+			else if (strcmp(argv[i], "--fast-start") == 0) {
+				app.enableFastStart();
+			}
+			else {
+				throw std::runtime_error(std::string("unknown option: ") + argv[i]);
+			}
+		}
+
 		app.run();
+
+		if (!app.checkPerformanceGate()) return EXIT_FAILURE;
+		if (!app.checkAllocations()) return EXIT_FAILURE;
 	}
 	catch (const std::exception & e)
 	{
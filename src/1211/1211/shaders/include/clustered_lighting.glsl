@@ -0,0 +1,64 @@
+// クラスター化したライティング共通: 視錐台の分け方(クラスター)とライトの形式
+// 視錐台を画面で CLUSTER_TILES_X × CLUSTER_TILES_Y のタイルに、奥行きで CLUSTER_SLICES 枚(指数的に厚くなる)に分ける。
+// 値は ClusteredLighting.h の LightClusterGrid と同じにすること。
+// 座標はビュー空間(カメラが原点、+z が前、+y が上)。
+//
+// フラグメントシェーダーでは、cluster_lights.comp が書いたバッファを次のように引く:
+//   uint cluster = clusterIndex(gl_FragCoord.xy, viewportSize, viewPosition.z, grid);
+//   uint count = min(clusterCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+//   for (uint i = 0; i < count; i++) {
+//       ClusterLight light = lights[clusterIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+//       color += light.color * light.intensity * lightAttenuation(light, viewPosition) * ...;
+//   }
+
+#define CLUSTER_TILES_X 16u
+#define CLUSTER_TILES_Y 9u
+#define CLUSTER_SLICES 24u
+#define CLUSTER_COUNT (CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES)
+#define MAX_LIGHTS_PER_CLUSTER 128u
+
+// ビュー空間の点光源(std430 で 32 バイト)
+struct ClusterLight
+{
+	vec3 position;
+	float radius;
+	vec3 color;
+	float intensity;
+};
+
+// 視錐台の形(ClusterParameters の先頭と同じ)
+struct ClusterGrid
+{
+	float tanHalfFovX;
+	float tanHalfFovY;
+	float nearZ;
+	float farZ;
+};
+
+// slice 枚目の手前の面の距離(slice が CLUSTER_SLICES なら farZ)
+float clusterSliceDepth(uint slice, ClusterGrid grid)
+{
+	return grid.nearZ * pow(grid.farZ / grid.nearZ, float(slice) / float(CLUSTER_SLICES));
+}
+
+uint clusterSlice(float viewZ, ClusterGrid grid)
+{
+	float slice = log(viewZ / grid.nearZ) / log(grid.farZ / grid.nearZ) * float(CLUSTER_SLICES);
+	return uint(clamp(slice, 0.0, float(CLUSTER_SLICES - 1u)));
+}
+
+// cluster = (slice * CLUSTER_TILES_Y + タイルの行) * CLUSTER_TILES_X + タイルの列(行 0 が画面の上)
+uint clusterIndex(vec2 fragCoord, vec2 viewportSize, float viewZ, ClusterGrid grid)
+{
+	uvec2 tile = min(uvec2(fragCoord / viewportSize * vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y)),
+		uvec2(CLUSTER_TILES_X - 1u, CLUSTER_TILES_Y - 1u));
+	return (clusterSlice(viewZ, grid) * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x;
+}
+
+// 距離による減衰(radius で滑らかに 0 になる)
+float lightAttenuation(ClusterLight light, vec3 viewPosition)
+{
+	float distanceSquared = dot(light.position - viewPosition, light.position - viewPosition);
+	float window = clamp(1.0 - distanceSquared / (light.radius * light.radius), 0.0, 1.0);
+	return window * window / (1.0 + distanceSquared);
+}
@@ -0,0 +1,107 @@
+// 計算プリミティブ共通: 特殊化定数とワークグループ内の加算(総和・スキャン)
+// USE_SUBGROUP を定義した派生(compile_shaders.py の variant)はサブグループ演算を使う。
+// サブグループ演算は SPIR-V の Capability になり、対応していないデバイスではパイプラインを作れないので、
+// 特殊化定数ではなく別の SPIR-V にしている。
+// どちらもワークグループの全ての呼び出しから、同じ制御フローで呼ぶこと(中で barrier() を使う)。
+
+#ifdef USE_SUBGROUP
+#extension GL_KHR_shader_subgroup_basic : require
+#extension GL_KHR_shader_subgroup_vote : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+#endif
+
+// ワークグループの大きさ(constant_id = 0)と、1 呼び出しが受け持つ要素数(constant_id = 1)は
+// デバイスのサブグループの大きさに合わせて GpuCompute が決める
+layout(local_size_x_id = 0) in;
+layout(constant_id = 1) const uint ITEMS_PER_INVOCATION = 4;
+
+#define WORKGROUP_SIZE gl_WorkGroupSize.x
+#define BLOCK_SIZE (WORKGROUP_SIZE * ITEMS_PER_INVOCATION)// 1 ワークグループが受け持つ要素数
+
+shared uint workgroupPartials_[WORKGROUP_SIZE];
+shared uint workgroupTotal_;
+
+#ifdef USE_SUBGROUP
+
+// サブグループごとの和を workgroupPartials_ に置き、最初のサブグループでそれを足し合わせる
+uint workgroupAdd(uint value)
+{
+	uint sum = subgroupAdd(value);
+	if (subgroupElect()) workgroupPartials_[gl_SubgroupID] = sum;
+	barrier();
+	if (gl_SubgroupID == 0) {
+		uint total = 0;
+		for (uint first = 0; first < gl_NumSubgroups; first += gl_SubgroupSize) {
+			uint index = first + gl_SubgroupInvocationID;
+			total += subgroupAdd(index < gl_NumSubgroups ? workgroupPartials_[index] : 0);
+		}
+		if (subgroupElect()) workgroupTotal_ = total;
+	}
+	barrier();
+	uint result = workgroupTotal_;
+	barrier();
+	return result;
+}
+
+// 自分より前の呼び出しの value の和を返し、total に全体の和を入れる
+uint workgroupExclusiveAdd(uint value, out uint total)
+{
+	uint inclusive = subgroupInclusiveAdd(value);
+	uint sum = subgroupAdd(value);
+	if (subgroupElect()) workgroupPartials_[gl_SubgroupID] = sum;
+	barrier();
+	if (gl_SubgroupID == 0) {
+		// サブグループの和を排他的スキャンして、各サブグループの開始位置にする
+		uint carry = 0;
+		for (uint first = 0; first < gl_NumSubgroups; first += gl_SubgroupSize) {
+			uint index = first + gl_SubgroupInvocationID;
+			uint partial = index < gl_NumSubgroups ? workgroupPartials_[index] : 0;
+			uint scanned = subgroupInclusiveAdd(partial);
+			if (index < gl_NumSubgroups) workgroupPartials_[index] = carry + scanned - partial;
+			carry += subgroupAdd(partial);
+		}
+		if (subgroupElect()) workgroupTotal_ = carry;
+	}
+	barrier();
+	uint result = workgroupPartials_[gl_SubgroupID] + inclusive - value;
+	total = workgroupTotal_;
+	barrier();
+	return result;
+}
+
+#else
+
+// 共有メモリでの木構造の総和(WORKGROUP_SIZE は 2 のべき乗)
+uint workgroupAdd(uint value)
+{
+	uint index = gl_LocalInvocationID.x;
+	workgroupPartials_[index] = value;
+	barrier();
+	for (uint stride = WORKGROUP_SIZE / 2; 0 < stride; stride >>= 1) {
+		if (index < stride) workgroupPartials_[index] += workgroupPartials_[index + stride];
+		barrier();
+	}
+	uint result = workgroupPartials_[0];
+	barrier();
+	return result;
+}
+
+// 共有メモリでのスキャン(Hillis-Steele)
+uint workgroupExclusiveAdd(uint value, out uint total)
+{
+	uint index = gl_LocalInvocationID.x;
+	workgroupPartials_[index] = value;
+	barrier();
+	for (uint offset = 1; offset < WORKGROUP_SIZE; offset <<= 1) {
+		uint previous = offset <= index ? workgroupPartials_[index - offset] : 0;
+		barrier();
+		workgroupPartials_[index] += previous;
+		barrier();
+	}
+	uint result = workgroupPartials_[index] - value;
+	total = workgroupPartials_[WORKGROUP_SIZE - 1];
+	barrier();
+	return result;
+}
+
+#endif